@@ -0,0 +1,74 @@
+/*
+ * accel.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Accelerometer on the I2C bus, set up to raise INT1 on motion only.
+ */
+
+#include "accel.h"
+#include "i2cbus.h"
+
+/*
+ * The driver cannot read a single byte, the register after it comes
+ * along.
+ */
+uint8_t accel_read_register(uint8_t reg, uint8_t *value) {
+	uint8_t tx = ACCEL_AUTO_INCREMENT | reg, rx[2], res;
+
+	i2cAcquireBus(&I2C_BUS);
+	res = i2c_bus_transfer(ACCEL_I2C_ADDRESS, &tx, 1, rx, sizeof(rx));
+	i2cReleaseBus(&I2C_BUS);
+
+	*value = rx[0];
+
+	return res == I2C_BUS_OK ? ACCEL_OK : ACCEL_ERR_IO;
+}
+
+uint8_t accel_write_register(uint8_t reg, uint8_t value) {
+	uint8_t tx[2], res;
+
+	tx[0] = reg;
+	tx[1] = value;
+
+	i2cAcquireBus(&I2C_BUS);
+	res = i2c_bus_transfer(ACCEL_I2C_ADDRESS, tx, sizeof(tx), NULL, 0);
+	i2cReleaseBus(&I2C_BUS);
+
+	return res == I2C_BUS_OK ? ACCEL_OK : ACCEL_ERR_IO;
+}
+
+/*
+ * Wake-up unit 1 on any axis above the threshold for the duration, on
+ * high-pass filtered data so gravity and a tilted mount do not count.
+ * Not latched: INT1 follows the motion and every new jolt is an edge.
+ */
+uint8_t accel_init_wakeup(uint16_t threshold_mg, uint16_t duration_ms) {
+	uint8_t id, ths = (threshold_mg + ACCEL_THS_STEP_MG / 2) / ACCEL_THS_STEP_MG, dummy;
+
+	if (accel_read_register(ACCEL_WHO_AM_I, &id) != ACCEL_OK)
+		return ACCEL_ERR_IO;
+
+	if (id != ACCEL_ID)
+		return ACCEL_ERR_ID;
+
+	if (ths == 0)
+		ths = 1;
+	else if (ths > 0x7F)
+		ths = 0x7F;
+
+	// 100 Hz, powered, X Y Z on
+	if (accel_write_register(ACCEL_CTRL_REG1, 0x47) != ACCEL_OK ||
+			// High-pass filter on the wake-up unit 1 path
+			accel_write_register(ACCEL_CTRL_REG2, 0x04) != ACCEL_OK ||
+			// INT1 push-pull, active high, from wake-up unit 1
+			accel_write_register(ACCEL_CTRL_REG3, 0x01) != ACCEL_OK ||
+			accel_write_register(ACCEL_FF_WU_THS1, ths) != ACCEL_OK ||
+			accel_write_register(ACCEL_FF_WU_DURATION1, duration_ms / ACCEL_DURATION_STEP_MS) != ACCEL_OK ||
+			// OR of the high events of all axes, not latched
+			accel_write_register(ACCEL_FF_WU_CFG1, 0x2A) != ACCEL_OK)
+		return ACCEL_ERR_IO;
+
+	// Filter starts from the current position
+	return accel_read_register(ACCEL_HP_FILTER_RESET, &dummy);
+}
@@ -0,0 +1,52 @@
+/*
+ * accel.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef ACCEL_H_
+#define ACCEL_H_
+
+#include "ch.h"
+#include "hal.h"
+
+#include <stdint.h>
+
+// LIS302DL on the I2C bus, SDO low
+#if !defined(ACCEL_I2C_ADDRESS)
+#define ACCEL_I2C_ADDRESS		0x1C
+#endif
+
+#define ACCEL_ID				0x3B
+
+// Register names as in os/various/lis302dl.h
+#define ACCEL_WHO_AM_I			0x0F
+#define ACCEL_CTRL_REG1			0x20
+#define ACCEL_CTRL_REG2			0x21
+#define ACCEL_CTRL_REG3			0x22
+#define ACCEL_HP_FILTER_RESET	0x23
+#define ACCEL_FF_WU_CFG1		0x30
+#define ACCEL_FF_WU_SRC1		0x31
+#define ACCEL_FF_WU_THS1		0x32
+#define ACCEL_FF_WU_DURATION1	0x33
+
+// Register address bit that makes the part step through the registers
+#define ACCEL_AUTO_INCREMENT	0x80
+
+// Wake-up threshold step at +-2 g and duration step at 100 Hz
+#define ACCEL_THS_STEP_MG		18
+#define ACCEL_DURATION_STEP_MS	10
+
+typedef enum ACCEL_RESULT {
+	ACCEL_OK				=	0x00,
+	ACCEL_ERR_IO			=	0x01,
+	ACCEL_ERR_ID			=	0x02
+} ACCEL_RESULT;
+
+extern uint8_t accel_read_register(uint8_t reg, uint8_t *value);
+
+extern uint8_t accel_write_register(uint8_t reg, uint8_t value);
+
+extern uint8_t accel_init_wakeup(uint16_t threshold_mg, uint16_t duration_ms);
+
+#endif /* ACCEL_H_ */
@@ -0,0 +1,194 @@
+/*
+ * at.c
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "at.h"
+
+#include <string.h>
+
+EVENTSOURCE_DECL(at_urc_event);
+
+static BaseChannel *at_chp;
+
+static at_line_t at_line;
+
+static at_urc_handler_t at_urc_handlers[AT_URC_COUNT];
+
+// Prefix of the answer the running command waits for, it is not a URC
+static const char *at_pending_prefix;
+
+void at_init(BaseChannel *chp) {
+	at_chp = chp;
+	at_pending_prefix = NULL;
+
+	at_line_init(&at_line);
+}
+
+void at_urc_register(uint8_t urc, at_urc_handler_t handler) {
+	if (urc < AT_URC_COUNT)
+		at_urc_handlers[urc] = handler;
+}
+
+/*
+ * Hands the current line to its URC handler and listeners.
+ * Returns the URC type, AT_URC_NONE for any other line.
+ */
+static uint8_t at_dispatch() {
+	uint8_t urc;
+
+	if (at_pending_prefix != NULL && at_line_starts_with(&at_line, at_pending_prefix))
+		return AT_URC_NONE;
+
+	urc = at_urc_type(&at_line);
+
+	if (urc == AT_URC_NONE)
+		return AT_URC_NONE;
+
+	if (at_urc_handlers[urc] != NULL)
+		at_urc_handlers[urc](&at_line);
+
+	chEvtBroadcastFlags(&at_urc_event, AT_URC_EVENT(urc));
+
+	return urc;
+}
+
+/*
+ * Dispatches the URCs that arrived while no command was running, other
+ * leftovers are dropped. Never blocks, returns the number of URCs.
+ */
+uint8_t at_poll() {
+	uint8_t count = 0;
+	msg_t c;
+
+	while ((c = chIOGetTimeout(at_chp, TIME_IMMEDIATE)) >= 0) {
+		if (at_line_put(&at_line, (uint8_t)c) != AT_LINE_COMPLETE)
+			continue;
+
+		if (at_dispatch() != AT_URC_NONE)
+			count++;
+	}
+
+	return count;
+}
+
+void at_write(const uint8_t *data, size_t len) {
+	chIOWriteTimeout(at_chp, data, len, TIME_INFINITE);
+}
+
+/*
+ * Reads modem output until a complete line arrives or the deadline passes.
+ * Returns FALSE on timeout.
+ */
+static uint8_t at_read_line(systime_t start, systime_t timeout) {
+	systime_t elapsed;
+	msg_t c;
+
+	while ((elapsed = chTimeNow() - start) < timeout) {
+		c = chIOGetTimeout(at_chp, timeout - elapsed);
+
+		if (c < 0)
+			continue;
+
+		if (at_line_put(&at_line, (uint8_t)c) == AT_LINE_COMPLETE)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+static void at_copy_line(char *resp, size_t size) {
+	size_t len = at_line.len < size - 1 ? at_line.len : size - 1;
+
+	memcpy(resp, at_line.buf, len);
+	resp[len] = '\0';
+}
+
+/*
+ * Sends cmd and returns as soon as its final result code arrives, timeout
+ * is only an upper bound. The first line starting with prefix is copied
+ * into resp when prefix is not NULL. URCs interleaved with the answer are
+ * dispatched on the way.
+ */
+uint8_t at_cmd_response(const char *cmd, const char *prefix, char *resp, size_t size, systime_t timeout) {
+	systime_t start;
+	uint8_t result = AT_TIMEOUT;
+
+	at_poll();
+
+	if (resp != NULL && size > 0)
+		resp[0] = '\0';
+
+	at_pending_prefix = prefix;
+
+	at_write((const uint8_t *)cmd, strlen(cmd));
+	at_write((const uint8_t *)"\r", 1);
+
+	start = chTimeNow();
+
+	while (at_read_line(start, timeout)) {
+		if (at_dispatch() != AT_URC_NONE)
+			continue;
+
+		result = at_result_code(&at_line);
+
+		if (result != AT_NOT_FINAL)
+			break;
+
+		result = AT_TIMEOUT;
+
+		if (prefix != NULL && resp != NULL && size > 0 && resp[0] == '\0' &&
+				at_line_starts_with(&at_line, prefix))
+			at_copy_line(resp, size);
+	}
+
+	at_pending_prefix = NULL;
+
+	return result;
+}
+
+uint8_t at_cmd(const char *cmd, systime_t timeout) {
+	return at_cmd_response(cmd, NULL, NULL, 0, timeout);
+}
+
+/*
+ * Waits for the given URC, e.g. the indication that follows the OK of an
+ * asynchronous command. Other URCs are dispatched meanwhile.
+ */
+uint8_t at_wait_urc(uint8_t urc, systime_t timeout) {
+	systime_t start = chTimeNow();
+
+	while (at_read_line(start, timeout)) {
+		if (at_dispatch() == urc)
+			return AT_OK;
+	}
+
+	return AT_TIMEOUT;
+}
+
+/*
+ * Leaves online data mode, the modem answers OK once the guard time after
+ * "+++" has passed.
+ */
+uint8_t at_escape() {
+	systime_t start;
+	uint8_t result;
+
+	chThdSleepMilliseconds(AT_ESCAPE_GUARD_MS);
+	at_write((const uint8_t *)"+++", 3);
+
+	start = chTimeNow();
+
+	while (at_read_line(start, MS2ST(AT_ESCAPE_GUARD_MS) + AT_CMD_TIMEOUT)) {
+		if (at_dispatch() != AT_URC_NONE)
+			continue;
+
+		result = at_result_code(&at_line);
+
+		if (result != AT_NOT_FINAL)
+			return result;
+	}
+
+	return AT_TIMEOUT;
+}
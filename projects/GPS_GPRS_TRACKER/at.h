@@ -0,0 +1,52 @@
+/*
+ * at.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef AT_H_
+#define AT_H_
+
+#include "ch.h"
+#include "hal.h"
+
+#include "atparse.h"
+
+// Upper bound for plain commands, the usual answer takes a few ms
+#if !defined(AT_CMD_TIMEOUT)
+#define AT_CMD_TIMEOUT			MS2ST(1000)
+#endif
+
+// Silence required around the "+++" escape sequence
+#if !defined(AT_ESCAPE_GUARD_MS)
+#define AT_ESCAPE_GUARD_MS		1000
+#endif
+
+// Event flags broadcast on at_urc_event, one per AT_URC
+#if !defined(AT_URC_EVENT_BASE)
+#define AT_URC_EVENT_BASE		16
+#endif
+
+#define AT_URC_EVENT(U)			EVENT_MASK(AT_URC_EVENT_BASE + (U))
+
+typedef void (*at_urc_handler_t)(const at_line_t *line);
+
+extern EventSource at_urc_event;
+
+extern void at_init(BaseChannel *chp);
+
+extern void at_urc_register(uint8_t urc, at_urc_handler_t handler);
+
+extern uint8_t at_poll();
+
+extern void at_write(const uint8_t *data, size_t len);
+
+extern uint8_t at_cmd(const char *cmd, systime_t timeout);
+
+extern uint8_t at_cmd_response(const char *cmd, const char *prefix, char *resp, size_t size, systime_t timeout);
+
+extern uint8_t at_wait_urc(uint8_t urc, systime_t timeout);
+
+extern uint8_t at_escape();
+
+#endif /* AT_H_ */
@@ -0,0 +1,135 @@
+/*
+ * atparse.c
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "atparse.h"
+
+#include <string.h>
+
+// Final result codes, a command is complete as soon as one of them arrives
+static const struct {
+	const char *prefix;
+	uint8_t result;
+	uint8_t exact;
+} result_codes[] = {
+	{"OK", AT_OK, 1},
+	{"ERROR", AT_ERROR, 1},
+	{"+CME ERROR:", AT_CME_ERROR, 0},
+	{"+CMS ERROR:", AT_CMS_ERROR, 0},
+	{"CONNECT", AT_CONNECT, 0},
+	{"NO CARRIER", AT_NO_CARRIER, 1},
+	{"BUSY", AT_BUSY, 1},
+	{"NO ANSWER", AT_NO_ANSWER, 1}
+};
+
+static const struct {
+	const char *prefix;
+	uint8_t urc;
+} urc_codes[] = {
+	{"+WIPREADY:", AT_URC_WIPREADY},
+	{"+WIPPEERCLOSE:", AT_URC_WIPPEERCLOSE},
+	{"+CREG:", AT_URC_CREG},
+	{"+CGREG:", AT_URC_CGREG},
+	{"RING", AT_URC_RING}
+};
+
+void at_line_init(at_line_t *line) {
+	line->len = 0;
+	line->complete = 0;
+	line->buf[0] = '\0';
+}
+
+uint8_t at_line_put(at_line_t *line, uint8_t c) {
+	// Start over after a line was handed out
+	if (line->complete)
+		at_line_init(line);
+
+	if (c == '\r' || c == '\n') {
+		if (line->len == 0)
+			return AT_LINE_PENDING;
+
+		line->buf[line->len] = '\0';
+		line->complete = 1;
+
+		return AT_LINE_COMPLETE;
+	}
+
+	if (line->len < sizeof(line->buf) - 1)
+		line->buf[line->len++] = c;
+
+	return AT_LINE_PENDING;
+}
+
+uint8_t at_line_starts_with(const at_line_t *line, const char *prefix) {
+	size_t len = strlen(prefix);
+
+	return line->len >= len && memcmp(line->buf, prefix, len) == 0;
+}
+
+uint8_t at_result_code(const at_line_t *line) {
+	size_t i;
+
+	for (i = 0; i < sizeof(result_codes) / sizeof(result_codes[0]); i++) {
+		if (!at_line_starts_with(line, result_codes[i].prefix))
+			continue;
+
+		if (result_codes[i].exact && line->len != strlen(result_codes[i].prefix))
+			continue;
+
+		return result_codes[i].result;
+	}
+
+	return AT_NOT_FINAL;
+}
+
+/*
+ * Solicited answers of AT+CREG? and AT+CGREG? share the prefix with the
+ * URC, the caller tells them apart by the command it is running.
+ */
+uint8_t at_urc_type(const at_line_t *line) {
+	size_t i;
+
+	for (i = 0; i < sizeof(urc_codes) / sizeof(urc_codes[0]); i++) {
+		if (at_line_starts_with(line, urc_codes[i].prefix))
+			return urc_codes[i].urc;
+	}
+
+	return AT_URC_NONE;
+}
+
+/*
+ * Numeric parameter n of a "+XXX: a,b,c" line, -1 when it is missing or
+ * not a number.
+ */
+int16_t at_line_param(const at_line_t *line, uint8_t n) {
+	const char *p = strchr(line->buf, ':');
+	int16_t value;
+
+	if (p == NULL)
+		return -1;
+
+	p++;
+
+	while (n > 0) {
+		p = strchr(p, ',');
+
+		if (p == NULL)
+			return -1;
+
+		p++;
+		n--;
+	}
+
+	while (*p == ' ')
+		p++;
+
+	if (*p < '0' || *p > '9')
+		return -1;
+
+	for (value = 0; *p >= '0' && *p <= '9'; p++)
+		value = value * 10 + (*p - '0');
+
+	return value;
+}
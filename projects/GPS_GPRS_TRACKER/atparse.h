@@ -0,0 +1,68 @@
+/*
+ * atparse.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef ATPARSE_H_
+#define ATPARSE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if !defined(AT_LINE_BUF)
+#define AT_LINE_BUF			128
+#endif
+
+typedef enum AT_RESULT {
+	AT_OK					=	0x00,
+	AT_ERROR				=	0x01,
+	AT_CME_ERROR			=	0x02,
+	AT_CMS_ERROR			=	0x03,
+	AT_CONNECT				=	0x04,
+	AT_NO_CARRIER			=	0x05,
+	AT_BUSY					=	0x06,
+	AT_NO_ANSWER			=	0x07,
+	AT_TIMEOUT				=	0x08,
+	AT_NOT_FINAL			=	0xFF
+} AT_RESULT;
+
+// Unsolicited result codes the modem sends on its own
+typedef enum AT_URC {
+	AT_URC_WIPREADY			=	0x00,
+	AT_URC_WIPPEERCLOSE		=	0x01,
+	AT_URC_CREG				=	0x02,
+	AT_URC_CGREG			=	0x03,
+	AT_URC_RING				=	0x04,
+	AT_URC_COUNT			=	0x05,
+	AT_URC_NONE				=	0xFF
+} AT_URC;
+
+typedef enum AT_LINE_STATE {
+	AT_LINE_PENDING			=	0x00,
+	AT_LINE_COMPLETE		=	0x01
+} AT_LINE_STATE;
+
+/*
+ * Assembles modem output into lines. Empty lines (the CR LF framing around
+ * every response) are skipped, lines longer than the buffer are truncated.
+ */
+typedef struct at_line {
+	char buf[AT_LINE_BUF];
+	size_t len;
+	uint8_t complete;
+} at_line_t;
+
+extern void at_line_init(at_line_t *line);
+
+extern uint8_t at_line_put(at_line_t *line, uint8_t c);
+
+extern uint8_t at_line_starts_with(const at_line_t *line, const char *prefix);
+
+extern uint8_t at_result_code(const at_line_t *line);
+
+extern uint8_t at_urc_type(const at_line_t *line);
+
+extern int16_t at_line_param(const at_line_t *line, uint8_t n);
+
+#endif /* ATPARSE_H_ */
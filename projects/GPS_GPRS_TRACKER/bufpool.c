@@ -0,0 +1,35 @@
+/*
+ * bufpool.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Message buffers of the threads. The pool is sized at compile time for
+ * its users and lives in .bss, so its memory shows in the link map and an
+ * allocation is a pop from the free list, no heap and no fragmentation.
+ */
+
+#include "bufpool.h"
+
+static MEMORYPOOL_DECL(bufpool, BUFPOOL_SIZE, NULL);
+
+// 64 bit elements for the alignment of the buffers
+static uint64_t bufpool_storage[BUFPOOL_COUNT][BUFPOOL_SIZE / sizeof(uint64_t)];
+
+void bufpool_init(void) {
+	size_t i;
+
+	for (i = 0; i < BUFPOOL_COUNT; i++)
+		chPoolFree(&bufpool, bufpool_storage[i]);
+}
+
+/*
+ * A buffer of BUFPOOL_SIZE bytes, NULL only when a user takes more than
+ * it declared in bufpool.h.
+ */
+void *bufpool_alloc(void) {
+	return chPoolAlloc(&bufpool);
+}
+
+void bufpool_free(void *buf) {
+	chPoolFree(&bufpool, buf);
+}
@@ -0,0 +1,34 @@
+/*
+ * bufpool.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef BUFPOOL_H_
+#define BUFPOOL_H_
+
+#include "ch.h"
+
+#include <stddef.h>
+
+// Size of one buffer, a multiple of 8 so every buffer stays aligned, bytes
+#if !defined(BUFPOOL_SIZE)
+#define BUFPOOL_SIZE			256
+#endif
+
+// Buffers each user holds at most, the pool is their sum and never runs out
+#define BUFPOOL_GPS				1
+
+#define BUFPOOL_COUNT			(BUFPOOL_GPS)
+
+#if BUFPOOL_SIZE % 8 != 0 || BUFPOOL_SIZE < 8
+#error "BUFPOOL_SIZE must be a multiple of 8"
+#endif
+
+extern void bufpool_init(void);
+
+extern void *bufpool_alloc(void);
+
+extern void bufpool_free(void *buf);
+
+#endif /* BUFPOOL_H_ */
@@ -303,7 +303,7 @@
  * @note    Mutexes are recommended.
  */
 #if !defined(CH_USE_HEAP) || defined(__DOXYGEN__)
-#define CH_USE_HEAP                     TRUE
+#define CH_USE_HEAP                     FALSE
 #endif
 
 /**
@@ -497,11 +497,22 @@
  * @details This hook is continuously invoked by the idle thread loop.
  */
 #if !defined(IDLE_LOOP_HOOK) || defined(__DOXYGEN__)
+#if !defined(_FROM_ASM_)
+void lowpower_idle(void);
+#endif
 #define IDLE_LOOP_HOOK() {                                                  \
-  /* Idle loop code here.*/                                                 \
+  /* STOP mode until the next timer, see lowpower.c.*/                      \
+  lowpower_idle();                                                          \
 }
 #endif
 
+/**
+ * @brief   Idle thread stack, the idle hook runs on it.
+ */
+#if !defined(PORT_IDLE_THREAD_STACK_SIZE) || defined(__DOXYGEN__)
+#define PORT_IDLE_THREAD_STACK_SIZE     64
+#endif
+
 /**
  * @brief   System tick event hook.
  * @details This hook is invoked in the system tick handler immediately
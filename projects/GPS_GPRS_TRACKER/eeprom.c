@@ -0,0 +1,116 @@
+/*
+ * eeprom.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Board EEPROM on I2C1. Writes are held off by the write control pin
+ * except while a page goes out, so a glitch on the bus cannot change it.
+ */
+
+#include "eeprom.h"
+#if !defined(SIMULATOR)
+#include "i2cbus.h"
+#endif
+
+#include <string.h>
+
+#if defined(SIMULATOR)
+// No bus in the simulator, the part is kept in RAM and starts erased
+static uint8_t eeprom_mem[EEPROM_SIZE];
+
+uint8_t eeprom_init(void) {
+	memset(eeprom_mem, 0xFF, sizeof(eeprom_mem));
+
+	return EEPROM_OK;
+}
+
+uint8_t eeprom_read(uint32_t address, uint8_t *buf, size_t len) {
+	if (address + len > EEPROM_SIZE)
+		return EEPROM_ERR_RANGE;
+
+	memcpy(buf, eeprom_mem + address, len);
+
+	return EEPROM_OK;
+}
+
+uint8_t eeprom_write_page(uint32_t address, const uint8_t *buf) {
+	if (address % EEPROM_PAGE_SIZE != 0 || address + EEPROM_PAGE_SIZE > EEPROM_SIZE)
+		return EEPROM_ERR_RANGE;
+
+	memcpy(eeprom_mem + address, buf, EEPROM_PAGE_SIZE);
+
+	return EEPROM_OK;
+}
+#else
+// Word address followed by a page
+static uint8_t eeprom_tx[2 + EEPROM_PAGE_SIZE];
+
+/*
+ * Checks the part answers, the bus is started by i2c_bus_start().
+ */
+uint8_t eeprom_init(void) {
+	uint8_t probe[2];
+
+	palSetPad(GPIO_EEPROM_WC_PORT, GPIO_EEPROM_WC_PIN);
+	palSetPadMode(GPIO_EEPROM_WC_PORT, GPIO_EEPROM_WC_PIN, PAL_MODE_OUTPUT_PUSHPULL);
+
+	return eeprom_read(0, probe, sizeof(probe));
+}
+
+/*
+ * Sequential read, len of 2 bytes or more. The address counter wraps at
+ * the end of the part.
+ */
+uint8_t eeprom_read(uint32_t address, uint8_t *buf, size_t len) {
+	uint8_t addr[2], res;
+
+	if (address + len > EEPROM_SIZE || len < 2)
+		return EEPROM_ERR_RANGE;
+
+	addr[0] = address >> 8;
+	addr[1] = address & 0xFF;
+
+	i2cAcquireBus(&I2C_BUS);
+	res = i2c_bus_transfer(EEPROM_I2C_ADDRESS, addr, sizeof(addr), buf, len);
+	i2cReleaseBus(&I2C_BUS);
+
+	return res == I2C_BUS_OK ? EEPROM_OK : EEPROM_ERR_IO;
+}
+
+/*
+ * Writes one whole page and waits for the write cycle: the part does
+ * not acknowledge its address until the cycle is over.
+ */
+uint8_t eeprom_write_page(uint32_t address, const uint8_t *buf) {
+	uint8_t res, i;
+
+	if (address % EEPROM_PAGE_SIZE != 0 || address + EEPROM_PAGE_SIZE > EEPROM_SIZE)
+		return EEPROM_ERR_RANGE;
+
+	i2cAcquireBus(&I2C_BUS);
+
+	eeprom_tx[0] = address >> 8;
+	eeprom_tx[1] = address & 0xFF;
+	memcpy(eeprom_tx + 2, buf, EEPROM_PAGE_SIZE);
+
+	palClearPad(GPIO_EEPROM_WC_PORT, GPIO_EEPROM_WC_PIN);
+	res = i2c_bus_transfer(EEPROM_I2C_ADDRESS, eeprom_tx, sizeof(eeprom_tx), NULL, 0) == I2C_BUS_OK ?
+			EEPROM_OK : EEPROM_ERR_IO;
+
+	for (i = 0; res == EEPROM_OK && i < EEPROM_WRITE_MS; i++) {
+		chThdSleepMilliseconds(1);
+
+		if (i2c_bus_transfer(EEPROM_I2C_ADDRESS, eeprom_tx, 2, NULL, 0) == I2C_BUS_OK)
+			break;
+	}
+
+	palSetPad(GPIO_EEPROM_WC_PORT, GPIO_EEPROM_WC_PIN);
+
+	if (i == EEPROM_WRITE_MS)
+		res = EEPROM_ERR_IO;
+
+	i2cReleaseBus(&I2C_BUS);
+
+	return res;
+}
+#endif
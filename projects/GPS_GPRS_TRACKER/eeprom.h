@@ -0,0 +1,47 @@
+/*
+ * eeprom.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef EEPROM_H_
+#define EEPROM_H_
+
+#include "ch.h"
+#include "hal.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 24xx256 class part: 32 KB, 64 byte pages, two address bytes
+#if !defined(EEPROM_SIZE)
+#define EEPROM_SIZE				32768
+#endif
+
+#if !defined(EEPROM_PAGE_SIZE)
+#define EEPROM_PAGE_SIZE		64
+#endif
+
+// 7 bit bus address, chip enable pins low
+#if !defined(EEPROM_I2C_ADDRESS)
+#define EEPROM_I2C_ADDRESS		0x50
+#endif
+
+// Longest internal write cycle after a page write, ms
+#if !defined(EEPROM_WRITE_MS)
+#define EEPROM_WRITE_MS			10
+#endif
+
+typedef enum EEPROM_RESULT {
+	EEPROM_OK				=	0x00,
+	EEPROM_ERR_IO			=	0x01,
+	EEPROM_ERR_RANGE		=	0x02
+} EEPROM_RESULT;
+
+extern uint8_t eeprom_init(void);
+
+extern uint8_t eeprom_read(uint32_t address, uint8_t *buf, size_t len);
+
+extern uint8_t eeprom_write_page(uint32_t address, const uint8_t *buf);
+
+#endif /* EEPROM_H_ */
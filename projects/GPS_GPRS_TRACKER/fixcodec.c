@@ -0,0 +1,249 @@
+/*
+ * fixcodec.c
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "fixcodec.h"
+
+#define COURSE_FULL_CIRCLE		36000
+
+// Days from 2000-01-01 to the first day of each month of a non leap year
+static const uint16_t month_days[12] = {
+	0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334
+};
+
+uint32_t fix_codec_timestamp(const gps_rmc_state_t *nav) {
+	uint32_t days;
+	uint8_t month = nav->month;
+
+	if (month < 1 || month > 12)
+		month = 1;
+
+	// 2000 is a leap year, every 4th year after it up to 2099 too
+	days = (uint32_t)nav->year * 365 + (nav->year + 3) / 4;
+	days += month_days[month - 1] + (nav->day > 0 ? nav->day - 1 : 0);
+
+	if (month > 2 && (nav->year % 4) == 0)
+		days++;
+
+	return days * 86400 + (uint32_t)nav->hour * 3600 + nav->minute * 60 + nav->second;
+}
+
+void fix_record_from_fix(const gps_fix_t *fix, fix_record_t *rec) {
+	const gps_rmc_state_t *nav = &fix->nav;
+
+	rec->time = fix_codec_timestamp(nav);
+
+	rec->latitude = (int32_t)nav->latitude_degrees * 600000 + nav->latitude_seconds;
+	if (nav->flags & LATITUDE_S)
+		rec->latitude = -rec->latitude;
+
+	rec->longitude = (int32_t)nav->longitude_degrees * 600000 + nav->longitude_seconds;
+	if (nav->flags & LONGITUDE_W)
+		rec->longitude = -rec->longitude;
+
+	rec->speed = nav->speed;
+	rec->course = nav->course;
+	rec->invalid = (nav->flags & GPS_DATA_INVALID) ? 1 : 0;
+}
+
+void fix_codec_init(fix_codec_t *codec) {
+	codec->has_prev = 0;
+}
+
+static size_t put_varint(uint8_t *buf, uint32_t value) {
+	size_t n = 0;
+
+	while (value >= 0x80) {
+		buf[n++] = (value & 0x7F) | 0x80;
+		value >>= 7;
+	}
+
+	buf[n++] = value;
+
+	return n;
+}
+
+static uint32_t zigzag(int32_t value) {
+	return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value) {
+	return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+/*
+ * Course change folded into -180..180 degrees.
+ */
+static int32_t course_delta(uint16_t from, uint16_t to) {
+	int32_t delta = (int32_t)to - from;
+
+	if (delta > COURSE_FULL_CIRCLE / 2)
+		delta -= COURSE_FULL_CIRCLE;
+	else if (delta <= -COURSE_FULL_CIRCLE / 2)
+		delta += COURSE_FULL_CIRCLE;
+
+	return delta;
+}
+
+/*
+ * Appends one record to buf (at least FIX_CODEC_MAX_RECORD bytes),
+ * returns the number of bytes written.
+ */
+size_t fix_codec_encode(fix_codec_t *codec, const fix_record_t *rec, uint8_t *buf) {
+	const fix_record_t *prev = &codec->prev;
+	uint8_t header = rec->invalid ? FIX_REC_INVALID : 0;
+	size_t n = 1;
+	int32_t delta;
+
+	if (!codec->has_prev || rec->time < prev->time || rec->time - prev->time > FIX_CODEC_MAX_STEP) {
+		header |= FIX_REC_KEY;
+
+		n += put_varint(buf + n, rec->time);
+		n += put_varint(buf + n, zigzag(rec->latitude));
+		n += put_varint(buf + n, zigzag(rec->longitude));
+		n += put_varint(buf + n, rec->speed);
+		n += put_varint(buf + n, rec->course);
+	} else {
+		if (rec->time - prev->time != FIX_CODEC_DEFAULT_STEP) {
+			header |= FIX_REC_TIME;
+			n += put_varint(buf + n, rec->time - prev->time);
+		}
+
+		if ((delta = rec->latitude - prev->latitude) != 0) {
+			header |= FIX_REC_LATITUDE;
+			n += put_varint(buf + n, zigzag(delta));
+		}
+
+		if ((delta = rec->longitude - prev->longitude) != 0) {
+			header |= FIX_REC_LONGITUDE;
+			n += put_varint(buf + n, zigzag(delta));
+		}
+
+		if ((delta = (int32_t)rec->speed - prev->speed) != 0) {
+			header |= FIX_REC_SPEED;
+			n += put_varint(buf + n, zigzag(delta));
+		}
+
+		if ((delta = course_delta(prev->course, rec->course)) != 0) {
+			header |= FIX_REC_COURSE;
+			n += put_varint(buf + n, zigzag(delta));
+		}
+	}
+
+	buf[0] = header;
+
+	codec->prev = *rec;
+	codec->has_prev = 1;
+
+	return n;
+}
+
+static uint8_t get_varint(const uint8_t *buf, size_t len, size_t *pos, uint32_t *value) {
+	uint8_t shift = 0;
+
+	*value = 0;
+
+	while (*pos < len && shift < 35) {
+		uint8_t b = buf[(*pos)++];
+
+		*value |= (uint32_t)(b & 0x7F) << shift;
+
+		if (!(b & 0x80))
+			return FIX_CODEC_OK;
+
+		shift += 7;
+	}
+
+	return FIX_CODEC_ERR_SHORT;
+}
+
+/*
+ * Decodes one record from buf, used is set to its length.
+ */
+uint8_t fix_codec_decode(fix_codec_t *codec, const uint8_t *buf, size_t len, fix_record_t *rec, size_t *used) {
+	size_t pos = 1;
+	uint32_t value;
+	uint8_t header;
+	int32_t course;
+
+	if (len == 0)
+		return FIX_CODEC_ERR_SHORT;
+
+	header = buf[0];
+
+	if (header & FIX_REC_KEY) {
+		if (get_varint(buf, len, &pos, &rec->time) != FIX_CODEC_OK)
+			return FIX_CODEC_ERR_SHORT;
+
+		if (get_varint(buf, len, &pos, &value) != FIX_CODEC_OK)
+			return FIX_CODEC_ERR_SHORT;
+		rec->latitude = unzigzag(value);
+
+		if (get_varint(buf, len, &pos, &value) != FIX_CODEC_OK)
+			return FIX_CODEC_ERR_SHORT;
+		rec->longitude = unzigzag(value);
+
+		if (get_varint(buf, len, &pos, &value) != FIX_CODEC_OK)
+			return FIX_CODEC_ERR_SHORT;
+		rec->speed = value;
+
+		if (get_varint(buf, len, &pos, &value) != FIX_CODEC_OK)
+			return FIX_CODEC_ERR_SHORT;
+		rec->course = value;
+	} else {
+		if (!codec->has_prev)
+			return FIX_CODEC_ERR_NO_KEY;
+
+		*rec = codec->prev;
+		rec->time += FIX_CODEC_DEFAULT_STEP;
+
+		if (header & FIX_REC_TIME) {
+			if (get_varint(buf, len, &pos, &value) != FIX_CODEC_OK)
+				return FIX_CODEC_ERR_SHORT;
+			rec->time = codec->prev.time + value;
+		}
+
+		if (header & FIX_REC_LATITUDE) {
+			if (get_varint(buf, len, &pos, &value) != FIX_CODEC_OK)
+				return FIX_CODEC_ERR_SHORT;
+			rec->latitude += unzigzag(value);
+		}
+
+		if (header & FIX_REC_LONGITUDE) {
+			if (get_varint(buf, len, &pos, &value) != FIX_CODEC_OK)
+				return FIX_CODEC_ERR_SHORT;
+			rec->longitude += unzigzag(value);
+		}
+
+		if (header & FIX_REC_SPEED) {
+			if (get_varint(buf, len, &pos, &value) != FIX_CODEC_OK)
+				return FIX_CODEC_ERR_SHORT;
+			rec->speed += unzigzag(value);
+		}
+
+		if (header & FIX_REC_COURSE) {
+			if (get_varint(buf, len, &pos, &value) != FIX_CODEC_OK)
+				return FIX_CODEC_ERR_SHORT;
+
+			course = (int32_t)rec->course + unzigzag(value);
+
+			if (course < 0)
+				course += COURSE_FULL_CIRCLE;
+			else if (course >= COURSE_FULL_CIRCLE)
+				course -= COURSE_FULL_CIRCLE;
+
+			rec->course = course;
+		}
+	}
+
+	rec->invalid = (header & FIX_REC_INVALID) ? 1 : 0;
+
+	codec->prev = *rec;
+	codec->has_prev = 1;
+
+	*used = pos;
+
+	return FIX_CODEC_OK;
+}
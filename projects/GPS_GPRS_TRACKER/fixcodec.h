@@ -0,0 +1,73 @@
+/*
+ * fixcodec.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef FIXCODEC_H_
+#define FIXCODEC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "gps_fix.h"
+
+// Worst case record: header + 5 varints of up to 5 bytes
+#define FIX_CODEC_MAX_RECORD	26
+
+// Time step assumed when the header has no FIX_REC_TIME bit
+#define FIX_CODEC_DEFAULT_STEP	1
+
+// Gaps longer than this start a new key record
+#define FIX_CODEC_MAX_STEP		3600
+
+typedef enum FIX_RECORD_HEADER {
+	FIX_REC_TIME			=	1 << 0,
+	FIX_REC_LATITUDE		=	1 << 1,
+	FIX_REC_LONGITUDE		=	1 << 2,
+	FIX_REC_SPEED			=	1 << 3,
+	FIX_REC_COURSE			=	1 << 4,
+	FIX_REC_INVALID			=	1 << 5,
+	FIX_REC_KEY				=	1 << 7
+} FIX_RECORD_HEADER;
+
+typedef enum FIX_CODEC_RESULT {
+	FIX_CODEC_OK			=	0x00,
+	FIX_CODEC_ERR_SHORT		=	0x01,
+	FIX_CODEC_ERR_NO_KEY	=	0x02
+} FIX_CODEC_RESULT;
+
+/*
+ * Flat form of a fix the codec works on.
+ * Latitude and longitude are signed 1/10000 minute units (south and west
+ * negative), time is seconds since 2000-01-01 00:00:00 UTC.
+ */
+typedef struct fix_record {
+	uint32_t time;
+	int32_t latitude;
+	int32_t longitude;
+	uint16_t speed;
+	uint16_t course;
+	uint8_t invalid;
+} fix_record_t;
+
+/*
+ * Encoder and decoder both keep the previous record, every record after
+ * a key one only carries zig-zag varint deltas of the fields that changed.
+ */
+typedef struct fix_codec {
+	fix_record_t prev;
+	uint8_t has_prev;
+} fix_codec_t;
+
+extern uint32_t fix_codec_timestamp(const gps_rmc_state_t *nav);
+
+extern void fix_record_from_fix(const gps_fix_t *fix, fix_record_t *rec);
+
+extern void fix_codec_init(fix_codec_t *codec);
+
+extern size_t fix_codec_encode(fix_codec_t *codec, const fix_record_t *rec, uint8_t *buf);
+
+extern uint8_t fix_codec_decode(fix_codec_t *codec, const uint8_t *buf, size_t len, fix_record_t *rec, size_t *used);
+
+#endif /* FIXCODEC_H_ */
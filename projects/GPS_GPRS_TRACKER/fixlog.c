@@ -0,0 +1,289 @@
+/*
+ * fixlog.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Store-and-forward log of fix records on a page written device, the
+ * board EEPROM. Survives resets and brown-outs, a page torn by one loses
+ * that page only.
+ */
+
+#include "fixlog.h"
+
+#include <string.h>
+
+static void put_be(uint8_t *p, uint32_t value, uint8_t len) {
+	while (len-- > 0) {
+		p[len] = value & 0xFF;
+		value >>= 8;
+	}
+}
+
+static uint32_t get_be(const uint8_t *p, uint8_t len) {
+	uint32_t value = 0;
+
+	while (len-- > 0)
+		value = value << 8 | *p++;
+
+	return value;
+}
+
+// CRC-8, polynomial 0x07
+uint8_t fixlog_crc8(const uint8_t *buf, size_t len) {
+	uint8_t crc = 0, i;
+
+	while (len-- > 0) {
+		crc ^= *buf++;
+
+		for (i = 0; i < 8; i++)
+			crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+	}
+
+	return crc;
+}
+
+static void fixlog_page_reset(fixlog_t *log) {
+	log->page_len = FIXLOG_HEADER_SIZE;
+	log->page_count = 0;
+
+	fix_codec_init(&log->codec);
+}
+
+/*
+ * Reads the header of page n. Returns 1 and its sequence and tail when
+ * it is a log page, 0 for erased, torn or unreadable ones.
+ */
+static uint8_t fixlog_read_header(fixlog_t *log, uint16_t n, uint32_t *seq, uint32_t *tail) {
+	uint8_t header[FIXLOG_HEADER_SIZE];
+
+	log->stats.open_reads++;
+
+	if (log->dev->read((uint32_t)n * FIXLOG_PAGE_SIZE, header, sizeof(header)) != 0) {
+		log->stats.io_errors++;
+		return 0;
+	}
+
+	if (header[0] != FIXLOG_MAGIC || fixlog_crc8(header, FIXLOG_HEADER_SIZE - 1) != header[FIXLOG_HEADER_SIZE - 1])
+		return 0;
+
+	*seq = get_be(header + 2, 4);
+	*tail = get_be(header + 6, 4);
+
+	// Page n only ever holds sequence n, pages + n, ...
+	return *seq % log->pages == n;
+}
+
+/*
+ * Finds the newest page. Page 0 to the newest one hold consecutive
+ * sequences, the pages after it hold the previous lap or nothing, so a
+ * binary search on that takes log2(pages) header reads. A page 0 torn
+ * while starting a new lap leaves the previous lap, which ends at the
+ * last page.
+ */
+uint8_t fixlog_open(fixlog_t *log, const fixlog_device_t *dev) {
+	uint32_t first, seq, tail, mid_seq, mid_tail;
+	uint16_t lo, hi, mid;
+
+	memset(log, 0, sizeof(*log));
+	log->dev = dev;
+	log->pages = dev->size / FIXLOG_PAGE_SIZE;
+
+	fixlog_page_reset(log);
+
+	if (log->pages < 2)
+		return FIXLOG_ERR_SIZE;
+
+	if (fixlog_read_header(log, 0, &first, &tail)) {
+		seq = first;
+		lo = 0;
+		hi = log->pages - 1;
+
+		while (lo < hi) {
+			mid = lo + (hi - lo + 1) / 2;
+
+			if (fixlog_read_header(log, mid, &mid_seq, &mid_tail) && mid_seq == first + mid) {
+				lo = mid;
+				seq = mid_seq;
+				tail = mid_tail;
+			} else {
+				hi = mid - 1;
+			}
+		}
+	} else if (!fixlog_read_header(log, log->pages - 1, &seq, &tail)) {
+		// Nothing written yet
+		return FIXLOG_OK;
+	}
+
+	log->seq = seq + 1;
+	log->head = log->seq % log->pages;
+
+	// The tail of a torn or foreign header could be anything
+	if ((uint32_t)(log->seq - tail) > log->pages)
+		tail = log->seq - log->pages;
+
+	log->tail = tail;
+
+	return FIXLOG_OK;
+}
+
+/*
+ * Writes the page being filled, if it has any records, to the head of
+ * the ring and starts the next one. When the ring is full the oldest
+ * page goes, sent or not.
+ */
+uint8_t fixlog_sync(fixlog_t *log) {
+	if (log->page_count == 0)
+		return FIXLOG_OK;
+
+	if ((uint32_t)(log->seq - log->tail) >= log->pages) {
+		log->tail = log->seq - log->pages + 1;
+		log->stats.pages_lost++;
+	}
+
+	log->page[0] = FIXLOG_MAGIC;
+	log->page[1] = log->page_count;
+	put_be(log->page + 2, log->seq, 4);
+	put_be(log->page + 6, log->tail, 4);
+	log->page[FIXLOG_HEADER_SIZE - 1] = fixlog_crc8(log->page, FIXLOG_HEADER_SIZE - 1);
+
+	memset(log->page + log->page_len, 0xFF, FIXLOG_PAGE_SIZE - log->page_len);
+
+	// Kept for the next attempt on failure
+	if (log->dev->write_page((uint32_t)log->head * FIXLOG_PAGE_SIZE, log->page) != 0) {
+		log->stats.io_errors++;
+		return FIXLOG_ERR_IO;
+	}
+
+	log->stats.pages_written++;
+	log->seq++;
+	log->head = log->seq % log->pages;
+
+	fixlog_page_reset(log);
+
+	return FIXLOG_OK;
+}
+
+/*
+ * Adds the record to the page being filled and writes the page once the
+ * record does not fit any more. Fails only when that write fails, the
+ * record is not logged then.
+ */
+uint8_t fixlog_append(fixlog_t *log, const fix_record_t *rec) {
+	uint8_t buf[FIX_CODEC_MAX_RECORD], *p;
+	fix_codec_t codec = log->codec;
+	size_t len = fix_codec_encode(&codec, rec, buf);
+
+	if (log->page_len + FIXLOG_RECORD_OVERHEAD + len > FIXLOG_PAGE_SIZE || log->page_count == 0xFF) {
+		if (fixlog_sync(log) != FIXLOG_OK)
+			return FIXLOG_ERR_IO;
+
+		// New page, new key record
+		codec = log->codec;
+		len = fix_codec_encode(&codec, rec, buf);
+	}
+
+	p = log->page + log->page_len;
+	p[0] = len;
+	memcpy(p + 1, buf, len);
+	p[len + 1] = fixlog_crc8(p, len + 1);
+
+	log->page_len += FIXLOG_RECORD_OVERHEAD + len;
+	log->page_count++;
+	log->codec = codec;
+	log->stats.records++;
+
+	return FIXLOG_OK;
+}
+
+/*
+ * Decodes the n records of the page into recs, see fixlog_read().
+ */
+static uint8_t fixlog_decode(fixlog_t *log, const uint8_t *page, uint8_t n, fix_record_t *recs, uint8_t *count) {
+	uint8_t i, len;
+	fix_codec_t codec;
+	size_t pos = FIXLOG_HEADER_SIZE, used;
+
+	if (n > FIXLOG_PAGE_RECORDS)
+		n = FIXLOG_PAGE_RECORDS;
+
+	fix_codec_init(&codec);
+
+	for (i = 0; i < n; i++) {
+		len = page[pos];
+
+		if (pos + FIXLOG_RECORD_OVERHEAD + len > FIXLOG_PAGE_SIZE ||
+				fixlog_crc8(page + pos, len + 1) != page[pos + len + 1] ||
+				fix_codec_decode(&codec, page + pos + 1, len, &recs[i], &used) != FIX_CODEC_OK) {
+			log->stats.crc_errors++;
+			return FIXLOG_ERR_CRC;
+		}
+
+		pos += FIXLOG_RECORD_OVERHEAD + len;
+		(*count)++;
+	}
+
+	return FIXLOG_OK;
+}
+
+/*
+ * Reads the records of the written page seq, from the tail up to
+ * log->seq. recs takes FIXLOG_PAGE_RECORDS. The records before a CRC
+ * error are good and *count says how many, FIXLOG_ERR_CRC then.
+ */
+uint8_t fixlog_read(fixlog_t *log, uint32_t seq, fix_record_t *recs, uint8_t *count) {
+	uint8_t page[FIXLOG_PAGE_SIZE];
+
+	*count = 0;
+
+	if ((uint32_t)(seq - log->tail) >= (uint32_t)(log->seq - log->tail))
+		return FIXLOG_EMPTY;
+
+	if (log->dev->read((seq % log->pages) * FIXLOG_PAGE_SIZE, page, sizeof(page)) != 0) {
+		log->stats.io_errors++;
+		return FIXLOG_ERR_IO;
+	}
+
+	if (page[0] != FIXLOG_MAGIC || fixlog_crc8(page, FIXLOG_HEADER_SIZE - 1) != page[FIXLOG_HEADER_SIZE - 1] ||
+			get_be(page + 2, 4) != seq) {
+		log->stats.crc_errors++;
+		return FIXLOG_ERR_CRC;
+	}
+
+	return fixlog_decode(log, page, page[1], recs, count);
+}
+
+/*
+ * Reads the records of the page being filled, which is not on the device
+ * yet. Lets them go another way when the device keeps failing to write
+ * it, see fixlog_drop_page().
+ */
+uint8_t fixlog_read_page(fixlog_t *log, fix_record_t *recs, uint8_t *count) {
+	*count = 0;
+
+	if (log->page_count == 0)
+		return FIXLOG_EMPTY;
+
+	return fixlog_decode(log, log->page, log->page_count, recs, count);
+}
+
+/*
+ * Forgets the records of the page being filled, they were sent otherwise.
+ */
+void fixlog_drop_page(fixlog_t *log) {
+	fixlog_page_reset(log);
+}
+
+/*
+ * Pages before seq are sent. Goes to the device with the next page, so
+ * a reset before that sends them again.
+ */
+void fixlog_ack(fixlog_t *log, uint32_t seq) {
+	// Pages overwritten meanwhile moved the tail past them already
+	if ((uint32_t)(seq - log->tail) <= (uint32_t)(log->seq - log->tail))
+		log->tail = seq;
+}
+
+// Written pages not acknowledged yet
+uint32_t fixlog_pending(const fixlog_t *log) {
+	return log->seq - log->tail;
+}
@@ -0,0 +1,117 @@
+/*
+ * fixlog.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef FIXLOG_H_
+#define FIXLOG_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "fixcodec.h"
+
+// Write unit of the device, every page is written whole and at once
+#if !defined(FIXLOG_PAGE_SIZE)
+#define FIXLOG_PAGE_SIZE		64
+#endif
+
+#define FIXLOG_MAGIC			'L'
+
+// Page header: magic, record count, sequence, tail sequence, CRC
+#define FIXLOG_HEADER_SIZE		11
+
+// Record: length, fixcodec record, CRC
+#define FIXLOG_RECORD_OVERHEAD	2
+
+// Most records a page can hold, a delta record is at least one byte
+#define FIXLOG_PAGE_RECORDS		((FIXLOG_PAGE_SIZE - FIXLOG_HEADER_SIZE) / (FIXLOG_RECORD_OVERHEAD + 1))
+
+#if FIXLOG_PAGE_SIZE < FIXLOG_HEADER_SIZE + FIXLOG_RECORD_OVERHEAD + FIX_CODEC_MAX_RECORD
+#error "FIXLOG_PAGE_SIZE does not fit a key record"
+#endif
+
+typedef enum FIXLOG_RESULT {
+	FIXLOG_OK				=	0x00,
+	FIXLOG_EMPTY			=	0x01,
+	FIXLOG_ERR_IO			=	0x02,
+	FIXLOG_ERR_CRC			=	0x03,
+	FIXLOG_ERR_SIZE			=	0x04
+} FIXLOG_RESULT;
+
+/*
+ * Storage the log lives on. Both calls return 0 on success, write_page
+ * gets a page aligned address and FIXLOG_PAGE_SIZE bytes.
+ */
+typedef struct fixlog_device {
+	uint8_t (*read)(uint32_t address, uint8_t *buf, size_t len);
+	uint8_t (*write_page)(uint32_t address, const uint8_t *buf);
+	uint32_t size;
+} fixlog_device_t;
+
+typedef struct fixlog_stats {
+	uint32_t records;
+	uint32_t pages_written;
+
+	// Unsent pages the ring wrapped over
+	uint32_t pages_lost;
+
+	uint32_t crc_errors;
+	uint32_t io_errors;
+
+	// Device reads the last fixlog_open() took
+	uint16_t open_reads;
+} fixlog_stats_t;
+
+/*
+ * Append-only ring of pages on the device. Page header:
+ *   'L' <record count> <sequence, 4 bytes> <tail, 4 bytes> <CRC-8 of the header>
+ * then the records, each <length> <fixcodec record> <CRC-8 of both>, and
+ * 0xFF up to the page end. Every page starts with a key record so it
+ * decodes on its own. All numbers big endian.
+ *
+ * Page n of the ring holds sequence k * pages + n, so the pages wear
+ * evenly and the newest one is where the sequence stops counting up from
+ * page 0, which a binary search finds. The tail is the oldest page not
+ * acknowledged yet and goes to the device with the next page written.
+ */
+typedef struct fixlog {
+	const fixlog_device_t *dev;
+	uint16_t pages;
+
+	// Page and sequence the next write goes to
+	uint16_t head;
+	uint32_t seq;
+
+	// Oldest page not acknowledged
+	uint32_t tail;
+
+	// Page being filled, written once full or on fixlog_sync()
+	uint8_t page[FIXLOG_PAGE_SIZE];
+	uint8_t page_len;
+	uint8_t page_count;
+	fix_codec_t codec;
+
+	fixlog_stats_t stats;
+} fixlog_t;
+
+extern uint8_t fixlog_crc8(const uint8_t *buf, size_t len);
+
+extern uint8_t fixlog_open(fixlog_t *log, const fixlog_device_t *dev);
+
+extern uint8_t fixlog_append(fixlog_t *log, const fix_record_t *rec);
+
+extern uint8_t fixlog_sync(fixlog_t *log);
+
+extern uint8_t fixlog_read(fixlog_t *log, uint32_t seq, fix_record_t *recs, uint8_t *count);
+
+extern uint8_t fixlog_read_page(fixlog_t *log, fix_record_t *recs, uint8_t *count);
+
+extern void fixlog_drop_page(fixlog_t *log);
+
+extern void fixlog_ack(fixlog_t *log, uint32_t seq);
+
+extern uint32_t fixlog_pending(const fixlog_t *log);
+
+#endif /* FIXLOG_H_ */
@@ -0,0 +1,113 @@
+/*
+ * fixring.c
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "fixring.h"
+
+// Keeps the compiler from moving slot accesses across sequence updates.
+// Cortex-M3 is single core, no hardware barrier is needed.
+#define FIX_RING_BARRIER()		__asm__ volatile ("" ::: "memory")
+
+void fix_ring_init(fix_ring_t *ring) {
+	uint32_t i;
+
+	ring->head = 0;
+
+	for (i = 0; i < FIX_RING_SIZE; i++)
+		ring->slots[i].seq = FIX_RING_SEQ_WRITING;
+}
+
+void fix_ring_put(fix_ring_t *ring, const gps_fix_t *fix) {
+	uint32_t seq = ring->head;
+	fix_ring_slot_t *slot = &ring->slots[seq & (FIX_RING_SIZE - 1)];
+
+	slot->seq = FIX_RING_SEQ_WRITING;
+	FIX_RING_BARRIER();
+
+	slot->fix = *fix;
+	FIX_RING_BARRIER();
+
+	slot->seq = seq;
+	FIX_RING_BARRIER();
+
+	ring->head = seq + 1;
+}
+
+/*
+ * New reader starts with the next published fix.
+ */
+void fix_ring_reader_init(fix_ring_t *ring, fix_ring_reader_t *reader) {
+	reader->next = ring->head;
+	reader->lost = 0;
+}
+
+/*
+ * Copies the oldest fix the reader has not seen yet. A reader that fell
+ * more than FIX_RING_SIZE fixes behind skips to the oldest one still in
+ * the ring and accounts the skipped ones in lost. A reader that preempted
+ * the producer in the middle of its slot gets FIX_RING_BUSY instead of
+ * spinning on a slot that cannot change until the producer runs again.
+ */
+uint8_t fix_ring_get(fix_ring_t *ring, fix_ring_reader_t *reader, gps_fix_t *fix) {
+	fix_ring_slot_t *slot;
+	uint32_t head;
+
+	for (;;) {
+		head = ring->head;
+		FIX_RING_BARRIER();
+
+		if (reader->next == head)
+			return FIX_RING_EMPTY;
+
+		if (head - reader->next > FIX_RING_SIZE) {
+			reader->lost += head - FIX_RING_SIZE - reader->next;
+			reader->next = head - FIX_RING_SIZE;
+		}
+
+		slot = &ring->slots[reader->next & (FIX_RING_SIZE - 1)];
+
+		if (slot->seq != reader->next) {
+			if (ring->head == head)
+				return FIX_RING_BUSY;
+			continue;
+		}
+
+		FIX_RING_BARRIER();
+		*fix = slot->fix;
+		FIX_RING_BARRIER();
+
+		// Overwritten while copying, catch up with the producer
+		if (slot->seq != reader->next) {
+			if (ring->head == head)
+				return FIX_RING_BUSY;
+			continue;
+		}
+
+		reader->next++;
+
+		return FIX_RING_OK;
+	}
+}
+
+/*
+ * Copies the newest fix, returns the number of fixes published so far
+ * (0 - nothing published yet, fix is not touched).
+ */
+uint32_t fix_ring_latest(fix_ring_t *ring, gps_fix_t *fix) {
+	fix_ring_reader_t reader;
+	uint32_t head;
+
+	do {
+		head = ring->head;
+
+		if (head == 0)
+			return 0;
+
+		reader.next = head - 1;
+		reader.lost = 0;
+	} while (fix_ring_get(ring, &reader, fix) != FIX_RING_OK);
+
+	return reader.next;
+}
@@ -0,0 +1,68 @@
+/*
+ * fixring.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef FIXRING_H_
+#define FIXRING_H_
+
+#include <stdint.h>
+
+#include "gps_fix.h"
+
+// Must be a power of two
+#if !defined(FIX_RING_SIZE)
+#define FIX_RING_SIZE			16
+#endif
+
+#if (FIX_RING_SIZE & (FIX_RING_SIZE - 1)) != 0
+#error "FIX_RING_SIZE must be a power of two"
+#endif
+
+// Slot sequence while the producer is writing it
+#define FIX_RING_SEQ_WRITING	0xFFFFFFFF
+
+typedef enum FIX_RING_RESULT {
+	FIX_RING_OK				=	0x00,
+	FIX_RING_EMPTY			=	0x01,
+	// The producer is writing the slot, try again after its next fix event
+	FIX_RING_BUSY			=	0x02
+} FIX_RING_RESULT;
+
+typedef struct fix_ring_slot {
+	volatile uint32_t seq;
+	gps_fix_t fix;
+} fix_ring_slot_t;
+
+/*
+ * Single producer, many consumer ring of fixes.
+ * The producer never waits: it overwrites the oldest slot and marks it
+ * with the fix sequence number. Consumers keep their own position and
+ * detect overwritten slots by checking the slot sequence before and
+ * after copying, the same way a seqlock works.
+ */
+typedef struct fix_ring {
+	volatile uint32_t head;
+	fix_ring_slot_t slots[FIX_RING_SIZE];
+} fix_ring_t;
+
+typedef struct fix_ring_reader {
+	// Sequence number of the next fix to read
+	uint32_t next;
+
+	// Fixes overwritten before this reader got to them
+	uint32_t lost;
+} fix_ring_reader_t;
+
+extern void fix_ring_init(fix_ring_t *ring);
+
+extern void fix_ring_put(fix_ring_t *ring, const gps_fix_t *fix);
+
+extern void fix_ring_reader_init(fix_ring_t *ring, fix_ring_reader_t *reader);
+
+extern uint8_t fix_ring_get(fix_ring_t *ring, fix_ring_reader_t *reader, gps_fix_t *fix);
+
+extern uint32_t fix_ring_latest(fix_ring_t *ring, gps_fix_t *fix);
+
+#endif /* FIXRING_H_ */
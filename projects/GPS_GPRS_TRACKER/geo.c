@@ -0,0 +1,391 @@
+/*
+ * geo.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Integer geodesy on a sphere of the mean Earth radius, no float math.
+ * Angles inside are binary: the full circle is 2^32, so wrapping around
+ * 360 degrees is plain uint32_t overflow. Sines are Q30 fixed point.
+ */
+
+#include "geo.h"
+
+#define GEO_ANGLE_90			0x40000000UL
+#define GEO_ANGLE_180			0x80000000UL
+
+#define GEO_Q30_ONE				((int32_t)1 << 30)
+#define GEO_Q60_ONE				((uint64_t)1 << 60)
+
+// 2^32 / 360e6 in Q28, microdegrees to binary angle
+#define GEO_ANGLE_PER_UDEG_Q28	3202559735LL
+
+// Arc of one microdegree on the mean radius (6371008.8 m) in cm, Q28
+#define GEO_CM_PER_UDEG_Q28		2984870207ULL
+
+// Circumference on the mean radius, cm
+#define GEO_CIRCUMFERENCE_CM	4003022888ULL
+
+// 1/100 knot per cm/ms: 1000 * 3600 / 185200 * 100
+#define GEO_KNOTS100_PER_CM_MS	1943844ULL
+
+#define GEO_TABLE_BITS			8
+#define GEO_TABLE_SIZE			(1 << GEO_TABLE_BITS)
+
+// sin(i * 90 / 256 degrees), Q30
+static const int32_t geo_sin_table[GEO_TABLE_SIZE + 1] = {
+	0, 6588356, 13176464, 19764076, 26350943, 32936819,
+	39521455, 46104602, 52686014, 59265442, 65842639, 72417357,
+	78989349, 85558366, 92124163, 98686491, 105245103, 111799753,
+	118350194, 124896179, 131437462, 137973796, 144504935, 151030634,
+	157550647, 164064728, 170572633, 177074115, 183568930, 190056834,
+	196537583, 203010932, 209476638, 215934457, 222384147, 228825464,
+	235258165, 241682010, 248096755, 254502159, 260897982, 267283981,
+	273659918, 280025552, 286380643, 292724951, 299058239, 305380268,
+	311690799, 317989595, 324276419, 330551034, 336813204, 343062693,
+	349299266, 355522689, 361732726, 367929144, 374111709, 380280190,
+	386434353, 392573967, 398698801, 404808624, 410903207, 416982319,
+	423045732, 429093217, 435124548, 441139496, 447137835, 453119340,
+	459083786, 465030947, 470960600, 476872522, 482766489, 488642281,
+	494499676, 500338453, 506158392, 511959275, 517740883, 523502998,
+	529245404, 534967884, 540670223, 546352205, 552013618, 557654248,
+	563273883, 568872310, 574449320, 580004702, 585538248, 591049748,
+	596538995, 602005783, 607449906, 612871159, 618269338, 623644239,
+	628995660, 634323400, 639627258, 644907034, 650162530, 655393548,
+	660599890, 665781362, 670937767, 676068911, 681174602, 686254647,
+	691308855, 696337036, 701339000, 706314559, 711263525, 716185713,
+	721080937, 725949013, 730789757, 735602987, 740388522, 745146182,
+	749875788, 754577161, 759250125, 763894504, 768510122, 773096806,
+	777654384, 782182683, 786681534, 791150767, 795590213, 799999706,
+	804379079, 808728167, 813046808, 817334838, 821592095, 825818421,
+	830013654, 834177638, 838310216, 842411232, 846480531, 850517961,
+	854523370, 858496606, 862437520, 866345964, 870221790, 874064853,
+	877875009, 881652112, 885396022, 889106597, 892783698, 896427186,
+	900036924, 903612776, 907154608, 910662286, 914135678, 917574653,
+	920979082, 924348837, 927683790, 930983817, 934248793, 937478595,
+	940673101, 943832191, 946955747, 950043650, 953095785, 956112036,
+	959092290, 962036435, 964944360, 967815955, 970651112, 973449725,
+	976211688, 978936898, 981625251, 984276646, 986890984, 989468165,
+	992008094, 994510675, 996975812, 999403415, 1001793390, 1004145648,
+	1006460100, 1008736660, 1010975242, 1013175761, 1015338134, 1017462281,
+	1019548121, 1021595575, 1023604567, 1025575020, 1027506862, 1029400018,
+	1031254418, 1033069992, 1034846671, 1036584389, 1038283080, 1039942680,
+	1041563127, 1043144360, 1044686319, 1046188946, 1047652185, 1049075980,
+	1050460278, 1051805027, 1053110176, 1054375676, 1055601479, 1056787540,
+	1057933813, 1059040255, 1060106826, 1061133483, 1062120190, 1063066909,
+	1063973603, 1064840240, 1065666786, 1066453210, 1067199483, 1067905576,
+	1068571464, 1069197120, 1069782521, 1070327646, 1070832474, 1071296985,
+	1071721163, 1072104991, 1072448455, 1072751542, 1073014240, 1073236540,
+	1073418433, 1073559913, 1073660973, 1073721611, 1073741824
+};
+
+// atan(i / 256), binary angle
+static const uint32_t geo_atan_table[GEO_TABLE_SIZE + 1] = {
+	0, 2670163, 5340245, 8010164, 10679838, 13349187,
+	16018129, 18686582, 21354465, 24021698, 26688200, 29353889,
+	32018685, 34682507, 37345276, 40006910, 42667331, 45326458,
+	47984212, 50640513, 53295284, 55948444, 58599915, 61249621,
+	63897482, 66543421, 69187361, 71829226, 74468939, 77106424,
+	79741605, 82374407, 85004756, 87632577, 90257796, 92880340,
+	95500135, 98117110, 100731191, 103342309, 105950391, 108555367,
+	111157167, 113755721, 116350962, 118942819, 121531227, 124116117,
+	126697423, 129275078, 131849018, 134419178, 136985493, 139547900,
+	142106335, 144660738, 147211045, 149757197, 152299132, 154836791,
+	157370116, 159899047, 162423527, 164943499, 167458907, 169969696,
+	172475810, 174977196, 177473799, 179965568, 182452450, 184934394,
+	187411349, 189883266, 192350096, 194811789, 197268300, 199719579,
+	202165583, 204606264, 207041579, 209471483, 211895933, 214314887,
+	216728303, 219136141, 221538359, 223934919, 226325781, 228710908,
+	231090262, 233463808, 235831508, 238193329, 240549235, 242899194,
+	245243172, 247581137, 249913059, 252238905, 254558647, 256872255,
+	259179700, 261480955, 263775993, 266064788, 268347313, 270623543,
+	272893455, 275157025, 277414230, 279665048, 281909457, 284147437,
+	286378966, 288604026, 290822599, 293034664, 295240206, 297439207,
+	299631651, 301817523, 303996806, 306169488, 308335554, 310494991,
+	312647786, 314793928, 316933406, 319066208, 321192324, 323311746,
+	325424463, 327530468, 329629752, 331722309, 333808132, 335887214,
+	337959550, 340025134, 342083962, 344136031, 346181336, 348219874,
+	350251643, 352276640, 354294865, 356306316, 358310992, 360308894,
+	362300021, 364284375, 366261957, 368232767, 370196809, 372154086,
+	374104599, 376048352, 377985350, 379915596, 381839095, 383755852,
+	385665872, 387569162, 389465727, 391355574, 393238710, 395115141,
+	396984877, 398847924, 400704291, 402553986, 404397019, 406233399,
+	408063135, 409886237, 411702716, 413512582, 415315845, 417112518,
+	418902610, 420686135, 422463104, 424233528, 425997422, 427754796,
+	429505665, 431250041, 432987938, 434719370, 436444350, 438162893,
+	439875013, 441580724, 443280042, 444972981, 446659557, 448339785,
+	450013680, 451681259, 453342536, 454997530, 456646255, 458288728,
+	459924966, 461554985, 463178803, 464796437, 466407904, 468013221,
+	469612406, 471205476, 472792449, 474373344, 475948178, 477516969,
+	479079736, 480636498, 482187271, 483732076, 485270931, 486803855,
+	488330866, 489851983, 491367227, 492876615, 494380167, 495877903,
+	497369841, 498856002, 500336404, 501811068, 503280012, 504743258,
+	506200824, 507652730, 509098996, 510539643, 511974689, 513404156,
+	514828063, 516246430, 517659277, 519066625, 520468494, 521864904,
+	523255875, 524641427, 526021581, 527396357, 528765775, 530129856,
+	531488619, 532842087, 534190278, 535533213, 536870912
+};
+
+uint32_t geo_udeg_to_angle(int32_t udeg) {
+	return (uint32_t)(((int64_t)udeg * GEO_ANGLE_PER_UDEG_Q28 + (1 << 27)) >> 28);
+}
+
+/*
+ * Quarter wave table with linear interpolation, the error is below 5e-6.
+ */
+int32_t geo_sin(uint32_t angle) {
+	uint32_t pos = angle & (GEO_ANGLE_90 - 1), idx, frac;
+	int32_t value;
+
+	// Second and fourth quadrants run the table backwards
+	if (angle & GEO_ANGLE_90)
+		pos = GEO_ANGLE_90 - pos;
+
+	idx = pos >> (30 - GEO_TABLE_BITS);
+	frac = pos & ((1 << (30 - GEO_TABLE_BITS)) - 1);
+
+	if (idx >= GEO_TABLE_SIZE) {
+		value = geo_sin_table[GEO_TABLE_SIZE];
+	} else {
+		value = geo_sin_table[idx] + (int32_t)(((int64_t)(geo_sin_table[idx + 1] - geo_sin_table[idx]) * frac)
+				>> (30 - GEO_TABLE_BITS));
+	}
+
+	return (angle & GEO_ANGLE_180) ? -value : value;
+}
+
+int32_t geo_cos(uint32_t angle) {
+	return geo_sin(angle + GEO_ANGLE_90);
+}
+
+/*
+ * atan(num / den) for num <= den, den > 0.
+ */
+static uint32_t geo_atan_ratio(uint32_t num, uint32_t den) {
+	uint32_t ratio = (uint32_t)(((uint64_t)num << 28) / den), idx, frac;
+
+	idx = ratio >> (28 - GEO_TABLE_BITS);
+	frac = ratio & ((1 << (28 - GEO_TABLE_BITS)) - 1);
+
+	if (idx >= GEO_TABLE_SIZE)
+		return geo_atan_table[GEO_TABLE_SIZE];
+
+	return geo_atan_table[idx] + (uint32_t)(((uint64_t)(geo_atan_table[idx + 1] - geo_atan_table[idx]) * frac)
+			>> (28 - GEO_TABLE_BITS));
+}
+
+/*
+ * Angle of the vector (x, y) counterclockwise from the x axis, binary
+ * angle in [0, 2^32). Pass (east, north) to get a compass bearing.
+ */
+uint32_t geo_atan2(int32_t y, int32_t x) {
+	uint32_t ax = x < 0 ? -(uint32_t)x : (uint32_t)x;
+	uint32_t ay = y < 0 ? -(uint32_t)y : (uint32_t)y;
+	uint32_t angle;
+
+	if (ax == 0 && ay == 0)
+		return 0;
+
+	if (ay <= ax)
+		angle = geo_atan_ratio(ay, ax);
+	else
+		angle = GEO_ANGLE_90 - geo_atan_ratio(ax, ay);
+
+	if (x < 0)
+		angle = GEO_ANGLE_180 - angle;
+
+	if (y < 0)
+		angle = -angle;
+
+	return angle;
+}
+
+uint32_t geo_sqrt(uint64_t value) {
+	uint64_t root = 0, bit = (uint64_t)1 << 62;
+
+	while (bit > value)
+		bit >>= 2;
+
+	while (bit) {
+		if (value >= root + bit) {
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+
+		bit >>= 2;
+	}
+
+	return (uint32_t)root;
+}
+
+void geo_normalize(geo_point_t *p) {
+	if (p->latitude > GEO_LATITUDE_MAX)
+		p->latitude = GEO_LATITUDE_MAX;
+	else if (p->latitude < -GEO_LATITUDE_MAX)
+		p->latitude = -GEO_LATITUDE_MAX;
+
+	while (p->longitude >= GEO_LONGITUDE_MAX)
+		p->longitude -= 2 * GEO_LONGITUDE_MAX;
+
+	while (p->longitude < -GEO_LONGITUDE_MAX)
+		p->longitude += 2 * GEO_LONGITUDE_MAX;
+}
+
+// 1/10000 minute to microdegree: * 10^6 / 600000, rounded half away from zero
+static int32_t geo_minutes_to_udeg(int32_t value) {
+	if (value < 0)
+		return -(int32_t)(((uint32_t)-value * 5 + 1) / 3);
+
+	return (int32_t)(((uint32_t)value * 5 + 1) / 3);
+}
+
+/*
+ * Signed 1/10000 minute units as in fix_record_t.
+ */
+void geo_from_minutes(int32_t latitude, int32_t longitude, geo_point_t *p) {
+	p->latitude = geo_minutes_to_udeg(latitude);
+	p->longitude = geo_minutes_to_udeg(longitude);
+
+	geo_normalize(p);
+}
+
+void geo_from_nav(const gps_rmc_state_t *nav, geo_point_t *p) {
+	int32_t latitude = (int32_t)nav->latitude_degrees * 600000 + (int32_t)nav->latitude_seconds;
+	int32_t longitude = (int32_t)nav->longitude_degrees * 600000 + (int32_t)nav->longitude_seconds;
+
+	if (nav->flags & LATITUDE_S)
+		latitude = -latitude;
+
+	if (nav->flags & LONGITUDE_W)
+		longitude = -longitude;
+
+	geo_from_minutes(latitude, longitude, p);
+}
+
+// Longitude difference b - a the short way around
+static int32_t geo_delta_longitude(const geo_point_t *a, const geo_point_t *b) {
+	int32_t delta = b->longitude - a->longitude;
+
+	if (delta >= GEO_LONGITUDE_MAX)
+		delta -= 2 * GEO_LONGITUDE_MAX;
+	else if (delta < -GEO_LONGITUDE_MAX)
+		delta += 2 * GEO_LONGITUDE_MAX;
+
+	return delta;
+}
+
+static uint8_t geo_is_short(int32_t delta_latitude, int32_t delta_longitude) {
+	return delta_latitude <= GEO_FAST_MAX_UDEG && delta_latitude >= -GEO_FAST_MAX_UDEG &&
+			delta_longitude <= GEO_FAST_MAX_UDEG && delta_longitude >= -GEO_FAST_MAX_UDEG;
+}
+
+// Longitude difference scaled by the cosine of the mean latitude, microdegrees of arc
+static int32_t geo_east(const geo_point_t *a, int32_t delta_latitude, int32_t delta_longitude) {
+	int32_t mean = a->latitude + delta_latitude / 2;
+
+	return (int32_t)(((int64_t)delta_longitude * geo_cos(geo_udeg_to_angle(mean))) >> 30);
+}
+
+/*
+ * Equirectangular approximation, cm. Within 0.1% up to GEO_FAST_MAX_UDEG
+ * spans below 80 degrees of latitude, see test_geo.
+ */
+uint32_t geo_distance_fast(const geo_point_t *a, const geo_point_t *b) {
+	int32_t delta_latitude = b->latitude - a->latitude;
+	int64_t east = geo_east(a, delta_latitude, geo_delta_longitude(a, b));
+	uint32_t arc;
+
+	arc = geo_sqrt((uint64_t)(east * east) + (uint64_t)((int64_t)delta_latitude * delta_latitude));
+
+	return (uint32_t)(((uint64_t)arc * GEO_CM_PER_UDEG_Q28 + (1 << 27)) >> 28);
+}
+
+/*
+ * Great circle distance by the haversine formula, cm. The sum under the
+ * root is kept in Q60 so short arcs do not lose their precision.
+ */
+uint32_t geo_distance_haversine(const geo_point_t *a, const geo_point_t *b) {
+	int64_t half_lat = geo_sin(geo_udeg_to_angle((b->latitude - a->latitude) / 2));
+	int64_t half_lon = geo_sin(geo_udeg_to_angle(geo_delta_longitude(a, b) / 2));
+	int64_t cos_product = ((int64_t)geo_cos(geo_udeg_to_angle(a->latitude)) *
+			geo_cos(geo_udeg_to_angle(b->latitude))) >> 30;
+	uint64_t h = (uint64_t)(half_lat * half_lat) + (uint64_t)(((cos_product * half_lon) >> 30) * half_lon);
+	uint32_t arc;
+
+	if (h > GEO_Q60_ONE)
+		h = GEO_Q60_ONE;
+
+	arc = 2 * geo_atan2(geo_sqrt(h), geo_sqrt(GEO_Q60_ONE - h));
+
+	return (uint32_t)(((uint64_t)arc * GEO_CIRCUMFERENCE_CM + ((uint64_t)1 << 31)) >> 32);
+}
+
+/*
+ * Offset of p from origin on the plane tangent at origin, microdegrees of
+ * arc east and north. Good for the same spans as geo_distance_fast().
+ */
+void geo_local(const geo_point_t *origin, const geo_point_t *p, int32_t *east, int32_t *north) {
+	*north = p->latitude - origin->latitude;
+	*east = (int32_t)(((int64_t)geo_delta_longitude(origin, p) * geo_cos(geo_udeg_to_angle(origin->latitude))) >> 30);
+}
+
+uint32_t geo_distance(const geo_point_t *a, const geo_point_t *b) {
+	if (geo_is_short(b->latitude - a->latitude, geo_delta_longitude(a, b)))
+		return geo_distance_fast(a, b);
+
+	return geo_distance_haversine(a, b);
+}
+
+/*
+ * Initial bearing from a to b in 1/100 degrees, same units as
+ * gps_rmc_state_t.course. 0 for coincident points.
+ */
+uint16_t geo_bearing(const geo_point_t *a, const geo_point_t *b) {
+	int32_t delta_latitude = b->latitude - a->latitude;
+	int32_t delta_longitude = geo_delta_longitude(a, b);
+	uint32_t angle;
+
+	if (geo_is_short(delta_latitude, delta_longitude)) {
+		angle = geo_atan2(geo_east(a, delta_latitude, delta_longitude), delta_latitude);
+	} else {
+		uint32_t lat_a = geo_udeg_to_angle(a->latitude), lat_b = geo_udeg_to_angle(b->latitude);
+		uint32_t lon = geo_udeg_to_angle(delta_longitude);
+		int64_t cos_b = geo_cos(lat_b);
+		int64_t east = ((int64_t)geo_sin(lon) * cos_b) >> 30;
+		int64_t north = (((int64_t)geo_cos(lat_a) * geo_sin(lat_b)) >> 30) -
+				(((((int64_t)geo_sin(lat_a) * cos_b) >> 30) * geo_cos(lon)) >> 30);
+
+		angle = geo_atan2((int32_t)east, (int32_t)north);
+	}
+
+	return (uint16_t)(((uint64_t)angle * 36000 + ((uint64_t)1 << 31)) >> 32) % 36000;
+}
+
+/*
+ * Signed turn from one course to another, 1/100 degrees in [-18000, 18000).
+ */
+int16_t geo_course_diff(uint16_t from, uint16_t to) {
+	int32_t diff = ((int32_t)to - from) % 36000;
+
+	if (diff >= 18000)
+		diff -= 36000;
+	else if (diff < -18000)
+		diff += 36000;
+
+	return (int16_t)diff;
+}
+
+/*
+ * Average speed in 1/100 knots, the units of gps_rmc_state_t.speed.
+ */
+uint16_t geo_speed(uint32_t distance_cm, uint32_t time_ms) {
+	uint64_t speed;
+
+	if (time_ms == 0)
+		return 0;
+
+	speed = ((uint64_t)distance_cm * GEO_KNOTS100_PER_CM_MS + (uint64_t)time_ms * 500) / ((uint64_t)time_ms * 1000);
+
+	return speed > 0xFFFF ? 0xFFFF : (uint16_t)speed;
+}
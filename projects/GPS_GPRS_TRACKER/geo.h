@@ -0,0 +1,66 @@
+/*
+ * geo.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef GEO_H_
+#define GEO_H_
+
+#include <stdint.h>
+
+#include "gps_fix.h"
+
+#define GEO_UDEG_PER_DEGREE		1000000
+
+#define GEO_LATITUDE_MAX		(90 * GEO_UDEG_PER_DEGREE)
+#define GEO_LONGITUDE_MAX		(180 * GEO_UDEG_PER_DEGREE)
+
+/*
+ * Spans up to this many microdegrees on both axes (about 11 km) take the
+ * equirectangular fast path, longer ones the table driven haversine.
+ */
+#if !defined(GEO_FAST_MAX_UDEG)
+#define GEO_FAST_MAX_UDEG		100000
+#endif
+
+/*
+ * Position in signed microdegrees, south and west negative. Normalized
+ * points have latitude in [-90, 90] and longitude in [-180, 180) degrees.
+ */
+typedef struct geo_point {
+	int32_t latitude;
+	int32_t longitude;
+} geo_point_t;
+
+extern void geo_from_nav(const gps_rmc_state_t *nav, geo_point_t *p);
+
+extern void geo_from_minutes(int32_t latitude, int32_t longitude, geo_point_t *p);
+
+extern void geo_normalize(geo_point_t *p);
+
+extern uint32_t geo_distance_fast(const geo_point_t *a, const geo_point_t *b);
+
+extern uint32_t geo_distance_haversine(const geo_point_t *a, const geo_point_t *b);
+
+extern uint32_t geo_distance(const geo_point_t *a, const geo_point_t *b);
+
+extern void geo_local(const geo_point_t *origin, const geo_point_t *p, int32_t *east, int32_t *north);
+
+extern uint16_t geo_bearing(const geo_point_t *a, const geo_point_t *b);
+
+extern int16_t geo_course_diff(uint16_t from, uint16_t to);
+
+extern uint16_t geo_speed(uint32_t distance_cm, uint32_t time_ms);
+
+extern int32_t geo_sin(uint32_t angle);
+
+extern int32_t geo_cos(uint32_t angle);
+
+extern uint32_t geo_atan2(int32_t y, int32_t x);
+
+extern uint32_t geo_udeg_to_angle(int32_t udeg);
+
+extern uint32_t geo_sqrt(uint64_t value);
+
+#endif /* GEO_H_ */
@@ -0,0 +1,448 @@
+/*
+ * geofence.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Enter and exit detection for circles and polygons. A fix is tested
+ * against the fences it was inside of and the fences listed in its grid
+ * cell. The grid grows with the fences and is sized by their extent, so
+ * the work per fix depends on how densely the fences lie around the fix,
+ * not on how many are loaded. Fences must not cross the antimeridian.
+ */
+
+#include "geofence.h"
+
+#include <string.h>
+
+#define GEOFENCE_ALIGN(X)		(((X) + 3) & ~(size_t)3)
+
+// Microdegrees of arc per km on the mean radius
+#define GEOFENCE_UDEG_PER_KM	8993
+
+typedef struct geofence_box {
+	int32_t south;
+	int32_t west;
+	int32_t north;
+	int32_t east;
+} geofence_box_t;
+
+static uint32_t geofence_radius_udeg(uint32_t radius_cm) {
+	return (uint32_t)((uint64_t)radius_cm * GEOFENCE_UDEG_PER_KM / 100000) + 1;
+}
+
+static void geofence_bounds(const geofence_def_t *def, geofence_box_t *box) {
+	uint32_t r, r_lon;
+	int32_t cos_lat;
+	uint16_t i;
+
+	if (def->type == GEOFENCE_CIRCLE) {
+		r = geofence_radius_udeg(def->radius_m * 100);
+		cos_lat = geo_cos(geo_udeg_to_angle(def->center.latitude));
+
+		// Longitude degrees shrink with the cosine of the latitude
+		if (cos_lat <= 0 || ((uint64_t)r << 30) / cos_lat > GEO_LONGITUDE_MAX)
+			r_lon = GEO_LONGITUDE_MAX;
+		else
+			r_lon = (uint32_t)(((uint64_t)r << 30) / cos_lat) + 1;
+
+		box->south = def->center.latitude - (int32_t)r;
+		box->north = def->center.latitude + (int32_t)r;
+		box->west = def->center.longitude - (int32_t)r_lon;
+		box->east = def->center.longitude + (int32_t)r_lon;
+
+		return;
+	}
+
+	box->south = box->north = def->vertices[0].latitude;
+	box->west = box->east = def->vertices[0].longitude;
+
+	for (i = 1; i < def->vertex_count; i++) {
+		if (def->vertices[i].latitude < box->south)
+			box->south = def->vertices[i].latitude;
+
+		if (def->vertices[i].latitude > box->north)
+			box->north = def->vertices[i].latitude;
+
+		if (def->vertices[i].longitude < box->west)
+			box->west = def->vertices[i].longitude;
+
+		if (def->vertices[i].longitude > box->east)
+			box->east = def->vertices[i].longitude;
+	}
+}
+
+// Range of grid cells the box overlaps, clipped to the grid
+static void geofence_cell_range(const geofence_header_t *h, const geofence_box_t *box,
+		uint16_t *row0, uint16_t *row1, uint16_t *col0, uint16_t *col1) {
+	*row0 = (uint16_t)(((int64_t)box->south - h->latitude) / h->cell_latitude);
+	*row1 = (uint16_t)(((int64_t)box->north - h->latitude) / h->cell_latitude);
+	*col0 = (uint16_t)(((int64_t)box->west - h->longitude) / h->cell_longitude);
+	*col1 = (uint16_t)(((int64_t)box->east - h->longitude) / h->cell_longitude);
+
+	if (*row1 >= h->rows)
+		*row1 = h->rows - 1;
+
+	if (*col1 >= h->cols)
+		*col1 = h->cols - 1;
+}
+
+/*
+ * Writes the image of the given fences into buf. Returns its size, 0 when
+ * a fence is invalid or the image does not fit.
+ */
+size_t geofence_build(const geofence_def_t *defs, uint16_t count, uint8_t *buf, size_t size) {
+	geofence_header_t *h = (geofence_header_t *)buf;
+	geofence_box_t box, all;
+	geofence_rec_t *rec;
+	uint32_t *cells;
+	uint16_t *list, *vertices;
+	uint32_t vertex_count = 0, list_count = 0, cell, cell_count, span;
+	uint16_t i, j, row, col, row0, row1, col0, col1;
+	uint64_t width, height, extent = 0, target;
+	size_t total;
+
+	if (count == 0 || size < sizeof(*h))
+		return 0;
+
+	for (i = 0; i < count; i++) {
+		if (defs[i].type == GEOFENCE_POLYGON && (defs[i].vertices == NULL || defs[i].vertex_count < 3))
+			return 0;
+
+		if (defs[i].type != GEOFENCE_POLYGON && defs[i].type != GEOFENCE_CIRCLE)
+			return 0;
+
+		geofence_bounds(&defs[i], &box);
+
+		if (i == 0)
+			all = box;
+
+		if (box.south < all.south)
+			all.south = box.south;
+
+		if (box.north > all.north)
+			all.north = box.north;
+
+		if (box.west < all.west)
+			all.west = box.west;
+
+		if (box.east > all.east)
+			all.east = box.east;
+
+		if (defs[i].type == GEOFENCE_POLYGON)
+			vertex_count += defs[i].vertex_count;
+
+		span = (uint32_t)(box.north - box.south);
+
+		if ((uint32_t)(box.east - box.west) > span)
+			span = (uint32_t)(box.east - box.west);
+
+		extent += (uint64_t)span + 1;
+	}
+
+	// Grid with roughly square cells in degrees over the box of all fences
+	memset(h, 0, sizeof(*h));
+
+	width = (uint64_t)((int64_t)all.east - all.west) + 1;
+	height = (uint64_t)((int64_t)all.north - all.south) + 1;
+	extent /= count;
+
+	// Cells of half the mean fence size, a fence then lies in about 9 of them
+	target = width * height / (extent * extent / 4 + 1);
+
+	if (target < (uint64_t)count * GEOFENCE_CELLS_PER_FENCE_MIN)
+		target = (uint64_t)count * GEOFENCE_CELLS_PER_FENCE_MIN;
+	else if (target > (uint64_t)count * GEOFENCE_CELLS_PER_FENCE_MAX)
+		target = (uint64_t)count * GEOFENCE_CELLS_PER_FENCE_MAX;
+
+	cell_count = geo_sqrt(target * width / height);
+
+	if (cell_count == 0)
+		cell_count = 1;
+	else if (cell_count > target)
+		cell_count = (uint32_t)target;
+
+	if (cell_count > 0xFFFF)
+		cell_count = 0xFFFF;
+
+	h->cols = (uint16_t)cell_count;
+	h->rows = (uint16_t)(target / cell_count < 0xFFFF ? target / cell_count : 0xFFFF);
+
+	h->latitude = all.south;
+	h->longitude = all.west;
+	h->cell_latitude = (uint32_t)((height + h->rows - 1) / h->rows);
+	h->cell_longitude = (uint32_t)((width + h->cols - 1) / h->cols);
+
+	cell_count = (uint32_t)h->cols * h->rows;
+
+	for (i = 0; i < count; i++) {
+		geofence_bounds(&defs[i], &box);
+		geofence_cell_range(h, &box, &row0, &row1, &col0, &col1);
+		list_count += (uint32_t)(row1 - row0 + 1) * (col1 - col0 + 1);
+	}
+
+	h->cells_offset = GEOFENCE_ALIGN(sizeof(*h));
+	h->list_offset = GEOFENCE_ALIGN(h->cells_offset + ((size_t)cell_count + 1) * sizeof(uint32_t));
+	h->fences_offset = GEOFENCE_ALIGN(h->list_offset + list_count * sizeof(uint16_t));
+	h->vertices_offset = h->fences_offset + count * sizeof(geofence_rec_t);
+	total = h->vertices_offset + vertex_count * 2 * sizeof(uint16_t);
+
+	if (total > size)
+		return 0;
+
+	memset(buf + sizeof(*h), 0, total - sizeof(*h));
+
+	h->magic[0] = GEOFENCE_MAGIC_1;
+	h->magic[1] = GEOFENCE_MAGIC_2;
+	h->version = GEOFENCE_VERSION;
+	h->fence_count = count;
+	h->list_count = list_count;
+	h->size = (uint32_t)total;
+
+	cells = (uint32_t *)(buf + h->cells_offset);
+	list = (uint16_t *)(buf + h->list_offset);
+	rec = (geofence_rec_t *)(buf + h->fences_offset);
+	vertices = (uint16_t *)(buf + h->vertices_offset);
+
+	// Fences per cell, then the start of each cell
+	for (i = 0; i < count; i++) {
+		geofence_bounds(&defs[i], &box);
+		geofence_cell_range(h, &box, &row0, &row1, &col0, &col1);
+
+		for (row = row0; row <= row1; row++) {
+			for (col = col0; col <= col1; col++)
+				cells[(uint32_t)row * h->cols + col + 1]++;
+		}
+	}
+
+	for (cell = 1; cell <= cell_count; cell++) {
+		if (cells[cell] > h->cell_max)
+			h->cell_max = (uint16_t)cells[cell];
+
+		cells[cell] += cells[cell - 1];
+	}
+
+	// Fill with cells[] as write cursors, they end up one cell ahead
+	for (i = 0; i < count; i++) {
+		geofence_bounds(&defs[i], &box);
+		geofence_cell_range(h, &box, &row0, &row1, &col0, &col1);
+
+		for (row = row0; row <= row1; row++) {
+			for (col = col0; col <= col1; col++)
+				list[cells[(uint32_t)row * h->cols + col]++] = i;
+		}
+	}
+
+	memmove(cells + 1, cells, cell_count * sizeof(uint32_t));
+	cells[0] = 0;
+
+	vertex_count = 0;
+
+	for (i = 0; i < count; i++, rec++) {
+		rec->id = defs[i].id;
+		rec->type = defs[i].type;
+
+		if (defs[i].type == GEOFENCE_CIRCLE) {
+			rec->latitude = defs[i].center.latitude;
+			rec->longitude = defs[i].center.longitude;
+			rec->value = defs[i].radius_m * 100;
+			continue;
+		}
+
+		geofence_bounds(&defs[i], &box);
+
+		span = (uint32_t)(box.north - box.south);
+
+		if ((uint32_t)(box.east - box.west) > span)
+			span = (uint32_t)(box.east - box.west);
+
+		while ((span >> rec->shift) > 0xFFFF)
+			rec->shift++;
+
+		rec->latitude = box.south;
+		rec->longitude = box.west;
+		rec->height = (uint16_t)((uint32_t)(box.north - box.south) >> rec->shift);
+		rec->width = (uint16_t)((uint32_t)(box.east - box.west) >> rec->shift);
+		rec->vertex_count = defs[i].vertex_count;
+		rec->value = vertex_count;
+
+		for (j = 0; j < defs[i].vertex_count; j++, vertex_count++) {
+			vertices[2 * vertex_count] = (uint16_t)((uint32_t)(defs[i].vertices[j].latitude - box.south) >> rec->shift);
+			vertices[2 * vertex_count + 1] = (uint16_t)((uint32_t)(defs[i].vertices[j].longitude - box.west) >> rec->shift);
+		}
+	}
+
+	return total;
+}
+
+/*
+ * Checks the image and starts with no fence entered.
+ */
+uint8_t geofence_open(geofence_t *gf, const uint8_t *image, size_t len) {
+	const geofence_header_t *h = (const geofence_header_t *)image;
+	uint32_t cell_count;
+
+	memset(gf, 0, sizeof(*gf));
+
+	if (len < sizeof(*h) || ((uintptr_t)image & 3) != 0)
+		return GEOFENCE_ERR_FORMAT;
+
+	if (h->magic[0] != GEOFENCE_MAGIC_1 || h->magic[1] != GEOFENCE_MAGIC_2 || h->version != GEOFENCE_VERSION)
+		return GEOFENCE_ERR_FORMAT;
+
+	if (h->size > len || h->cols == 0 || h->rows == 0 || h->cell_latitude == 0 || h->cell_longitude == 0)
+		return GEOFENCE_ERR_SIZE;
+
+	cell_count = (uint32_t)h->cols * h->rows;
+
+	if (h->cells_offset + ((uint64_t)cell_count + 1) * sizeof(uint32_t) > h->list_offset ||
+			h->list_offset + (uint64_t)h->list_count * sizeof(uint16_t) > h->fences_offset ||
+			h->fences_offset + h->fence_count * sizeof(geofence_rec_t) > h->vertices_offset ||
+			h->vertices_offset > h->size)
+		return GEOFENCE_ERR_SIZE;
+
+	gf->header = h;
+	gf->cells = (const uint32_t *)(image + h->cells_offset);
+	gf->list = (const uint16_t *)(image + h->list_offset);
+	gf->fences = (const geofence_rec_t *)(image + h->fences_offset);
+	gf->vertices = (const uint16_t *)(image + h->vertices_offset);
+
+	if (gf->cells[cell_count] != h->list_count)
+		return GEOFENCE_ERR_FORMAT;
+
+	return GEOFENCE_OK;
+}
+
+/*
+ * Even-odd rule on the polygon vertices, the fix is scaled to the same
+ * units first. Points on the edge may go either way.
+ */
+static uint8_t geofence_in_polygon(const geofence_t *gf, const geofence_rec_t *rec, const geo_point_t *p) {
+	const uint16_t *v = gf->vertices + 2 * rec->value;
+	int32_t y = p->latitude - rec->latitude, x = p->longitude - rec->longitude;
+	int32_t yi, xi, yj, xj;
+	int64_t lhs, rhs;
+	uint16_t i, j;
+	uint8_t inside = 0;
+
+	if (y < 0 || x < 0)
+		return 0;
+
+	y >>= rec->shift;
+	x >>= rec->shift;
+
+	if (y > rec->height || x > rec->width)
+		return 0;
+
+	for (i = 0, j = rec->vertex_count - 1; i < rec->vertex_count; j = i++) {
+		yi = v[2 * i];
+		xi = v[2 * i + 1];
+		yj = v[2 * j];
+		xj = v[2 * j + 1];
+
+		if ((yi > y) == (yj > y))
+			continue;
+
+		// x left of the edge at the height of y
+		lhs = (int64_t)(x - xi) * (yj - yi);
+		rhs = (int64_t)(xj - xi) * (y - yi);
+
+		if (yj > yi ? lhs < rhs : lhs > rhs)
+			inside ^= 1;
+	}
+
+	return inside;
+}
+
+uint8_t geofence_contains(const geofence_t *gf, uint16_t index, const geo_point_t *p) {
+	const geofence_rec_t *rec = &gf->fences[index];
+	geo_point_t center;
+	int32_t delta;
+
+	if (rec->type == GEOFENCE_POLYGON)
+		return geofence_in_polygon(gf, rec, p);
+
+	// Quick reject on latitude alone
+	delta = p->latitude - rec->latitude;
+
+	if ((uint32_t)(delta < 0 ? -delta : delta) > geofence_radius_udeg(rec->value))
+		return 0;
+
+	center.latitude = rec->latitude;
+	center.longitude = rec->longitude;
+
+	return geo_distance(&center, p) <= rec->value;
+}
+
+static void geofence_emit(geofence_t *gf, uint16_t index, uint8_t type, geofence_event_t *events,
+		uint8_t max_events, uint8_t *n) {
+	gf->stats.events++;
+
+	if (*n >= max_events)
+		return;
+
+	events[*n].id = gf->fences[index].id;
+	events[*n].type = type;
+	(*n)++;
+}
+
+/*
+ * Updates the fences the fix is inside of and writes the enter and exit
+ * events into events, exits first. Returns the number of events.
+ */
+uint8_t geofence_check(geofence_t *gf, const geo_point_t *p, geofence_event_t *events, uint8_t max_events) {
+	const geofence_header_t *h = gf->header;
+	int64_t row, col;
+	uint32_t cell, k;
+	uint16_t index;
+	uint8_t i, n = 0;
+
+	if (h == NULL)
+		return 0;
+
+	gf->stats.fixes++;
+
+	for (i = 0; i < gf->inside_count;) {
+		gf->stats.tests++;
+
+		if (geofence_contains(gf, gf->inside[i], p)) {
+			i++;
+			continue;
+		}
+
+		geofence_emit(gf, gf->inside[i], GEOFENCE_EXIT, events, max_events, &n);
+		gf->inside[i] = gf->inside[--gf->inside_count];
+	}
+
+	row = ((int64_t)p->latitude - h->latitude) / h->cell_latitude;
+	col = ((int64_t)p->longitude - h->longitude) / h->cell_longitude;
+
+	if (p->latitude < h->latitude || p->longitude < h->longitude || row >= h->rows || col >= h->cols)
+		return n;
+
+	cell = (uint32_t)row * h->cols + (uint32_t)col;
+
+	for (k = gf->cells[cell]; k < gf->cells[cell + 1]; k++) {
+		index = gf->list[k];
+
+		for (i = 0; i < gf->inside_count && gf->inside[i] != index; i++)
+			;
+
+		if (i < gf->inside_count)
+			continue;
+
+		gf->stats.tests++;
+
+		if (!geofence_contains(gf, index, p))
+			continue;
+
+		if (gf->inside_count == GEOFENCE_MAX_INSIDE) {
+			gf->stats.overflows++;
+			continue;
+		}
+
+		gf->inside[gf->inside_count++] = index;
+		geofence_emit(gf, index, GEOFENCE_ENTER, events, max_events, &n);
+	}
+
+	return n;
+}
@@ -0,0 +1,167 @@
+/*
+ * geofence.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef GEOFENCE_H_
+#define GEOFENCE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "geo.h"
+
+#define GEOFENCE_MAGIC_1		'G'
+#define GEOFENCE_MAGIC_2		'F'
+#define GEOFENCE_VERSION		2
+
+// Fences the device can be inside of at the same time
+#if !defined(GEOFENCE_MAX_INSIDE)
+#define GEOFENCE_MAX_INSIDE		16
+#endif
+
+/*
+ * Grid cells per fence the builder uses, each costs 4 bytes of index. The
+ * fewest keep the fences per cell at the fence density, more go to fences
+ * that are small against the area they are spread over.
+ */
+#if !defined(GEOFENCE_CELLS_PER_FENCE_MIN)
+#define GEOFENCE_CELLS_PER_FENCE_MIN	4
+#endif
+
+#if !defined(GEOFENCE_CELLS_PER_FENCE_MAX)
+#define GEOFENCE_CELLS_PER_FENCE_MAX	16
+#endif
+
+typedef enum GEOFENCE_TYPE {
+	GEOFENCE_CIRCLE			=	0x01,
+	GEOFENCE_POLYGON		=	0x02
+} GEOFENCE_TYPE;
+
+typedef enum GEOFENCE_EVENT {
+	GEOFENCE_ENTER			=	0x01,
+	GEOFENCE_EXIT			=	0x02
+} GEOFENCE_EVENT;
+
+typedef enum GEOFENCE_RESULT {
+	GEOFENCE_OK				=	0x00,
+	GEOFENCE_ERR_FORMAT		=	0x01,
+	GEOFENCE_ERR_SIZE		=	0x02
+} GEOFENCE_RESULT;
+
+/*
+ * Fence image, built once (geofence_build()) and read in place from
+ * flash. All parts are 4 byte aligned, offsets are from the image start:
+ *   header
+ *   cells    - uint32_t start of each cell in the list, cols * rows + 1
+ *   list     - uint16_t fence indices, fences overlapping each cell
+ *   fences   - geofence_rec_t, by index
+ *   vertices - uint16_t latitude, longitude pairs of the polygons
+ * The grid covers the bounding box of all fences, a fix outside it
+ * is tested against no fence at all.
+ */
+typedef struct geofence_header {
+	uint8_t magic[2];
+	uint8_t version;
+	uint8_t reserved;
+
+	uint16_t fence_count;
+	uint16_t cols;
+	uint16_t rows;
+
+	// Most fences listed in one cell
+	uint16_t cell_max;
+
+	uint32_t list_count;
+
+	// South-west grid corner and cell size, microdegrees
+	int32_t latitude;
+	int32_t longitude;
+	uint32_t cell_latitude;
+	uint32_t cell_longitude;
+
+	uint32_t cells_offset;
+	uint32_t list_offset;
+	uint32_t fences_offset;
+	uint32_t vertices_offset;
+	uint32_t size;
+} geofence_header_t;
+
+/*
+ * Circle: center and radius in cm.
+ * Polygon: south-west corner of its bounding box, the box size and the
+ * vertices as offsets from the corner, all in units of 2^shift
+ * microdegrees so they fit 16 bits. value is the first vertex pair.
+ */
+typedef struct geofence_rec {
+	uint16_t id;
+	uint8_t type;
+	uint8_t shift;
+
+	int32_t latitude;
+	int32_t longitude;
+
+	uint16_t height;
+	uint16_t width;
+	uint16_t vertex_count;
+	uint16_t reserved;
+
+	uint32_t value;
+} geofence_rec_t;
+
+// Fence as given to the builder
+typedef struct geofence_def {
+	uint16_t id;
+	uint8_t type;
+
+	geo_point_t center;
+	uint32_t radius_m;
+
+	const geo_point_t *vertices;
+	uint16_t vertex_count;
+} geofence_def_t;
+
+typedef struct geofence_event {
+	uint16_t id;
+	uint8_t type;
+} geofence_event_t;
+
+typedef struct geofence_stats {
+	uint32_t fixes;
+
+	// Fences tested, at most GEOFENCE_MAX_INSIDE plus cell_max per fix
+	uint32_t tests;
+
+	uint32_t events;
+
+	// Entered fences not tracked because GEOFENCE_MAX_INSIDE were already
+	uint32_t overflows;
+
+	// Events the uplink lost to a full event frame, kept by uplink.c
+	uint32_t dropped;
+} geofence_stats_t;
+
+typedef struct geofence {
+	const geofence_header_t *header;
+	const uint32_t *cells;
+	const uint16_t *list;
+	const geofence_rec_t *fences;
+	const uint16_t *vertices;
+
+	// Indices of the fences the last fix was inside of
+	uint16_t inside[GEOFENCE_MAX_INSIDE];
+	uint8_t inside_count;
+
+	geofence_stats_t stats;
+} geofence_t;
+
+extern size_t geofence_build(const geofence_def_t *defs, uint16_t count, uint8_t *buf, size_t size);
+
+extern uint8_t geofence_open(geofence_t *gf, const uint8_t *image, size_t len);
+
+extern uint8_t geofence_contains(const geofence_t *gf, uint16_t index, const geo_point_t *p);
+
+extern uint8_t geofence_check(geofence_t *gf, const geo_point_t *p, geofence_event_t *events, uint8_t max_events);
+
+#endif /* GEOFENCE_H_ */
@@ -6,191 +6,389 @@
 #include <string.h>
 
 #include "util.h"
+#include "at.h"
 #include "led.h"
+#include "uplink.h"
+#include "motion.h"
+#include "power.h"
 
-#define GPRS_CMD_BUF	256
-#define ATZ_RETRY		5
-#define CMD_WAIT_TIME	250
+#define GPRS_RESP_BUF			32
+#define ATZ_RETRY				5
 
+// Bearer activation and socket creation wait for the network
+#define GPRS_BEARER_TIMEOUT		S2ST(30)
+#define GPRS_SOCKET_TIMEOUT		S2ST(10)
+
+// Time the modem needs after power on before it answers AT commands
+#define GPRS_POWER_UP_S			5
+
+// Uplink batch age is checked at least this often without any events
+#define GPRS_IDLE_TIMEOUT		S2ST(5)
+
+#define GPRS_EVENT_SERIAL		0
+#define GPRS_EVENT_FIX			1
+#define GPRS_EVENT_MOTION		2
+#define GPRS_EVENT_POWER		3
+
+#if !defined(GPRS_SERIAL)
 #define GPRS_SERIAL		SD2
+#endif
 
+#define GPRS_ETX		0x03
+#define GPRS_DLE		0x10
+
+#if defined(SIMULATOR)
+// Simulated ports are TCP sockets without line settings or open drain pads
+#define GPRS_SERIAL_CONFIG		NULL
+#define GPRS_RESET_PAD_MODE		PAL_MODE_OUTPUT_PUSHPULL
+#else
 SerialConfig SD2_Config = {
 		.sc_speed = 115200,
 		.sc_cr2 = USART_CR2_STOP1_BITS,
 		.sc_cr3 = USART_CR3_RTSE | USART_CR3_CTSE
 };
 
-uint8_t *gprs_data = NULL;
+#define GPRS_SERIAL_CONFIG		&SD2_Config
+#define GPRS_RESET_PAD_MODE		PAL_MODE_OUTPUT_OPENDRAIN
+#endif
+
+static uint8_t gprs_state = GPRS_STATE_POWER_UP;
+
+// Registration as reported by +CREG and +CGREG
+static uint8_t gprs_registered = FALSE;
+static uint8_t gprs_attached = FALSE;
+
+// Failures in a row at the current state
+static uint8_t gprs_state_failures;
+static uint8_t gprs_failed_state;
+static systime_t gprs_failed_at;
 
-static WORKING_AREA(waGPRSThread, 256);
+static uint8_t gprs_connecting = FALSE;
+static systime_t gprs_connect_started;
+
+static gprs_stats_t gprs_stats;
+
+static void gprs_on_creg(const at_line_t *line);
+static void gprs_on_cgreg(const at_line_t *line);
+static void gprs_on_peer_close(const at_line_t *line);
+
+static uint8_t gprs_connect(uint8_t target);
+
+static WORKING_AREA(waGPRSThread, 512);
 static msg_t GPRSThread(void *arg) {
 	(void)arg;
 
-	if (gprs_data != NULL) {
-		chHeapFree(gprs_data);
-	}
+	EventListener serial_listener, fix_listener, motion_listener, power_listener;
+	eventmask_t events;
+	power_state_t power;
+	uint8_t power_flags = 0;
 
-	gprs_data = chHeapAlloc(NULL, GPRS_CMD_BUF);
-	size_t gprs_bytes_read;
-	uint16_t signal_level;
-	uint16_t i;
-	char num_buf[16];
-	uint8_t num_len;
 	chRegSetThreadName("gprs_thread");
 
-	if (gprs_data == NULL) {
-		while (TRUE) {
-			//palTogglePad(GPIO_LED_1_PORT, GPIO_LED_1_PIN);
-			chThdSleepMilliseconds(50);
-		}
-	}
-
-	sdStart(&GPRS_SERIAL, &SD2_Config);
+	sdStart(&GPRS_SERIAL, GPRS_SERIAL_CONFIG);
+	at_init((BaseChannel *)&GPRS_SERIAL);
+	at_urc_register(AT_URC_CREG, gprs_on_creg);
+	at_urc_register(AT_URC_CGREG, gprs_on_cgreg);
+	at_urc_register(AT_URC_WIPPEERCLOSE, gprs_on_peer_close);
 	palSetPadMode(GPRS_USART_PORT, GPRS_USART_TX_PIN, PAL_MODE_ALTERNATE(7));
 	palSetPadMode(GPRS_USART_PORT, GPRS_USART_RX_PIN, PAL_MODE_ALTERNATE(7));
 	palSetPadMode(GPRS_USART_PORT, GPRS_USART_CTS_PIN, PAL_MODE_ALTERNATE(7));
 	palSetPadMode(GPRS_USART_PORT, GPRS_USART_RTS_PIN, PAL_MODE_ALTERNATE(7));
 
 	palSetPadMode(GPIO_GPRS_PWR_BAT_PORT, GPIO_GPRS_PWR_BAT_PIN, PAL_MODE_OUTPUT_PUSHPULL);
-	palSetPadMode(GPIO_GPRS_RESET_PORT, GPIO_GPRS_RESET_PIN, PAL_MODE_OUTPUT_OPENDRAIN);
+	palSetPadMode(GPIO_GPRS_RESET_PORT, GPIO_GPRS_RESET_PIN, GPRS_RESET_PAD_MODE);
 
-	// Turn on GPRS power
-	palClearPad(GPIO_GPRS_PWR_BAT_PORT, GPIO_GPRS_PWR_BAT_PIN);
+	uplink_init();
 
-	chThdSleepSeconds(5);
+	chEvtRegister(chIOGetEventSource(&GPRS_SERIAL), &serial_listener, GPRS_EVENT_SERIAL);
+	chEvtRegister(&gps_fix_event, &fix_listener, GPRS_EVENT_FIX);
+	chEvtRegister(&motion_event, &motion_listener, GPRS_EVENT_MOTION);
+	chEvtRegister(&power_event, &power_listener, GPRS_EVENT_POWER);
 
 	while (TRUE) {
-		//palTogglePad(GPIO_LED_1_PORT, GPIO_LED_1_PIN);
+		// Keep the modem registered, the socket is opened on demand by the uplink
+		if (gprs_state < GPRS_STATE_REGISTERED)
+			gprs_connect(GPRS_STATE_REGISTERED);
 
-		if (init_modem() == E_OK)
-			break;
-	}
+		uplink_poll();
 
-	set_led_0_prescaler(5);
+		// Sleep until the modem says something, a new fix is there or a retry is due
+		events = chEvtWaitAnyTimeout(ALL_EVENTS, GPRS_IDLE_TIMEOUT);
 
-	uint8_t counter = 0;
+		// Just parked: the last position goes out now, no fixes follow until it moves
+		if ((events & EVENT_MASK(GPRS_EVENT_MOTION)) && !motion_is_moving())
+			uplink_request_flush();
 
-	while (TRUE) {
-		counter++;
-		if (counter == 10) {
-			counter = 0;
-			send_tcp_message();
-		}
+		// External supply cut or battery running low: report while there is power to
+		if (events & EVENT_MASK(GPRS_EVENT_POWER)) {
+			power_get_state(&power);
 
-		//palTogglePad(GPIO_LED_1_PORT, GPIO_LED_1_PIN);
+			if (((power_flags & POWERMON_EXT) && !(power.flags & POWERMON_EXT)) ||
+					(!(power_flags & POWERMON_BAT_LOW) && (power.flags & POWERMON_BAT_LOW)))
+				uplink_request_flush();
 
-		if (is_gprs_network_ok() == TRUE) {
-			//sdWrite(&SD1, "NETWORK REGISTERED", sizeof("NETWORK REGISTERED") - 1);
-		} else {
-			//sdWrite(&SD1, "NO NETWORK", sizeof("NO NETWORK") - 1);
+			power_flags = power.flags;
 		}
 
-		chThdSleepMilliseconds(100);
+		at_poll();
+	}
+}
 
-		if (gprs_get_signal_level(&signal_level) == E_OK) {
+static void gprs_set_state(uint8_t state) {
+	gprs_state = state;
+	gprs_state_failures = 0;
 
-		/*	sdWrite(&SD1, "SIGNAL LEVEL: ", sizeof("SIGNAL LEVEL: ") - 1);
-			stoa(signal_level, num_buf, &num_len);
-			sdWrite(&SD1, num_buf, num_len - 1);
-			sdWrite(&SD1, "\r\n", sizeof("\r\n") - 1);*/
+	if (state >= GPRS_STATE_BEARER_UP)
+		led_set_pattern(LED_GPRS, LED_PATTERN_GPRS_ONLINE);
+	else if (state == GPRS_STATE_REGISTERED)
+		led_set_pattern(LED_GPRS, LED_PATTERN_GPRS_REGISTERED);
+	else
+		led_set_pattern(LED_GPRS, LED_PATTERN_GPRS_SEARCH);
+}
 
-		} else {
-			//sdWrite(&SD1, "SIGNAL LEVEL: ERR\r\n", sizeof("SIGNAL LEVEL: ERR\r\n") - 1);
-		}
+/*
+ * Link went down without being asked to.
+ */
+static void gprs_link_lost(uint8_t state) {
+	if (gprs_state == GPRS_STATE_STREAMING)
+		gprs_stats.drops++;
+
+	gprs_set_state(state);
+}
+
+static void gprs_on_network_change() {
+	uint8_t up = gprs_registered || gprs_attached;
 
-		chThdSleepMilliseconds(1000);
+	if (!up && gprs_state >= GPRS_STATE_REGISTERED) {
+		gprs_link_lost(GPRS_STATE_REGISTERING);
+	} else if (up && gprs_state == GPRS_STATE_REGISTERING) {
+		gprs_set_state(GPRS_STATE_REGISTERED);
 	}
+}
+
+static void gprs_on_creg(const at_line_t *line) {
+	// "+CREG: <stat>[,<lac>,<ci>]"
+	int16_t stat = at_line_param(line, 0);
 
-	chHeapFree(gprs_data);
+	gprs_registered = (stat == 1 || stat == 5);
+	gprs_on_network_change();
 }
 
-uint8_t init_modem() {
-	uint16_t i;
-	uint16_t bytes_read;
+static void gprs_on_cgreg(const at_line_t *line) {
+	int16_t stat = at_line_param(line, 0);
 
-	for (i = 0; i < ATZ_RETRY; i++) {
-		sdWrite(&GPRS_SERIAL, "ATE0\r\n", sizeof("ATE0\r\n"));
-		chThdSleepMilliseconds(200);
+	gprs_attached = (stat == 1 || stat == 5);
+	gprs_on_network_change();
+}
 
-		if (gprs_cmd("ATZ\r\n", sizeof("ATZ\r\n") - 1, "\r\nOK\r\n", sizeof("\r\nOK\r\n") - 1) == E_OK)
-			break;
+static void gprs_on_peer_close(const at_line_t *line) {
+	(void)line;
 
-		chThdSleepMilliseconds(500);
-	}
+	// Socket is gone, the bearer stays up
+	if (gprs_state == GPRS_STATE_STREAMING)
+		gprs_link_lost(GPRS_STATE_BEARER_UP);
+}
 
-	if (i >= ATZ_RETRY)
-		return E_NOT_RESPONDING;
+static uint32_t gprs_backoff_s() {
+	uint32_t backoff = GPRS_BACKOFF_MIN_S;
+	uint8_t i;
 
+	if (gprs_stats.failures == 0)
+		return 0;
 
-	return E_OK;
+	for (i = 1; i < gprs_stats.failures && backoff < GPRS_BACKOFF_MAX_S; i++)
+		backoff <<= 1;
+
+	return backoff < GPRS_BACKOFF_MAX_S ? backoff : GPRS_BACKOFF_MAX_S;
 }
 
-uint8_t gprs_cmd(char * cmd_str, uint16_t cmd_len, char * answer_str, uint16_t answer_len) {
-	uint16_t bytes_read;
+static void gprs_power_cycle() {
+	// Power switch is active low
+	palSetPad(GPIO_GPRS_PWR_BAT_PORT, GPIO_GPRS_PWR_BAT_PIN);
+	chThdSleepSeconds(1);
+	palClearPad(GPIO_GPRS_PWR_BAT_PORT, GPIO_GPRS_PWR_BAT_PIN);
 
-	// Flush buffer
-	sdAsynchronousRead(&GPRS_SERIAL, gprs_data, GPRS_CMD_BUF);
+	chThdSleepSeconds(GPRS_POWER_UP_S);
 
-	sdWrite(&GPRS_SERIAL, cmd_str, cmd_len);
-	chThdSleepMilliseconds(CMD_WAIT_TIME);
+	gprs_registered = FALSE;
+	gprs_attached = FALSE;
 
-	if (answer_str == NULL) {
-		return E_OK;
+	gprs_stats.power_cycles++;
+}
+
+static uint8_t gprs_bearer_open() {
+	// Enable embedded TCP/IP stack, ERROR means it is already running
+	at_cmd("AT+WIPCFG=1", AT_CMD_TIMEOUT);
+
+	// Open GPRS bearer
+	at_cmd("AT+WIPBR=1,6", AT_CMD_TIMEOUT);
+
+	// Set GPRS AP
+	if (at_cmd("AT+WIPBR=2,6,11,\"internet\"", AT_CMD_TIMEOUT) != AT_OK)
+		return E_GPRS_CONNECT_ERROR;
+
+	// Connect to GPRS
+	if (at_cmd("AT+WIPBR=4,6,0", GPRS_BEARER_TIMEOUT) != AT_OK)
+		return E_GPRS_CONNECT_ERROR;
+
+	return E_OK;
+}
+
+static uint8_t gprs_socket_open() {
+	// Establish connection, the socket is usable after +WIPREADY
+	if (at_cmd("AT+WIPCREATE=2,1,\"195.209.231.43\",5555", AT_CMD_TIMEOUT) != AT_OK)
+		return E_GPRS_CONNECT_ERROR;
+
+	if (at_wait_urc(AT_URC_WIPREADY, GPRS_SOCKET_TIMEOUT) != AT_OK) {
+		at_cmd("AT+WIPCLOSE=2,1", AT_CMD_TIMEOUT);
+		return E_GPRS_CONNECT_ERROR;
 	}
 
-	bytes_read = sdAsynchronousRead(&GPRS_SERIAL, gprs_data, answer_len);
+	return E_OK;
+}
 
-	if (bytes_read == answer_len) {
-		if (strncmp(gprs_data, answer_str, bytes_read) == 0) {
-			return E_OK;
+/*
+ * Runs the action of the current state, moves one state up on success.
+ */
+static uint8_t gprs_step() {
+	uint8_t err = E_OK;
+
+	switch (gprs_state) {
+	case GPRS_STATE_POWER_UP:
+		gprs_power_cycle();
+		gprs_set_state(GPRS_STATE_AT_SYNC);
+		break;
+
+	case GPRS_STATE_AT_SYNC:
+		if ((err = init_modem()) == E_OK)
+			gprs_set_state(GPRS_STATE_REGISTERING);
+		break;
+
+	case GPRS_STATE_REGISTERING:
+		if (is_gprs_network_ok() == TRUE || gprs_attached) {
+			gprs_set_state(GPRS_STATE_REGISTERED);
+		} else {
+			err = E_NO_NETWORK;
 		}
+		break;
+
+	case GPRS_STATE_REGISTERED:
+		if ((err = gprs_bearer_open()) == E_OK)
+			gprs_set_state(GPRS_STATE_BEARER_UP);
+		break;
+
+	case GPRS_STATE_BEARER_UP:
+		if ((err = gprs_socket_open()) == E_OK)
+			gprs_set_state(GPRS_STATE_STREAMING);
+		break;
 	}
 
-	return E_INVALID_ANSWER;
+	return err;
 }
 
-uint8_t gprs_cmd_read(char * cmd_str, uint16_t cmd_len, uint16_t *answer_len) {
-	uint16_t bytes_read;
+/*
+ * A failed step is retried from the same state after the backoff delay,
+ * repeated failures fall back one state: the bearer is dropped, the modem
+ * is resynchronized and finally power cycled.
+ */
+static void gprs_step_failed() {
+	gprs_failed_at = chTimeNow();
+	gprs_failed_state = gprs_state;
+
+	if (gprs_stats.failures < 0xFF)
+		gprs_stats.failures++;
+
+	if (++gprs_state_failures < GPRS_STATE_RETRIES)
+		return;
+
+	switch (gprs_state) {
+	case GPRS_STATE_BEARER_UP:
+		at_cmd("AT+WIPBR=5,6", AT_CMD_TIMEOUT);
+		gprs_set_state(GPRS_STATE_REGISTERED);
+		break;
+
+	case GPRS_STATE_REGISTERED:
+	case GPRS_STATE_REGISTERING:
+		gprs_set_state(GPRS_STATE_AT_SYNC);
+		break;
+
+	case GPRS_STATE_AT_SYNC:
+		gprs_set_state(GPRS_STATE_POWER_UP);
+		break;
+	}
+}
 
-	sdWrite(&GPRS_SERIAL, "ATE0\r\n", sizeof("ATE0\r\n"));
-	chThdSleepMilliseconds(200);
+/*
+ * Advances the state machine until the target state is reached or a step
+ * fails. While a retry delay is running nothing is sent to the modem, so a
+ * dead coverage area costs one attempt per backoff period.
+ */
+static uint8_t gprs_connect(uint8_t target) {
+	uint8_t err;
 
-	// Flush buffer
-	sdAsynchronousRead(&GPRS_SERIAL, gprs_data, GPRS_CMD_BUF);
+	if (gprs_state >= target)
+		return E_OK;
 
-	sdWrite(&GPRS_SERIAL, cmd_str, cmd_len);
-	chThdSleepMilliseconds(1000);
-	bytes_read = sdAsynchronousRead(&GPRS_SERIAL, gprs_data, GPRS_CMD_BUF);
+	if (gprs_stats.failures > 0 && chTimeNow() - gprs_failed_at < S2ST(gprs_backoff_s()))
+		return E_GPRS_BACKOFF;
 
-	*answer_len = bytes_read;
+	if (target == GPRS_STATE_STREAMING)
+		gprs_stats.connect_attempts++;
 
-	if (bytes_read == 0)
-		return E_NOT_RESPONDING;
+	while (gprs_state < target) {
+		if ((err = gprs_step()) != E_OK) {
+			gprs_step_failed();
+			return err;
+		}
+	}
+
+	// Keep backing off when only the lower states work, e.g. GSM without data service
+	if (target == GPRS_STATE_STREAMING || gprs_failed_state < target)
+		gprs_stats.failures = 0;
 
 	return E_OK;
 }
 
-uint8_t gprs_get_signal_level(uint16_t *signalLevel) {
-	uint16_t bytes_read;
-	char signalLevelStr[3] = {0, 0, 0};
+uint8_t init_modem() {
+	uint16_t i;
 
-	if (gprs_cmd_read("AT+CSQ\r\n", sizeof("AT+CSQ\r\n") - 1, &bytes_read) != E_OK) {
-		return E_NOT_RESPONDING;
+	for (i = 0; i < ATZ_RETRY; i++) {
+		if (at_cmd("ATZ", AT_CMD_TIMEOUT) == AT_OK && at_cmd("ATE0", AT_CMD_TIMEOUT) == AT_OK)
+			break;
+
+		chThdSleepMilliseconds(500);
 	}
 
-	if (bytes_read < 13)
+	if (i >= ATZ_RETRY)
+		return E_NOT_RESPONDING;
+
+	// Report registration changes as URCs
+	if (at_cmd("AT+CREG=1", AT_CMD_TIMEOUT) != AT_OK || at_cmd("AT+CGREG=1", AT_CMD_TIMEOUT) != AT_OK)
 		return E_INVALID_ANSWER;
 
-	if (strncmp(gprs_data, "\r\n+CSQ:", sizeof("\r\n+CSQ:") - 1) != 0) {
+	return E_OK;
+}
+
+uint8_t gprs_get_signal_level(uint16_t *signalLevel) {
+	char resp[GPRS_RESP_BUF];
+	char *level;
+	uint8_t result;
+
+	result = at_cmd_response("AT+CSQ", "+CSQ:", resp, sizeof(resp), AT_CMD_TIMEOUT);
+
+	if (result == AT_TIMEOUT)
+		return E_NOT_RESPONDING;
+
+	if (result != AT_OK || resp[0] == '\0')
 		return E_INVALID_ANSWER;
-	}
 
-	signalLevelStr[0] = gprs_data[8];
+	// "+CSQ: <rssi>,<ber>"
+	level = resp + sizeof("+CSQ:") - 1;
 
-	if (gprs_data[9] != ',')
-		signalLevelStr[1] = gprs_data[9];
+	while (*level == ' ')
+		level++;
 
-	*signalLevel = atos(signalLevelStr);
+	*signalLevel = atos(level);
 
 	return E_OK;
 }
@@ -201,74 +399,99 @@ void init_gprs() {
 }
 
 uint8_t is_gprs_network_ok() {
-	sdWrite(&GPRS_SERIAL, "ATE0\r\n", sizeof("ATE0\r\n"));
-	chThdSleepMilliseconds(200);
+	char resp[GPRS_RESP_BUF];
+	char *stat;
 
-	if (gprs_cmd("AT+CREG?\r\n", sizeof("AT+CREG?\r\n") - 1, "\r\n+CREG 0,1\r\n", sizeof("\r\n+CREG 0,1\r\n") - 1) == E_OK)
-		return TRUE;
+	if (at_cmd_response("AT+CREG?", "+CREG:", resp, sizeof(resp), AT_CMD_TIMEOUT) != AT_OK)
+		return FALSE;
 
-	return FALSE;
-}
+	// "+CREG: <n>,<stat>", stat 1 is home network and 5 is roaming
+	stat = strchr(resp, ',');
 
-uint8_t send_tcp_message() {
-	uint16_t bytes_read;
-	uint8_t i;
+	gprs_registered = (stat != NULL && (stat[1] == '1' || stat[1] == '5'));
 
-	if (is_gprs_network_ok() != TRUE) {
+	return gprs_registered;
+}
 
-		//	return E_NO_NETWORK;
-	}
+uint8_t gprs_get_state() {
+	return gprs_state;
+}
 
-	chThdSleepMilliseconds(100);
+void gprs_get_stats(gprs_stats_t *stats) {
+	*stats = gprs_stats;
 
-	// Enable embedded TCP/IP stack
-	gprs_cmd("AT+WIPCFG=1\r\n", sizeof("AT+WIPCFG=1\r\n") - 1, NULL, 0);
+	stats->state = gprs_state;
+	stats->backoff_s = gprs_backoff_s();
+}
 
-	chThdSleepMilliseconds(250);
-	sdAsynchronousRead(&GPRS_SERIAL, gprs_data, GPRS_CMD_BUF);
+/*
+ * Brings the link up to an open socket. Returns E_GPRS_BACKOFF without
+ * touching the modem while the retry delay after a failure is running.
+ */
+uint8_t gprs_session_open() {
+	uint8_t err;
 
-	// Open GPRS bearer
-	gprs_cmd("AT+WIPBR=1,6\r\n", sizeof("AT+WIPBR=1,6\r\n") - 1, NULL, 0);
+	if (gprs_state == GPRS_STATE_STREAMING)
+		return E_OK;
 
-	chThdSleepMilliseconds(250);
-	sdAsynchronousRead(&GPRS_SERIAL, gprs_data, GPRS_CMD_BUF);
+	if (!gprs_connecting) {
+		gprs_connecting = TRUE;
+		gprs_connect_started = chTimeNow();
+	}
 
-	// Set GPRS AP
-	gprs_cmd("AT+WIPBR=2,6,11,\"internet\"\r\n", sizeof("AT+WIPBR=2,6,11,\"internet\"\r\n") - 1, NULL, 0);
+	if ((err = gprs_connect(GPRS_STATE_STREAMING)) != E_OK)
+		return err;
 
-	chThdSleepMilliseconds(250);
-	sdAsynchronousRead(&GPRS_SERIAL, gprs_data, GPRS_CMD_BUF);
+	gprs_connecting = FALSE;
+	gprs_stats.connects++;
+	gprs_stats.time_to_connect_ms = (chTimeNow() - gprs_connect_started) * 1000 / CH_FREQUENCY;
 
-	// Connect to GPRS
-	gprs_cmd("AT+WIPBR=4,6,0\r\n", sizeof("AT+WIPBR=4,6,0\r\n") - 1, NULL, 0);
+	return E_OK;
+}
 
-	chThdSleepSeconds(3);
+/*
+ * Sends len bytes over the open TCP socket. The socket and the bearer stay
+ * up afterwards, so the next batch skips the whole connection setup.
+ */
+uint8_t gprs_session_send(const uint8_t *data, uint16_t len) {
+	uint16_t i;
 
-	bytes_read = sdAsynchronousRead(&GPRS_SERIAL, gprs_data, GPRS_CMD_BUF);
+	if (gprs_state != GPRS_STATE_STREAMING)
+		return E_GPRS_CONNECT_ERROR;
 
-	if (bytes_read > 0) {
-		if (strncmp(gprs_data, "\r\nOK", sizeof("\r\nOK") - 1) != 0) {
+	if (at_cmd("AT+WIPDATA=2,1,1", AT_CMD_TIMEOUT) != AT_CONNECT) {
+		at_cmd("AT+WIPCLOSE=2,1", AT_CMD_TIMEOUT);
+		gprs_link_lost(GPRS_STATE_BEARER_UP);
+		return E_GPRS_CONNECT_ERROR;
+	}
 
+	// ETX and DLE are control characters in continuous mode, escape them with DLE
+	for (i = 0; i < len; i++) {
+		if (data[i] == GPRS_ETX || data[i] == GPRS_DLE)
+			chIOPut(&GPRS_SERIAL, GPRS_DLE);
 
-			//return E_GPRS_CONNECT_ERROR;
-		}
-	} else {
-		//return E_GPRS_CONNECT_ERROR;
+		chIOPut(&GPRS_SERIAL, data[i]);
 	}
 
-	// Establish connection
-	gprs_cmd("AT+WIPCREATE=2,1,\"195.209.231.43\",5555\r\n", sizeof("AT+WIPCREATE=2,1,\"195.209.231.43\",5555\r\n") - 1, NULL, 0);
-
-	chThdSleepSeconds(1);
+	if (at_escape() != AT_OK) {
+		at_cmd("AT+WIPCLOSE=2,1", AT_CMD_TIMEOUT);
+		gprs_link_lost(GPRS_STATE_BEARER_UP);
+		return E_GPRS_CONNECT_ERROR;
+	}
 
-	gprs_cmd("AT+WIPDATA=2,1,1\r\n", sizeof("AT+WIPDATA=2,1,1\r\n") - 1, NULL, 0);
+	gprs_stats.bytes_sent += len;
 
-	chThdSleepSeconds(3);
+	return E_OK;
+}
 
-	gprs_cmd("Hello from wismo!\r\n", sizeof("Hello from wismo!\r\n") - 1, NULL, 0);
+/*
+ * Closes the socket, the bearer stays up for the next session.
+ */
+void gprs_session_close() {
+	if (gprs_state != GPRS_STATE_STREAMING)
+		return;
 
-	chThdSleepMilliseconds(250);
-	gprs_cmd("+++", sizeof("+++") - 1, NULL, 0);
-	chThdSleepMilliseconds(250);
+	at_cmd("AT+WIPCLOSE=2,1", AT_CMD_TIMEOUT);
 
+	gprs_set_state(GPRS_STATE_BEARER_UP);
 }
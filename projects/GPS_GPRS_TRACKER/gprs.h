@@ -11,26 +11,75 @@
 #include "ch.h"
 #include "hal.h"
 
+// Retry delay after the first failure, doubled on every further one
+#if !defined(GPRS_BACKOFF_MIN_S)
+#define GPRS_BACKOFF_MIN_S		5
+#endif
+
+#if !defined(GPRS_BACKOFF_MAX_S)
+#define GPRS_BACKOFF_MAX_S		1800
+#endif
+
+// Failures in a row at one state before falling back to the previous one
+#if !defined(GPRS_STATE_RETRIES)
+#define GPRS_STATE_RETRIES		3
+#endif
+
 typedef enum GPRS_MODEM_ERRORS {
 	E_OK					=	0x00,
 	E_NOT_RESPONDING		=	0x01,
 	E_INVALID_ANSWER		=	0x02,
 	E_NO_NETWORK			=	0x03,
-	E_GPRS_CONNECT_ERROR	=	0x04
+	E_GPRS_CONNECT_ERROR	=	0x04,
+	E_GPRS_BACKOFF			=	0x05
 };
 
-extern void init_gprs();
+typedef enum GPRS_STATE {
+	GPRS_STATE_POWER_UP		=	0x00,
+	GPRS_STATE_AT_SYNC		=	0x01,
+	GPRS_STATE_REGISTERING	=	0x02,
+	GPRS_STATE_REGISTERED	=	0x03,
+	GPRS_STATE_BEARER_UP	=	0x04,
+	GPRS_STATE_STREAMING	=	0x05
+} GPRS_STATE;
 
-uint8_t init_modem();
+/*
+ * Link health counters for diagnostics, kept since power on.
+ */
+typedef struct gprs_stats {
+	uint8_t state;
+
+	// Consecutive failures, sets the current retry delay
+	uint8_t failures;
+	uint32_t backoff_s;
+
+	uint32_t connect_attempts;
+	uint32_t connects;
+	uint32_t drops;
+	uint32_t power_cycles;
 
-uint8_t gprs_cmd(char * cmd_str, uint16_t cmd_len, char * answer_str, uint16_t answer_len);
+	// Last time from the start of a connect attempt to an open socket
+	uint32_t time_to_connect_ms;
 
-uint8_t gprs_cmd_read(char * cmd_str, uint16_t cmd_len, uint16_t *answer_len);
+	uint32_t bytes_sent;
+} gprs_stats_t;
+
+extern void init_gprs();
+
+uint8_t init_modem();
 
 uint8_t gprs_get_signal_level(uint16_t *signalLevel);
 
 extern uint8_t is_gprs_network_ok();
 
-uint8_t send_tcp_message();
+extern uint8_t gprs_get_state();
+
+extern void gprs_get_stats(gprs_stats_t *stats);
+
+uint8_t gprs_session_open();
+
+uint8_t gprs_session_send(const uint8_t *data, uint16_t len);
+
+void gprs_session_close();
 
 #endif /* GPRS_H_ */
@@ -5,13 +5,36 @@
 #include "hal.h"
 
 #include "util.h"
+#include "nmea.h"
+#include "sirf.h"
+#include "fixring.h"
+#include "fixcodec.h"
+#include "pps.h"
+#include "motion.h"
+#include "lowpower.h"
+#include "led.h"
+#include "bufpool.h"
+
+#include <string.h>
 
 #define GPS_CMD_BUF 256
 
+#if GPS_CMD_BUF > BUFPOOL_SIZE
+#error "GPS_CMD_BUF does not fit a pool buffer"
+#endif
+
+// Time given to the UART ISR to fill the input queue before it is drained
+#define GPS_RX_BATCH_MS		10
+
+#if !defined(GPS_SERIAL)
 #define GPS_SERIAL SD3
+#endif
 
 #define GPS_READ_TIMEOUT_TICS	1000
-#define GPS_READ_MSG_TIMEOUT_TICS	100
+
+// Receiver supply switch, on when low
+#define GPS_POWER_ON()		palClearPad(GPIO_GPS_PWR_PORT, GPIO_GPS_PWR_PIN)
+#define GPS_POWER_OFF()		palSetPad(GPIO_GPS_PWR_PORT, GPIO_GPS_PWR_PIN)
 
 typedef enum GPS_ERROR {
 	E_OK				=	0x00,
@@ -23,37 +46,156 @@ typedef enum GPS_ERROR {
 
 } GPS_ERROR;
 
+#if !defined(SIMULATOR)
 SerialConfig SD3_Config = {
    .sc_speed = 9600,
    .sc_cr2 = USART_CR2_STOP1_BITS
 };
+#endif
 
 uint8_t *gps_data = NULL;
 
+static nmea_parser_t gps_parser;
+static nmea_sentence_t gps_sentence;
+
+#if GPS_USE_SIRF_BINARY
+static sirf_parser_t gps_sirf_parser;
+
+static void gps_sirf_set_rate(uint8_t mid, uint8_t rate);
+#endif
+
+typedef enum GPS_PROBE {
+	GPS_PROBE_SILENT		=	0x00,
+	GPS_PROBE_NMEA			=	0x01,
+	GPS_PROBE_CONFIGURED	=	0x02
+} GPS_PROBE;
+
+// Factory setting of the receiver and the one gps_configure() switches to
+#define GPS_SPEED_DEFAULT		9600
+#define GPS_SPEED				38400
+
+// Sentences come once a second
+#define GPS_PROBE_TIMEOUT_MS	1200
+
+// Longest command body, NMEA limits the whole sentence to 82 characters
+#define GPS_CMD_MAX_LEN			76
+
+// Only the GPS thread writes commands, its buffers are kept off its small stack
+static char gps_seed_cmd[80];
+static uint8_t gps_cmd_frame[GPS_CMD_MAX_LEN + NMEA_FRAME_OVERHEAD];
+static uint8_t gps_sirf_frame[32 + SIRF_FRAME_OVERHEAD];
+
+// GPS time starts 1980-01-06, fix time is UTC seconds since 2000-01-01
+#define GPS_EPOCH_TO_2000		630720000
+#define GPS_UTC_LEAP_SECONDS	18
+#define GPS_SECONDS_PER_WEEK	604800
+
+// Speed the receiver talks at, tried first on the next reset
+static uint32_t gps_speed = GPS_SPEED_DEFAULT;
+
+// Last usable fix and when it was received, seeds the warm start
+static gps_fix_t gps_seed_fix;
+static uint64_t gps_seed_us;
+static uint8_t gps_seed_valid = FALSE;
+
+#if !GPS_USE_SIRF_BINARY
+// Sentences of the epoch being received are merged here
+static nmea_merge_t gps_merge;
+#endif
+
+// Complete epoch, published by gps_publish_fix()
+static gps_fix_t gps_fix_done;
+
+// Complete fixes, consumers read them with gps_fix_read()
+static fix_ring_t gps_fix_ring;
+
+// Broadcast after every published fix
+EVENTSOURCE_DECL(gps_fix_event);
+
+// Epoch is complete once all of these arrived, see PSRF103 in gps_configure()
+#define GPS_FIX_EPOCH_SENTENCES	(GPS_FIX_SENTENCE(GPS_MESSAGE_GPRMC) | GPS_FIX_SENTENCE(GPS_MESSAGE_GPGGA))
+
+static gps_stats_t gps_stats;
+
+// Last sentence with a valid checksum, the receiver is alive and in sync
+static systime_t gps_last_valid;
+
+// Bulk read buffer, keeps bytes that were drained but not yet tokenized
+static uint8_t gps_rx_buf[SERIAL_BUFFERS_SIZE];
+static size_t gps_rx_len = 0, gps_rx_pos = 0;
+
+/*
+ * (Re)starts the GPS port at the given speed. The simulated port is a TCP
+ * socket without a speed that can be started only once.
+ */
+static void gps_serial_start(uint32_t speed) {
+#if defined(SIMULATOR)
+	(void)speed;
+
+	if (GPS_SERIAL.state != SD_READY)
+		sdStart(&GPS_SERIAL, NULL);
+#else
+	sdStop(&GPS_SERIAL);
+	SD3_Config.sc_speed = speed;
+	sdStart(&GPS_SERIAL, &SD3_Config);
+#endif
+}
+
+static void gps_count_error(uint8_t res) {
+	switch (res) {
+	case E_READ_TIMEOUT:
+		gps_stats.timeouts++;
+		break;
+	case E_LEN_ERROR:
+		gps_stats.overruns++;
+		break;
+	case E_CHKSUM_ERROR:
+		gps_stats.chksum_errors++;
+		break;
+	default:
+		gps_stats.format_errors++;
+		break;
+	}
+}
+
+/*
+ * Receiver off while the vehicle is parked, back on and reset once it
+ * moves. The fix ring keeps the last fix meanwhile.
+ */
+static void gps_sleep() {
+	gps_stats.sleeps++;
+
+	GPS_POWER_OFF();
+	led_set_pattern(LED_GPS, LED_PATTERN_OFF);
+	lowpower_allow();
+
+	motion_wait_moving();
+
+	lowpower_inhibit();
+	led_set_pattern(LED_GPS, LED_PATTERN_GPS_SEARCH);
+	gps_reset();
+}
+
 static WORKING_AREA(waGPSThread, 256);
 static msg_t GPSThread(void *arg) {
   (void)arg;
   chRegSetThreadName("gps_thread");
 
   if (gps_data != NULL) {
-	  chHeapFree(gps_data);
+	  bufpool_free(gps_data);
   }
 
-  gps_data = chHeapAlloc(NULL, GPS_CMD_BUF);
-  size_t gps_bytes_read;
-  uint16_t i;
+  // The pool holds BUFPOOL_GPS buffers for this thread, it cannot run out
+  gps_data = bufpool_alloc();
 
-  if (gps_data == NULL) {
-	  while (TRUE) {
-		  palTogglePad(GPIO_LED_1_PORT, GPIO_LED_1_PIN);
-		  chThdSleepMilliseconds(50);
-	  }
-  }
+  chDbgAssert(gps_data != NULL, "GPSThread(), #1", "buffer pool exhausted");
 
-  sdStart(&GPS_SERIAL, &SD3_Config);
+  gps_serial_start(gps_speed);
   palSetPadMode(GPS_USART_PORT, GPS_USART_TX_PIN, PAL_MODE_ALTERNATE(7));
   palSetPadMode(GPS_USART_PORT, GPS_USART_RX_PIN, PAL_MODE_ALTERNATE(7));
 
+  // A powered receiver talks all the time, the UART would lose it in STOP mode
+  lowpower_inhibit();
   gps_reset();
 
   while (TRUE) {
@@ -61,409 +203,455 @@ static msg_t GPSThread(void *arg) {
 	  uint8_t res = gps_read_msg(&readed_msg_len);
 
 	  if (res == E_OK) {
-		  if (check_checksum() != E_OK) {
-			  sdWrite(&SD1, "GPS CHK ERR\r\n", 13);
-		  } else {
-
-			  if (gps_message_type() == GPS_MESSAGE_GPRMC) {
-				  gps_rmc_state_t state;
+		  gps_stats.sentences++;
+		  gps_last_valid = chTimeNow();
 
-				  //sdWrite(&SD1, gps_data, readed_msg_len);
-
-				  if (parse_gps_rmc(&state) == E_OK) {
-					  sdWrite(&SD1, "GPS PARSE OK\r\n", 14);
-				  }
-
-			  } else if (gps_message_type() == GPS_MESSAGE_UNKNOWN) {
-				  sdWrite(&SD1, "GPS MSG UNKNOWN\r\n", 17);
-			  }
+		  res = gps_process_msg();
 
+		  if (res == E_MSG_TYPE_ERR) {
+			  gps_stats.unknown_types++;
+		  } else if (res != E_OK) {
+			  gps_stats.parse_errors++;
 		  }
 	  } else {
-		  gps_data[0] = '0' + res;
-		  sdWrite(&SD1, "GPS ERROR:", 10);
-		  sdWrite(&SD1, gps_data, 1);
-		  gps_reset();
+		  // Broken sentence is dropped, tokenizer resyncs on the next start symbol
+		  gps_count_error(res);
 	  }
 
-	  sdWrite(&SD1, "\r\n", 2);
+	  if (!motion_is_moving())
+		  gps_sleep();
 
-
-
-	//sdWrite(&SD1, "GPS: ", 5);
-	//while ((gps_bytes_read = sdReadTimeout(&GPS_SERIAL, gps_data, GPS_CMD_BUF, 100)) > 0)
-	//	sdWrite(&SD1, gps_data, gps_bytes_read);
-	//sdWrite(&SD1, "|||\r\n", 5);
-
-    //chThdSleepMilliseconds(500);
+	  // Single errors are normal on a noisy line, reset only a receiver that went silent
+	  if (chTimeNow() - gps_last_valid >= S2ST(GPS_RESET_TIMEOUT_S)) {
+		  gps_stats.resets++;
+		  gps_reset();
+	  }
   }
 
-  chHeapFree(gps_data);
+  return 0;
 }
 
 void init_gps() {
+	pps_init();
+	fix_ring_init(&gps_fix_ring);
+#if !GPS_USE_SIRF_BINARY
+	nmea_merge_init(&gps_merge, GPS_FIX_EPOCH_SENTENCES);
+#endif
+
 	// GPS Thread
 	chThdCreateStatic(waGPSThread, sizeof(waGPSThread), NORMALPRIO, GPSThread, NULL);
 }
 
-void gps_reset() {
-	palSetPadMode(GPIO_GPS_PWR_PORT, GPIO_GPS_PWR_PIN, PAL_MODE_OUTPUT_PUSHPULL);
-
-	//! Set GPS power Off
-	palClearPad(GPIO_GPS_PWR_PORT, GPIO_GPS_PWR_PIN);
-
-	chThdSleepMilliseconds(500);
-
-	//! Set GPS power On
-	palClearPad(GPIO_GPS_PWR_PORT, GPIO_GPS_PWR_PIN);
+/*
+ * Listens at the given speed for what the receiver sends on its own.
+ * Returns as soon as the output tells whether it still has the settings
+ * of gps_configure() (it keeps them while the backup supply holds), or
+ * after GPS_PROBE_TIMEOUT_MS of silence or garbage.
+ */
+static uint8_t gps_probe(uint32_t speed) {
+	systime_t start;
+	msg_t c;
+	uint8_t seen = 0;
+#if !GPS_USE_SIRF_BINARY
+	uint8_t type;
+#endif
+
+	gps_serial_start(speed);
+
+	// Both parsers at once, each in its own half of gps_data
+	nmea_init(&gps_parser, gps_data, GPS_CMD_BUF / 2);
+#if GPS_USE_SIRF_BINARY
+	sirf_init(&gps_sirf_parser, gps_data + GPS_CMD_BUF / 2, GPS_CMD_BUF / 2);
+#endif
+
+	start = chTimeNow();
+
+	while (chTimeNow() - start < MS2ST(GPS_PROBE_TIMEOUT_MS)) {
+		if ((c = sdGetTimeout(&GPS_SERIAL, MS2ST(100))) < Q_OK)
+			continue;
+
+#if GPS_USE_SIRF_BINARY
+		// Binary output is only ever enabled by gps_configure()
+		if (sirf_put(&gps_sirf_parser, (uint8_t)c) == SIRF_FRAME)
+			return speed == GPS_SPEED ? GPS_PROBE_CONFIGURED : GPS_PROBE_NMEA;
+#endif
+
+		if (nmea_put(&gps_parser, (uint8_t)c) != NMEA_SENTENCE)
+			continue;
+
+#if GPS_USE_SIRF_BINARY
+		return GPS_PROBE_NMEA;
+#else
+		nmea_index(&gps_sentence, gps_data, gps_parser.len);
+		type = nmea_message_type(&gps_sentence);
+
+		if (speed != GPS_SPEED || type == GPS_MESSAGE_UNKNOWN ||
+				(GPS_FIX_SENTENCE(type) & GPS_FIX_EPOCH_SENTENCES) == 0)
+			return GPS_PROBE_NMEA;
+
+		seen |= GPS_FIX_SENTENCE(type);
+
+		if (seen == GPS_FIX_EPOCH_SENTENCES)
+			return GPS_PROBE_CONFIGURED;
+#endif
+	}
 
-	sdStop(&GPS_SERIAL);
-	SD3_Config.sc_speed = 9600;
-	sdStart(&GPS_SERIAL, &SD3_Config);
+	return seen ? GPS_PROBE_CONFIGURED : GPS_PROBE_SILENT;
+}
 
-	// Wait until initialized
-	while (sdReadTimeout(&GPS_SERIAL, gps_data, GPS_CMD_BUF, 100) <= 0) {}
+static char *gps_put_uint(char *p, uint32_t value, uint8_t min_digits) {
+	char digits[10];
+	uint8_t n = 0;
 
-	// Set serial config
-	GPS_CMD_SEND("PSRF100,1,38400,8,1,0");
-	chThdSleepMilliseconds(100);
+	do {
+		digits[n++] = '0' + value % 10;
+		value /= 10;
+	} while (value || n < min_digits);
 
-	sdStop(&GPS_SERIAL);
-	SD3_Config.sc_speed = 38400;
-	sdStart(&GPS_SERIAL, &SD3_Config);
+	while (n)
+		*p++ = digits[--n];
 
-	// Disable unneeded
-	GPS_CMD_SEND("PSRF103,01,00,00,01");
-	chThdSleepMilliseconds(100);
-	GPS_CMD_SEND("PSRF103,02,00,00,01");
-	chThdSleepMilliseconds(100);
-	GPS_CMD_SEND("PSRF103,03,00,00,01");
-	chThdSleepMilliseconds(100);
-	GPS_CMD_SEND("PSRF103,05,00,00,01");
-
-	// Enable needed
-	// GGA
-	GPS_CMD_SEND("PSRF103,00,00,01,01");
-	chThdSleepMilliseconds(100);
-	// RMC
-	GPS_CMD_SEND("PSRF103,04,00,01,01");
-	chThdSleepMilliseconds(100);
-
-	sdAsynchronousRead(&GPS_SERIAL, gps_data, GPS_CMD_BUF);
+	return p;
 }
 
-void gps_write_cmd(uint8_t * cmd_buf, uint8_t len) {
-	uint8_t chksum = 0, i, num_len = 0;
-	char num_buf[4];
-
-	for (i = 0; i < len; i++)
-		chksum ^= cmd_buf[i];
+static char *gps_put_int(char *p, int32_t value) {
+	if (value < 0) {
+		*p++ = '-';
+		return gps_put_uint(p, -value, 1);
+	}
 
-	chIOPut(&GPS_SERIAL, '$');
+	return gps_put_uint(p, value, 1);
+}
 
-	sdWrite(&GPS_SERIAL, cmd_buf, len);
+// 1/10000 minute units to degrees with 6 decimals
+static char *gps_put_coord(char *p, int32_t value) {
+	uint32_t micro = (value < 0 ? -value : value) * 5 / 3;
 
-	chIOPut(&GPS_SERIAL, '*');
+	if (value < 0)
+		*p++ = '-';
 
-	stoh(chksum, num_buf, &num_len);
-	sdWrite(&GPS_SERIAL, num_buf, num_len - 1);
+	p = gps_put_uint(p, micro / 1000000, 1);
+	*p++ = '.';
 
-	chIOPut(&GPS_SERIAL, '\r');
-	chIOPut(&GPS_SERIAL, '\n');
+	return gps_put_uint(p, micro % 1000000, 6);
 }
 
-uint8_t gps_read_msg(size_t *msg_len) {
-	size_t bytes_readed, msg_readed = 0;
-	uint8_t correct_byte_count = 0, incorrect_byte_count = 0;
-	uint8_t is_reading = 1;
-	uint8_t readed_byte;
+/*
+ * Navigation Initialization (PSRF104) from the last usable fix. A
+ * receiver that lost its memory then does a warm start instead of
+ * searching the whole sky. The time is UTC of the last synced 1PPS edge
+ * or of the RTC calendar, the fix time moved forward by the system clock
+ * only when neither is there.
+ */
+static void gps_seed() {
+	char *p = gps_seed_cmd;
+	fix_record_t rec;
+	uint32_t utc_s, micros, gps_time;
 
-	// Search for start symbol
-	while (is_reading) {
-		bytes_readed = sdReadTimeout(&GPS_SERIAL, &readed_byte, 1,
-				correct_byte_count == 0 ? GPS_READ_TIMEOUT_TICS : GPS_READ_MSG_TIMEOUT_TICS);
+	if (!gps_seed_valid)
+		return;
 
-		if (bytes_readed <= 0) {
-			return E_READ_TIMEOUT;
-		}
+	fix_record_from_fix(&gps_seed_fix, &rec);
 
-		switch (correct_byte_count) {
-		case 0:
-			if (readed_byte == '$') {
-				correct_byte_count++;
-			}
+	if (!pps_get_utc(&utc_s, &micros) && !lowpower_rtc_get(&utc_s))
+		utc_s = rec.time + (uint32_t)((pps_now_us() - gps_seed_us) / 1000000);
 
-			if (incorrect_byte_count++ > 128)
-				return E_INVALID_DATA;
+	gps_time = utc_s + GPS_EPOCH_TO_2000 + GPS_UTC_LEAP_SECONDS;
 
-			break;
-		case 1:
-			if (readed_byte != 'G') {
-				return E_INVALID_DATA;
-			}
+	memcpy(p, "PSRF104,", 8);
+	p += 8;
 
-			correct_byte_count++;
-			break;
-		case 2:
-			if (readed_byte != 'P') {
-				return E_INVALID_DATA;
-			}
+	p = gps_put_coord(p, rec.latitude);
+	*p++ = ',';
+	p = gps_put_coord(p, rec.longitude);
+	*p++ = ',';
+	p = gps_put_int(p, gps_seed_fix.altitude / 10);
 
-			correct_byte_count = 0;
-			is_reading = 0;
-			break;
-		}
-
-	}
+	// Clock drift 0 - use the stored one
+	memcpy(p, ",0,", 3);
+	p += 3;
 
-	// Если мы здесь, значит $GP мы уже получили
-	is_reading = 1;
+	p = gps_put_uint(p, gps_time % GPS_SECONDS_PER_WEEK, 1);
+	*p++ = ',';
+	p = gps_put_uint(p, gps_time / GPS_SECONDS_PER_WEEK, 1);
 
-	while (is_reading) {
-		bytes_readed = sdReadTimeout(&GPS_SERIAL, &readed_byte, 1, GPS_READ_MSG_TIMEOUT_TICS);
+	// 12 channels, warm start with initialization data
+	memcpy(p, ",12,3", 5);
+	p += 5;
 
-		if (bytes_readed <= 0)
-			return E_READ_TIMEOUT;
+	gps_write_cmd((const uint8_t *)gps_seed_cmd, p - gps_seed_cmd);
+	chThdSleepMilliseconds(100);
+}
 
-		gps_data[msg_readed++] = readed_byte;
+/*
+ * Full setup of a receiver that came up with factory settings.
+ */
+static void gps_configure() {
+	if (gps_speed != GPS_SPEED) {
+		// Set serial config
+		GPS_CMD_SEND("PSRF100,1,38400,8,1,0");
+		chThdSleepMilliseconds(100);
+
+		gps_speed = GPS_SPEED;
+		gps_serial_start(gps_speed);
+	}
 
-		// If we read the end of the packet
-		if (readed_byte == '*') {
-			bytes_readed = sdReadTimeout(&GPS_SERIAL, gps_data + msg_readed, 2, GPS_READ_MSG_TIMEOUT_TICS);
+	// NMEA text, so before a switch to binary
+	gps_seed();
 
-			if (bytes_readed != 2) {
-				return E_READ_TIMEOUT;
-			}
+#if GPS_USE_SIRF_BINARY
+	// Switch to binary, serial settings stay the same
+	GPS_CMD_SEND("PSRF100,0,38400,8,1,0");
+	chThdSleepMilliseconds(100);
 
-			msg_readed += 2;
-			break;
-		}
-	}
+	// Disable unneeded, Measured Tracker Data alone is 188 bytes per second
+	gps_sirf_set_rate(SIRF_MID_MEASURED_NAV, 0);
+	gps_sirf_set_rate(SIRF_MID_MEASURED_TRACKER, 0);
+	gps_sirf_set_rate(SIRF_MID_CLOCK_STATUS, 0);
+	gps_sirf_set_rate(SIRF_MID_CPU_THROUGHPUT, 0);
 
-	*msg_len = msg_readed;
+	// Enable needed
+	gps_sirf_set_rate(SIRF_MID_GEODETIC_NAV, 1);
+#else
+	// Disable unneeded
+	GPS_CMD_SEND("PSRF103,01,00,00,01");
+	chThdSleepMilliseconds(100);
+	GPS_CMD_SEND("PSRF103,02,00,00,01");
+	chThdSleepMilliseconds(100);
+	GPS_CMD_SEND("PSRF103,03,00,00,01");
+	chThdSleepMilliseconds(100);
+	GPS_CMD_SEND("PSRF103,05,00,00,01");
 
-	return E_OK;
+	// Enable needed
+	// GGA
+	GPS_CMD_SEND("PSRF103,00,00,01,01");
+	chThdSleepMilliseconds(100);
+	// RMC
+	GPS_CMD_SEND("PSRF103,04,00,01,01");
+	chThdSleepMilliseconds(100);
+#endif
 }
 
-uint8_t gps_message_type() {
-	if (gps_data[0] == 'R' &&
-			gps_data[1] == 'M' &&
-			gps_data[2] == 'C') {
-		return GPS_MESSAGE_GPRMC;
-	}
+void gps_reset() {
+	uint8_t probe;
 
-	if (gps_data[0] == 'G' &&
-			gps_data[1] == 'G' &&
-			gps_data[2] == 'A') {
-		return GPS_MESSAGE_GPGGA;
-	}
+	palSetPadMode(GPIO_GPS_PWR_PORT, GPIO_GPS_PWR_PIN, PAL_MODE_OUTPUT_PUSHPULL);
 
-	if (gps_data[0] == 'G' &&
-			gps_data[1] == 'L' &&
-			gps_data[2] == 'L') {
-		return GPS_MESSAGE_GPGLL;
-	}
+	//! Set GPS power Off
+	GPS_POWER_OFF();
 
-	if (gps_data[0] == 'G' &&
-			gps_data[1] == 'S' &&
-			gps_data[2] == 'A') {
-		return GPS_MESSAGE_GPGSA;
-	}
+	chThdSleepMilliseconds(500);
 
-	if (gps_data[0] == 'G' &&
-			gps_data[1] == 'S' &&
-			gps_data[2] == 'V') {
-		return GPS_MESSAGE_GPGSV;
-	}
+	//! Set GPS power On
+	GPS_POWER_ON();
 
-	if (gps_data[0] == 'V' &&
-			gps_data[1] == 'T' &&
-			gps_data[2] == 'G') {
-		return GPS_MESSAGE_GPVTG;
-	}
+	// Last known speed first, the other one only when it is silent
+	probe = gps_probe(gps_speed);
 
-	if (gps_data[0] == 'Z' &&
-			gps_data[1] == 'D' &&
-			gps_data[2] == 'A') {
-		return GPS_MESSAGE_GPZDA;
+	if (probe == GPS_PROBE_SILENT) {
+		gps_speed = gps_speed == GPS_SPEED ? GPS_SPEED_DEFAULT : GPS_SPEED;
+		probe = gps_probe(gps_speed);
 	}
 
-	return GPS_MESSAGE_UNKNOWN;
-}
-
-uint8_t check_checksum() {
-	// Checksum for 'GP'
-	uint8_t chksum = 'G' ^ 'P';
-
-	uint8_t i = 0, num_len = 0;
-	char num_buf[4];
-
-	while (i < (GPS_CMD_BUF - 2)) {
-		if (gps_data[i] != '*') {
-			chksum ^= gps_data[i];
-		} else {
-			break;
-		}
-
-		i++;
+	// Receiver that kept its settings also kept ephemeris and time, it hot starts by itself
+	if (probe != GPS_PROBE_CONFIGURED) {
+		gps_stats.reconfigurations++;
+		gps_configure();
 	}
 
-	if (i == (GPS_CMD_BUF - 2))
-		return E_LEN_ERROR;
+	sdAsynchronousRead(&GPS_SERIAL, gps_data, GPS_CMD_BUF);
 
-	stoh(chksum, num_buf, &num_len);
+#if GPS_USE_SIRF_BINARY
+	sirf_init(&gps_sirf_parser, gps_data, GPS_CMD_BUF);
+#else
+	nmea_init(&gps_parser, gps_data, GPS_CMD_BUF);
+#endif
 
-	if (num_len == 2) {
-		if (gps_data[i + 1] == '0' && gps_data[i + 2] == num_buf[0])
-			return E_OK;
-	} else if (num_len == 3) {
-		if (gps_data[i + 1] == num_buf[0] && gps_data[i + 2] == num_buf[1])
-			return E_OK;
-	} else {
-		return E_LEN_ERROR;
-	}
+	gps_rx_len = gps_rx_pos = 0;
 
-	return E_CHKSUM_ERROR;
+	// Reconfigured receiver gets the full timeout to start talking
+	gps_last_valid = chTimeNow();
 }
 
-#define GPS_RMC_HOUR_OFFSET					4
-#define GPS_RMC_MINUTE_OFFSET				6
-#define GPS_RMC_SECOND_OFFSET				8
-#define GPS_RMC_VALID_OFFSET				15
-#define GPS_RMC_LATITUDE_DEG_OFFSET			17
-#define GPS_RMC_LATITUDE_MIN_VAL_OFFSET		19
-#define GPS_RMC_LATITUDE_MIN_FRAC_OFFSET	22
-#define GPS_RMC_LATITUDE_NS_OFFSET			27
-#define GPS_RMC_LONGITUDE_DEG_OFFSET		29
-#define GPS_RMC_LONGITUDE_MIN_VAL_OFFSET	32
-#define GPS_RMC_LONGITUDE_MIN_FRAC_OFFSET	35
-#define GPS_RMC_LONGITUDE_EW_OFFSET			40
-#define GPS_RMC_SPEED_OFFSET				42
-
-uint8_t field_len(uint8_t *buf) {
-	uint8_t i;
-
-	for (i = 0; i < 16; i++) {
-		if (buf[i] == ',' || buf[i] == '.')
-			return i;
-	}
+void gps_write_cmd(const uint8_t * cmd_buf, uint8_t len) {
+	if (len > GPS_CMD_MAX_LEN)
+		return;
 
-	return 0;
+	sdWrite(&GPS_SERIAL, gps_cmd_frame, nmea_frame(cmd_buf, len, gps_cmd_frame));
 }
 
-uint8_t parse_gps_rmc(gps_rmc_state_t * state) {
-	if (gps_message_type() != GPS_MESSAGE_GPRMC)
-		return E_MSG_TYPE_ERR;
-
-	uint8_t *parse_buffer[16];
-	uint8_t i, len;
+void gps_write_sirf(const uint8_t * payload, uint8_t len) {
+	if (len > sizeof(gps_sirf_frame) - SIRF_FRAME_OVERHEAD)
+		return;
 
-	state->hour = atos_len(gps_data + GPS_RMC_HOUR_OFFSET, 2);
-	state->minute = atos_len(gps_data + GPS_RMC_MINUTE_OFFSET, 2);
-	state->second = atos_len(gps_data + GPS_RMC_SECOND_OFFSET, 2);
-
-	if (gps_data[GPS_RMC_VALID_OFFSET] == 'A') {
-		state->flags &= ~GPS_DATA_INVALID;
-	} else {
-		state->flags |= GPS_DATA_INVALID;
-	}
+	sdWrite(&GPS_SERIAL, gps_sirf_frame, sirf_frame(payload, len, gps_sirf_frame));
+}
 
-	state->latitude_degrees = atos_len(gps_data + GPS_RMC_LATITUDE_DEG_OFFSET, 2);
+#if GPS_USE_SIRF_BINARY
+/*
+ * Set Message Rate (MID 166), rate is in seconds, 0 disables the message.
+ */
+static void gps_sirf_set_rate(uint8_t mid, uint8_t rate) {
+	const uint8_t payload[] = {SIRF_MID_SET_MSG_RATE, 0, mid, rate, 0, 0, 0, 0};
 
-	state->latitude_seconds = atos_len(gps_data + GPS_RMC_LATITUDE_MIN_VAL_OFFSET, 2) * 10000;
-	state->latitude_seconds += atos_len(gps_data + GPS_RMC_LATITUDE_MIN_FRAC_OFFSET, 4);
+	gps_write_sirf(payload, sizeof(payload));
+	chThdSleepMilliseconds(100);
+}
+#endif
 
-	state->flags &= ~(LATITUDE_N | LATITUDE_S);
+uint8_t gps_read_msg(size_t *msg_len) {
+	msg_t first_byte;
+
+	while (TRUE) {
+		// Tokenize what is left from the previous bulk read
+		while (gps_rx_pos < gps_rx_len) {
+#if GPS_USE_SIRF_BINARY
+			switch (sirf_put(&gps_sirf_parser, gps_rx_buf[gps_rx_pos++])) {
+			case SIRF_FRAME:
+				*msg_len = gps_sirf_parser.len;
+				return E_OK;
+			case SIRF_ERR_CHKSUM:
+				return E_CHKSUM_ERROR;
+			case SIRF_ERR_OVERFLOW:
+				return E_LEN_ERROR;
+			case SIRF_ERR_FORMAT:
+				return E_INVALID_DATA;
+			}
+#else
+			switch (nmea_put(&gps_parser, gps_rx_buf[gps_rx_pos++])) {
+			case NMEA_SENTENCE:
+				*msg_len = gps_parser.len;
+
+				if (nmea_index(&gps_sentence, gps_data, gps_parser.len) != NMEA_SENTENCE)
+					return E_LEN_ERROR;
+
+				return E_OK;
+			case NMEA_ERR_CHKSUM:
+				return E_CHKSUM_ERROR;
+			case NMEA_ERR_OVERFLOW:
+				return E_LEN_ERROR;
+			case NMEA_ERR_FORMAT:
+				return E_INVALID_DATA;
+			}
+#endif
+		}
 
-	if (gps_data[GPS_RMC_LATITUDE_NS_OFFSET] == 'N') {
-		state->flags |= LATITUDE_N;
-	} else if (gps_data[GPS_RMC_LATITUDE_NS_OFFSET] == 'S') {
-		state->flags |= LATITUDE_S;
-	}
+		// Sleep until data arrives, let the queue fill up and drain it at once
+		first_byte = sdGetTimeout(&GPS_SERIAL, GPS_READ_TIMEOUT_TICS);
 
-	state->longitude_degrees = atos_len(gps_data + GPS_RMC_LONGITUDE_DEG_OFFSET, 3);
-	state->longitude_seconds = atos_len(gps_data + GPS_RMC_LONGITUDE_MIN_VAL_OFFSET, 2) * 10000;
-	state->longitude_seconds += atos_len(gps_data + GPS_RMC_LONGITUDE_MIN_FRAC_OFFSET, 4);
+		if (first_byte < Q_OK)
+			return E_READ_TIMEOUT;
 
-	state->flags &= ~(LONGITUDE_E | LONGITUDE_W);
+		chThdSleepMilliseconds(GPS_RX_BATCH_MS);
 
-	if (gps_data[GPS_RMC_LONGITUDE_EW_OFFSET] == 'E') {
-		state->flags |= LONGITUDE_E;
-	} else if (gps_data[GPS_RMC_LONGITUDE_EW_OFFSET] == 'W') {
-		state->flags |= LONGITUDE_W;
+		gps_rx_buf[0] = (uint8_t)first_byte;
+		gps_rx_len = 1 + sdAsynchronousRead(&GPS_SERIAL, gps_rx_buf + 1, sizeof(gps_rx_buf) - 1);
+		gps_rx_pos = 0;
 	}
+}
 
-	i = GPS_RMC_SPEED_OFFSET;
+uint8_t gps_message_type() {
+	return nmea_message_type(&gps_sentence);
+}
 
-	len = field_len(gps_data + i);
+static void gps_publish_fix() {
+	// Edge of an epoch with a valid date and time disciplines the system clock to UTC
+	if (gps_fix_done.timestamp_us != 0 && !(gps_fix_done.nav.flags & GPS_DATA_INVALID) &&
+			(gps_fix_done.sentences & GPS_FIX_SENTENCE(GPS_MESSAGE_GPRMC)))
+		pps_set_utc(gps_fix_done.timestamp_us, fix_codec_timestamp(&gps_fix_done.nav));
 
-	if (len != 0) {
-		state->speed = atos_len(gps_data + i, len) * 100;
-		i += len + 1;
+	fix_ring_put(&gps_fix_ring, &gps_fix_done);
+	chEvtBroadcast(&gps_fix_event);
 
-		len = field_len(gps_data + i);
+	if (gps_fix_is_usable(&gps_fix_done)) {
+		gps_seed_fix = gps_fix_done;
+		gps_seed_us = pps_now_us();
+		gps_seed_valid = TRUE;
 
-		if (len != 0) {
-			state->speed += atos_len(gps_data + i, len);
-		}
-		i += len + 1;
+		led_set_pattern(LED_GPS, LED_PATTERN_GPS_FIX);
 	} else {
-		i++;
-		state->speed = 0;
+		led_set_pattern(LED_GPS, LED_PATTERN_GPS_SEARCH);
 	}
 
-	len = field_len(gps_data + i);
-
-	if (len != 0) {
-		state->course = atos_len(gps_data + i, len) * 100;
-		i += len + 1;
+}
 
-		len = field_len(gps_data + i);
+/*
+ * Merges the last received sentence into the fix of its epoch, see
+ * nmea_merge(). The fix is published once RMC and GGA of the same second
+ * are both in, or when a sentence of the next second shows up first.
+ */
+uint8_t gps_process_msg() {
+#if GPS_USE_SIRF_BINARY
+	// Geodetic Navigation Data is a complete epoch by itself
+	if (gps_data[0] != SIRF_MID_GEODETIC_NAV)
+		return E_MSG_TYPE_ERR;
 
-		if (len != 0) {
-			state->course += atos_len(gps_data + i, len);
-		}
-		i += len + 1;
-	} else {
-		i++;
-		state->course = 0;
-	}
+	if (sirf_parse_geodetic(gps_data, gps_sirf_parser.len, &gps_fix_done) != SIRF_FRAME)
+		return E_INVALID_DATA;
 
-	// Set data
+	gps_fix_done.timestamp_us = pps_epoch_time();
 
-	state->day = atos_len(gps_data + i, 2);
-	i += 2;
-	state->month = atos_len(gps_data + i, 2);
-	i += 2;
-	state->year = atos_len(gps_data + i, 2);
+	gps_publish_fix();
 
-/*
-	sdWrite(&SD1, "RMC PARSED:", sizeof("RMC PARSED:") - 1);
+	return E_OK;
+#else
+	uint8_t type = gps_message_type();
+	uint8_t res;
 
-	SPRNT(state->hour, "Hour: ", 1);
-	SPRNT(state->minute, "Minute: ", 1);
-	SPRNT(state->second, "Second: ", 1);
+	if (type == GPS_MESSAGE_UNKNOWN)
+		return E_MSG_TYPE_ERR;
 
-	SPRNT(state->day, "Day: ", 1);
-	SPRNT(state->month, "Month: ", 1);
-	SPRNT(state->year, "Year: ", 1);
+	// A sentence opening an epoch takes the last edge as its start
+	res = nmea_merge(&gps_merge, &gps_sentence, type, pps_epoch_time(), &gps_fix_done);
 
-	SPRNT(state->speed, "Speed: ", 1);
-	SPRNT(state->course, "Course: ", 1);
+	if (res & NMEA_MERGE_FIX)
+		gps_publish_fix();
 
-	SPRNT(state->flags, "Flags: ", 1);
+	if (res & NMEA_MERGE_ERR_PARSE)
+		return E_INVALID_DATA;
 
-	SPRNT(state->latitude_degrees, "Lat degrees: ", 1);
-	SPRNT(state->latitude_seconds/10000, "Lat seconds: ", 1);
-	SPRNT(state->latitude_seconds % 10000, "Lat seconds: ", 1);
+	return E_OK;
+#endif
+}
 
-	SPRNT(state->longitude_degrees, "Long degrees: ", 1);
-	SPRNT(state->longitude_seconds/10000, "Long seconds: ", 1);
-	SPRNT(state->longitude_seconds % 10000, "Long seconds: ", 1);
-*/
+/*
+ * Copies the last complete fix, returns the number of fixes published
+ * so far (0 - no fix yet).
+ */
+uint32_t gps_get_fix(gps_fix_t *fix) {
+	return fix_ring_latest(&gps_fix_ring, fix);
+}
 
+void gps_fix_reader_init(fix_ring_reader_t *reader) {
+	fix_ring_reader_init(&gps_fix_ring, reader);
+}
 
-	return E_OK;
+/*
+ * Next fix for the given consumer, never blocks. Wait on gps_fix_event
+ * to sleep until a new one is published.
+ */
+uint8_t gps_fix_read(fix_ring_reader_t *reader, gps_fix_t *fix) {
+	return fix_ring_get(&gps_fix_ring, reader, fix);
 }
 
+/*
+ * Quality gate for fixes worth sending.
+ */
+uint8_t gps_fix_is_usable(const gps_fix_t *fix) {
+	if (fix->nav.flags & GPS_DATA_INVALID)
+		return FALSE;
+
+	if (fix->sentences & GPS_FIX_SENTENCE(GPS_MESSAGE_GPGGA)) {
+		if (fix->quality == 0 || fix->satellites_used < GPS_FIX_MIN_SATELLITES)
+			return FALSE;
+
+		if (fix->hdop == 0 || fix->hdop > GPS_FIX_MAX_HDOP)
+			return FALSE;
+	}
 
+	return TRUE;
+}
+
+void gps_get_stats(gps_stats_t *stats) {
+	*stats = gps_stats;
+}
@@ -13,61 +13,86 @@
 
 #include <stdint.h>
 
-#define GPS_CMD_SEND(A) gps_write_cmd(A, sizeof(A))
-
-typedef enum GPS_MESSAGE {
-	GPS_MESSAGE_GPGGA				=	0x00,
-	GPS_MESSAGE_GPGLL				=	0x01,
-	GPS_MESSAGE_GPGSA				=	0x02,
-	GPS_MESSAGE_GPGSV				=	0x03,
-	GPS_MESSAGE_GPRMC				=	0x04,
-	GPS_MESSAGE_GPVTG				=	0x05,
-	GPS_MESSAGE_GPZDA				=	0x06,
-	GPS_MESSAGE_UNKNOWN				=	0xFF
-} GPS_MESSAGE;
-
-typedef enum GPS_STATE_FLAGS {
-	LATITUDE_N				=	1 << 0,
-	LATITUDE_S				=	1 << 1,
-	LONGITUDE_E				=	1 << 2,
-	LONGITUDE_W				=	1 << 3,
-	GPS_DATA_INVALID		=	1 << 4
-} GPS_STATE_FLAGS;
-
-typedef struct gps_rmc_state {
-	uint8_t latitude_degrees;
-	uint32_t latitude_seconds;
-
-	uint8_t longitude_degrees;
-	uint32_t longitude_seconds;
-
-	uint8_t flags;
-
-	uint16_t speed;
-	uint16_t course;
-
-	uint8_t day;
-	uint8_t month;
-	uint8_t year;
-
-	uint8_t hour;
-	uint8_t minute;
-	uint8_t second;
-} gps_rmc_state_t;
+#include "gps_fix.h"
+#include "fixring.h"
+
+// String literal without its terminating zero
+#define GPS_CMD_SEND(A) gps_write_cmd((const uint8_t *)(A), sizeof(A) - 1)
+
+/*
+ * Switch the receiver to SiRF binary protocol and read Geodetic Navigation
+ * Data (MID 41) instead of NMEA text. One 99 byte frame replaces RMC + GGA
+ * and needs no decimal conversion.
+ */
+#if !defined(GPS_USE_SIRF_BINARY)
+#define GPS_USE_SIRF_BINARY		FALSE
+#endif
+
+// Worst accepted horizontal dilution of precision, 1/100 units
+#define GPS_FIX_MAX_HDOP		500
+
+#define GPS_FIX_MIN_SATELLITES	4
+
+/*
+ * Receiver is power cycled and reconfigured only after this long without
+ * a single valid sentence. Broken sentences are dropped and counted, the
+ * tokenizer resyncs on the next start symbol by itself.
+ */
+#if !defined(GPS_RESET_TIMEOUT_S)
+#define GPS_RESET_TIMEOUT_S		10
+#endif
+
+/*
+ * Receive path counters for diagnostics, kept since power on.
+ */
+typedef struct gps_stats {
+	// Sentences (frames in binary mode) with a valid checksum
+	uint32_t sentences;
+
+	// No byte within GPS_READ_TIMEOUT_TICS
+	uint32_t timeouts;
+	// Sentence longer than the receive buffer
+	uint32_t overruns;
+	uint32_t chksum_errors;
+	// Framing errors: sentence cut by a new start symbol, bad checksum digits
+	uint32_t format_errors;
+
+	uint32_t unknown_types;
+	uint32_t parse_errors;
+
+	uint32_t resets;
+	// Resets after which the receiver had lost its settings
+	uint32_t reconfigurations;
+
+	// Times the receiver was powered down while parked
+	uint32_t sleeps;
+} gps_stats_t;
 
 extern void init_gps();
 
 extern void gps_reset();
 
-void gps_write_cmd(uint8_t * cmd_buf, uint8_t len);
+void gps_write_cmd(const uint8_t * cmd_buf, uint8_t len);
+
+void gps_write_sirf(const uint8_t * payload, uint8_t len);
 
 uint8_t gps_read_msg(size_t *msg_len);
 
 uint8_t gps_message_type();
 
-uint8_t check_checksum();
+uint8_t gps_process_msg();
+
+extern EventSource gps_fix_event;
+
+extern uint32_t gps_get_fix(gps_fix_t *fix);
+
+extern void gps_fix_reader_init(fix_ring_reader_t *reader);
+
+extern uint8_t gps_fix_read(fix_ring_reader_t *reader, gps_fix_t *fix);
+
+extern uint8_t gps_fix_is_usable(const gps_fix_t *fix);
 
-uint8_t parse_gps_rmc(gps_rmc_state_t * state);
+extern void gps_get_stats(gps_stats_t *stats);
 
 
 #endif /* GPS_H_ */
@@ -0,0 +1,94 @@
+/*
+ * gps_fix.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef GPS_FIX_H_
+#define GPS_FIX_H_
+
+#include <stdint.h>
+
+typedef enum GPS_MESSAGE {
+	GPS_MESSAGE_GPGGA				=	0x00,
+	GPS_MESSAGE_GPGLL				=	0x01,
+	GPS_MESSAGE_GPGSA				=	0x02,
+	GPS_MESSAGE_GPGSV				=	0x03,
+	GPS_MESSAGE_GPRMC				=	0x04,
+	GPS_MESSAGE_GPVTG				=	0x05,
+	GPS_MESSAGE_GPZDA				=	0x06,
+	GPS_MESSAGE_UNKNOWN				=	0xFF
+} GPS_MESSAGE;
+
+typedef enum GPS_STATE_FLAGS {
+	LATITUDE_N				=	1 << 0,
+	LATITUDE_S				=	1 << 1,
+	LONGITUDE_E				=	1 << 2,
+	LONGITUDE_W				=	1 << 3,
+	GPS_DATA_INVALID		=	1 << 4
+} GPS_STATE_FLAGS;
+
+typedef enum GPS_FIX_MODE {
+	GPS_FIX_MODE_NONE		=	0x01,
+	GPS_FIX_MODE_2D			=	0x02,
+	GPS_FIX_MODE_3D			=	0x03
+} GPS_FIX_MODE;
+
+// Bit of gps_fix_t.sentences for the given GPS_MESSAGE
+#define GPS_FIX_SENTENCE(T)		(1 << (T))
+
+typedef struct gps_rmc_state {
+	uint8_t latitude_degrees;
+	uint32_t latitude_seconds;
+
+	uint8_t longitude_degrees;
+	uint32_t longitude_seconds;
+
+	uint8_t flags;
+
+	uint16_t speed;
+	uint16_t course;
+
+	uint8_t day;
+	uint8_t month;
+	uint8_t year;
+
+	uint8_t hour;
+	uint8_t minute;
+	uint8_t second;
+} gps_rmc_state_t;
+
+/*
+ * All sentences of one receiver epoch (one UTC second) merged together.
+ * nav holds position, speed, course, date and time, the rest are quality
+ * metrics from GGA/GSA/GSV.
+ */
+typedef struct gps_fix {
+	gps_rmc_state_t nav;
+
+	// Seconds of the day of nav time, identifies the epoch
+	uint32_t epoch;
+
+	// System time of the 1PPS edge the epoch started at, microseconds
+	// as pps_now_us() counts them, 0 when no edge was seen
+	uint64_t timestamp_us;
+
+	// Altitude above mean sea level, 1/10 m
+	int32_t altitude;
+
+	// Dilution of precision, 1/100 units
+	uint16_t hdop;
+	uint16_t pdop;
+	uint16_t vdop;
+
+	uint8_t quality;
+	uint8_t mode;
+
+	uint8_t satellites_used;
+	uint8_t satellites_in_view;
+
+	// GPS_FIX_SENTENCE() mask of the sentences merged into this fix
+	uint8_t sentences;
+} gps_fix_t;
+
+#endif /* GPS_FIX_H_ */
@@ -0,0 +1,46 @@
+/*
+ * i2cbus.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * I2C1 with the devices on it. Callers hold the bus with
+ * i2cAcquireBus(&I2C_BUS) around their transfers.
+ */
+
+#include "i2cbus.h"
+#include "lowpower.h"
+
+static const I2CConfig i2c_bus_config = {
+	OPMODE_I2C,
+	I2C_BUS_CLOCK,
+	FAST_DUTY_CYCLE_2
+};
+
+void i2c_bus_start(void) {
+	palSetPadMode(I2C_PORT, I2C_SCL_PIN, PAL_MODE_ALTERNATE(4) | PAL_STM32_OTYPE_OPENDRAIN);
+	palSetPadMode(I2C_PORT, I2C_SDA_PIN, PAL_MODE_ALTERNATE(4) | PAL_STM32_OTYPE_OPENDRAIN);
+
+	i2cStart(&I2C_BUS, &i2c_bus_config);
+}
+
+/*
+ * Writes txn bytes and reads rxn back, rxn is 0 or 2 and more. A timed
+ * out transfer leaves the driver locked, it is restarted then.
+ */
+uint8_t i2c_bus_transfer(i2caddr_t addr, const uint8_t *tx, size_t txn, uint8_t *rx, size_t rxn) {
+	msg_t res;
+
+	// The peripheral clock stops in STOP mode
+	lowpower_inhibit();
+	res = i2cMasterTransmitTimeout(&I2C_BUS, addr, tx, txn, rx, rxn, MS2ST(I2C_BUS_TIMEOUT_MS));
+	lowpower_allow();
+
+	if (res == RDY_TIMEOUT) {
+		i2cStop(&I2C_BUS);
+		i2cStart(&I2C_BUS, &i2c_bus_config);
+
+		return I2C_BUS_ERR_TIMEOUT;
+	}
+
+	return res == RDY_OK ? I2C_BUS_OK : I2C_BUS_ERR_NACK;
+}
@@ -0,0 +1,38 @@
+/*
+ * i2cbus.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef I2CBUS_H_
+#define I2CBUS_H_
+
+#include "ch.h"
+#include "hal.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Shared by the EEPROM and the accelerometer
+#define I2C_BUS					I2CD1
+
+#if !defined(I2C_BUS_CLOCK)
+#define I2C_BUS_CLOCK			400000
+#endif
+
+// Longest transfer on the bus, ms
+#if !defined(I2C_BUS_TIMEOUT_MS)
+#define I2C_BUS_TIMEOUT_MS		20
+#endif
+
+typedef enum I2C_BUS_RESULT {
+	I2C_BUS_OK				=	0x00,
+	I2C_BUS_ERR_NACK		=	0x01,
+	I2C_BUS_ERR_TIMEOUT		=	0x02
+} I2C_BUS_RESULT;
+
+extern void i2c_bus_start(void);
+
+extern uint8_t i2c_bus_transfer(i2caddr_t addr, const uint8_t *tx, size_t txn, uint8_t *rx, size_t rxn);
+
+#endif /* I2CBUS_H_ */
@@ -1,49 +1,114 @@
+/*
+ * led.c
+ *
+ *  Created on: 25.01.2012
+ *      Author: dimaz
+ *
+ * LED blink patterns run from virtual timer callbacks, one timer per LED
+ * armed only while its pattern blinks. A steady or dark LED costs no
+ * wakeups at all.
+ */
+
 #include "led.h"
 
 #include "ch.h"
 #include "hal.h"
 
-volatile uint8_t led_0_prescaler = 10, led_1_prescaler = 10;
-volatile uint8_t led_0_counter = 0, led_1_counter = 0;
+#define LED_PATTERN_STEPS		8
 
-// LED blinker thread
-static WORKING_AREA(waLedBlinkThread, 8);
-static msg_t ledBlinkThread(void *arg) {
-	(void)arg;
-	chRegSetThreadName("led_blinker");
+// Step that holds its level, the timer is not armed again
+#define LED_FOREVER				0xFFFF
 
-	palSetPadMode(GPIO_LED_0_PORT, GPIO_LED_0_PIN, PAL_MODE_OUTPUT_PUSHPULL);
-	palSetPadMode(GPIO_LED_1_PORT, GPIO_LED_1_PIN, PAL_MODE_OUTPUT_PUSHPULL);
+/*
+ * On and off times in ms, starting with on. The pattern repeats from the
+ * start at a 0 or after the last step, a pattern starting with 0 is dark.
+ */
+static const uint16_t led_patterns[LED_PATTERN_COUNT][LED_PATTERN_STEPS] = {
+	[LED_PATTERN_OFF]				= { 0 },
+	[LED_PATTERN_ON]				= { LED_FOREVER },
+	[LED_PATTERN_GPS_SEARCH]		= { 100, 900, 0 },
+	[LED_PATTERN_GPS_FIX]			= { 50, 2950, 0 },
+	[LED_PATTERN_GPRS_SEARCH]		= { 100, 400, 0 },
+	[LED_PATTERN_GPRS_REGISTERED]	= { 50, 2950, 0 },
+	[LED_PATTERN_GPRS_ONLINE]		= { 50, 150, 50, 2750, 0 },
+	[LED_PATTERN_ERROR]				= { 100, 100, 100, 100, 100, 700, 0 }
+};
 
-	palClearPad(GPIO_LED_0_PORT, GPIO_LED_0_PIN);
-	palSetPad(GPIO_LED_1_PORT, GPIO_LED_1_PIN);
+typedef struct led {
+	ioportid_t port;
+	uint8_t pad;
 
-	while (TRUE) {
-		if (led_0_counter++ == led_0_prescaler) {
-			palTogglePad(GPIO_LED_0_PORT, GPIO_LED_0_PIN);
-			led_0_counter = 0;
-		}
+	uint8_t pattern;
+	uint8_t step;
+	VirtualTimer timer;
+} led_t;
 
-		if (led_1_counter++ == led_1_prescaler) {
-			palTogglePad(GPIO_LED_1_PORT, GPIO_LED_1_PIN);
-			led_1_counter = 0;
-		}
+static led_t leds[LED_COUNT] = {
+	{ .port = GPIO_LED_0_PORT, .pad = GPIO_LED_0_PIN, .pattern = LED_PATTERN_OFF },
+	{ .port = GPIO_LED_1_PORT, .pad = GPIO_LED_1_PIN, .pattern = LED_PATTERN_OFF }
+};
 
-		chThdSleepMilliseconds(50);
-	}
-}
+/*
+ * Timer callback, runs locked. Sets the level of the current step and
+ * arms the timer for its length.
+ */
+static void led_step(void *arg) {
+	led_t *led = arg;
+	const uint16_t *steps = led_patterns[led->pattern];
+	uint16_t ms;
+
+	if (led->step >= LED_PATTERN_STEPS || steps[led->step] == 0)
+		led->step = 0;
+
+	ms = steps[led->step];
 
-void start_led_thread() {
-	// LED Thread
-	chThdCreateStatic(waLedBlinkThread, sizeof(waLedBlinkThread), IDLEPRIO, ledBlinkThread, NULL);
+	if (ms == 0 || led->step & 1)
+		palClearPad(led->port, led->pad);
+	else
+		palSetPad(led->port, led->pad);
+
+	if (ms == 0 || ms == LED_FOREVER)
+		return;
+
+	led->step++;
+	chVTSetI(&led->timer, MS2ST(ms), led_step, led);
 }
 
-void set_led_0_prescaler(uint8_t prescaler) {
-	led_0_prescaler = prescaler;
-	led_0_counter = 0;
+void led_init() {
+	uint8_t i;
+
+	for (i = 0; i < LED_COUNT; i++) {
+		palClearPad(leds[i].port, leds[i].pad);
+		palSetPadMode(leds[i].port, leds[i].pad, PAL_MODE_OUTPUT_PUSHPULL);
+	}
+
+	led_set_pattern(LED_GPRS, LED_PATTERN_GPRS_SEARCH);
+	led_set_pattern(LED_GPS, LED_PATTERN_GPS_SEARCH);
 }
 
-void set_led_1_prescaler(uint8_t prescaler) {
-	led_1_prescaler = prescaler;
-	led_1_counter = 0;
+/*
+ * Starts the pattern from its first step. Setting the pattern that runs
+ * already leaves it alone, so it can be set on every update.
+ */
+void led_set_pattern(uint8_t n, uint8_t pattern) {
+	led_t *led;
+
+	if (n >= LED_COUNT || pattern >= LED_PATTERN_COUNT)
+		return;
+
+	led = &leds[n];
+
+	chSysLock();
+
+	if (led->pattern != pattern) {
+		if (chVTIsArmedI(&led->timer))
+			chVTResetI(&led->timer);
+
+		led->pattern = pattern;
+		led->step = 0;
+
+		led_step(led);
+	}
+
+	chSysUnlock();
 }
@@ -10,10 +10,29 @@
 
 #include <stdint.h>
 
-extern void start_led_thread();
+// LED 0 shows the modem, LED 1 the receiver
+#define LED_GPRS				0
+#define LED_GPS					1
 
-extern void set_led_0_prescaler(uint8_t prescaler);
+#define LED_COUNT				2
 
-extern void set_led_1_prescaler(uint8_t prescaler);
+typedef enum LED_PATTERN {
+	LED_PATTERN_OFF				=	0x00,
+	LED_PATTERN_ON				=	0x01,
+	// No usable fix yet
+	LED_PATTERN_GPS_SEARCH		=	0x02,
+	LED_PATTERN_GPS_FIX			=	0x03,
+	// Modem starting up or looking for the network
+	LED_PATTERN_GPRS_SEARCH		=	0x04,
+	LED_PATTERN_GPRS_REGISTERED	=	0x05,
+	// Bearer up or socket open
+	LED_PATTERN_GPRS_ONLINE		=	0x06,
+	LED_PATTERN_ERROR			=	0x07,
+	LED_PATTERN_COUNT
+} LED_PATTERN;
+
+extern void led_init();
+
+extern void led_set_pattern(uint8_t n, uint8_t pattern);
 
 #endif /* LED_H_ */
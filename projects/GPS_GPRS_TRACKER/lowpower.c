@@ -0,0 +1,349 @@
+/*
+ * lowpower.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Tickless idle. With nothing to do until the next virtual timer the
+ * idle thread stops the core in STOP mode and lets the RTC wakeup timer
+ * bring it back, the system time is then moved on by the time slept.
+ * Drivers that cannot lose their clock hold STOP off with
+ * lowpower_inhibit(), the idle thread only sleeps then. The RTC calendar
+ * also carries UTC, set from the GPS (pps.c).
+ */
+
+#include "lowpower.h"
+
+static volatile uint8_t lowpower_inhibits = 0;
+
+static lowpower_stats_t lowpower_stats;
+
+#if !defined(SIMULATOR)
+#define LOWPOWER_RTC_UNLOCK()	do { RTC->WPR = 0xCA; RTC->WPR = 0x53; } while (0)
+#define LOWPOWER_RTC_LOCK()		do { RTC->WPR = 0xFF; } while (0)
+
+// Serial drivers that must have sent everything, the UART stops with the clock
+static SerialDriver * const lowpower_serials[] = { &SD1, &SD2, &SD3 };
+
+#if HAL_USE_EXT
+/*
+ * EXT callback of the RTC wakeup line. The idle thread reads and clears
+ * the timer flag itself, only the line had to wake the core.
+ */
+void lowpower_wakeup_cb(EXTDriver *extp, expchannel_t channel) {
+	(void)extp;
+	(void)channel;
+}
+#endif
+
+/*
+ * Locked. Ticks the core may spend in STOP from now on, 0 when it must
+ * not stop: the first virtual timer has to fire on its tick, not later.
+ */
+static systime_t lowpower_stop_ticks(void) {
+	systime_t ticks = MS2ST(LOWPOWER_MAX_STOP_MS);
+	uint8_t i;
+
+	// Nothing would end STOP before the EXT driver enables the wakeup line
+	if (lowpower_inhibits > 0 || EXTD1.state != EXT_ACTIVE)
+		return 0;
+
+	for (i = 0; i < sizeof(lowpower_serials) / sizeof(lowpower_serials[0]); i++) {
+		SerialDriver *sdp = lowpower_serials[i];
+
+		if (sdp->state == SD_READY &&
+				(!chOQIsEmptyI(&sdp->oqueue) || (sdp->usart->SR & USART_SR_TC) == 0))
+			return 0;
+	}
+
+	if (&vtlist != (VTList *)vtlist.vt_next && vtlist.vt_next->vt_time - 1 < ticks)
+		ticks = vtlist.vt_next->vt_time - 1;
+
+	return ticks >= MS2ST(LOWPOWER_MIN_STOP_MS) ? ticks : 0;
+}
+
+/*
+ * Time and date registers of the RTC calendar. The shadow registers are
+ * not updated in STOP, so they are synchronized first.
+ */
+static void lowpower_rtc_read(uint32_t *tr, uint32_t *dr) {
+	LOWPOWER_RTC_UNLOCK();
+	RTC->ISR = ~(RTC_ISR_RSF | RTC_ISR_INIT);
+	LOWPOWER_RTC_LOCK();
+
+	while ((RTC->ISR & RTC_ISR_RSF) == 0)
+		;
+
+	// Reading TR holds the shadow registers until DR is read
+	*tr = RTC->TR;
+	*dr = RTC->DR;
+}
+
+static uint32_t lowpower_rtc_tod(uint32_t tr) {
+	return (((tr >> 20) & 0x3) * 10 + ((tr >> 16) & 0xF)) * 3600 +
+			(((tr >> 12) & 0x7) * 10 + ((tr >> 8) & 0xF)) * 60 +
+			((tr >> 4) & 0x7) * 10 + (tr & 0xF);
+}
+
+/*
+ * Time of day from the RTC calendar, seconds.
+ */
+static uint32_t lowpower_rtc_seconds(void) {
+	uint32_t tr, dr;
+
+	lowpower_rtc_read(&tr, &dr);
+
+	return lowpower_rtc_tod(tr);
+}
+
+static uint32_t lowpower_bcd(uint32_t value) {
+	return (value / 10) << 4 | value % 10;
+}
+
+static uint8_t lowpower_month_days(uint32_t year, uint32_t month) {
+	static const uint8_t days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+	// Every 4th year from 2000 to 2099 is a leap year
+	return days[month] + (month == 1 && year % 4 == 0);
+}
+
+/*
+ * Sets the calendar to UTC, seconds since 2000-01-01. The calendar stops
+ * while in init mode, for about two RTCCLK periods.
+ */
+void lowpower_rtc_set(uint32_t utc_s) {
+	uint32_t days = utc_s / 86400, tod = utc_s % 86400;
+	uint32_t year = 0, month = 0, tr, dr;
+
+	while (days >= (year % 4 == 0 ? 366U : 365U)) {
+		days -= year % 4 == 0 ? 366 : 365;
+		year++;
+	}
+
+	while (days >= lowpower_month_days(year, month)) {
+		days -= lowpower_month_days(year, month);
+		month++;
+	}
+
+	tr = lowpower_bcd(tod / 3600) << 16 | lowpower_bcd(tod / 60 % 60) << 8 | lowpower_bcd(tod % 60);
+
+	// 2000-01-01 was a Saturday, week days count from Monday = 1
+	dr = lowpower_bcd(year) << 16 | ((utc_s / 86400 + 5) % 7 + 1) << 13 |
+			lowpower_bcd(month + 1) << 8 | lowpower_bcd(days + 1);
+
+	chSysLock();
+	LOWPOWER_RTC_UNLOCK();
+
+	// Flags are cleared by writing 0, the ones stay
+	RTC->ISR = ~0UL;
+	while ((RTC->ISR & RTC_ISR_INITF) == 0)
+		;
+
+	RTC->TR = tr;
+	RTC->DR = dr;
+	RTC->ISR = ~RTC_ISR_INIT;
+
+	LOWPOWER_RTC_LOCK();
+	chSysUnlock();
+}
+
+/*
+ * UTC from the calendar, seconds since 2000-01-01. Returns FALSE when it
+ * was never set since the backup domain lost power.
+ */
+uint8_t lowpower_rtc_get(uint32_t *utc_s) {
+	uint32_t tr, dr, year, month, day, days, i;
+
+	// Year 2000 is what the calendar starts at
+	if ((RTC->ISR & RTC_ISR_INITS) == 0)
+		return FALSE;
+
+	chSysLock();
+	lowpower_rtc_read(&tr, &dr);
+	chSysUnlock();
+
+	year = ((dr >> 20) & 0xF) * 10 + ((dr >> 16) & 0xF);
+	month = ((dr >> 12) & 0x1) * 10 + ((dr >> 8) & 0xF);
+	day = ((dr >> 4) & 0x3) * 10 + (dr & 0xF);
+
+	if (month < 1 || month > 12 || day < 1)
+		return FALSE;
+
+	days = year * 365 + (year + 3) / 4 + day - 1;
+
+	for (i = 0; i < month - 1; i++)
+		days += lowpower_month_days(year, i);
+
+	*utc_s = days * 86400 + lowpower_rtc_tod(tr);
+
+	return TRUE;
+}
+
+static void lowpower_wut_start(uint32_t counts) {
+	LOWPOWER_RTC_UNLOCK();
+
+	RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+	while ((RTC->ISR & RTC_ISR_WUTWF) == 0)
+		;
+
+	// RTCCLK / 16, WUCKSEL 000
+	RTC->WUTR = counts - 1;
+	RTC->ISR = ~(RTC_ISR_WUTF | RTC_ISR_INIT);
+	EXTI->PR = 1 << 20;
+	RTC->CR = (RTC->CR & ~RTC_CR_WUCKSEL) | RTC_CR_WUTIE | RTC_CR_WUTE;
+
+	LOWPOWER_RTC_LOCK();
+}
+
+static void lowpower_wut_stop(void) {
+	LOWPOWER_RTC_UNLOCK();
+
+	RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+	RTC->ISR = ~(RTC_ISR_WUTF | RTC_ISR_INIT);
+
+	LOWPOWER_RTC_LOCK();
+}
+
+/*
+ * The core comes out of STOP on the MSI. Brings back the clocks hal_lld
+ * started, stm32_clock_init() would also reset the peripheral clocks.
+ */
+static void lowpower_clock_restore(void) {
+#if STM32_HSI_ENABLED
+	RCC->CR |= RCC_CR_HSION;
+	while ((RCC->CR & RCC_CR_HSIRDY) == 0)
+		;
+#endif
+
+#if STM32_HSE_ENABLED
+	RCC->CR |= RCC_CR_HSEON;
+	while ((RCC->CR & RCC_CR_HSERDY) == 0)
+		;
+#endif
+
+#if STM32_ACTIVATE_PLL
+	RCC->CR |= RCC_CR_PLLON;
+	while ((RCC->CR & RCC_CR_PLLRDY) == 0)
+		;
+#endif
+
+#if STM32_SW != STM32_SW_MSI
+	RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | STM32_SW;
+	while ((RCC->CFGR & RCC_CFGR_SWS) != (STM32_SW << 2))
+		;
+#endif
+}
+
+/*
+ * Moves the system time and the first virtual timer on by the ticks the
+ * SysTick missed. They are fewer than the timer had left.
+ */
+static void lowpower_advance(systime_t ticks) {
+	vtlist.vt_systime += ticks;
+
+	if (&vtlist != (VTList *)vtlist.vt_next)
+		vtlist.vt_next->vt_time -= ticks;
+}
+
+/*
+ * Idle loop hook. Interrupts stay masked from the decision to the time
+ * compensation, a pending one only ends the WFI early.
+ */
+void lowpower_idle(void) {
+	systime_t ticks, slept;
+	uint32_t counts, before, elapsed;
+
+	chSysLock();
+	ticks = lowpower_stop_ticks();
+	__disable_irq();
+	chSysUnlock();
+
+	if (ticks == 0) {
+		lowpower_stats.sleeps++;
+
+		__WFI();
+		__enable_irq();
+
+		return;
+	}
+
+	counts = (uint32_t)ticks * LOWPOWER_WUT_HZ / CH_FREQUENCY;
+	before = lowpower_rtc_seconds();
+
+	// Modem data waits under flow control while the UART is stopped
+	palSetPad(GPRS_USART_PORT, GPRS_USART_RTS_PIN);
+	palSetPadMode(GPRS_USART_PORT, GPRS_USART_RTS_PIN, PAL_MODE_OUTPUT_PUSHPULL);
+
+	lowpower_wut_start(counts);
+
+	// STOP with the regulator in low power mode
+	PWR->CR = (PWR->CR & ~PWR_CR_PDDS) | PWR_CR_LPSDSR | PWR_CR_CWUF;
+	SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+	__WFI();
+	SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+
+	lowpower_clock_restore();
+
+	if (RTC->ISR & RTC_ISR_WUTF) {
+		slept = counts * CH_FREQUENCY / LOWPOWER_WUT_HZ;
+	} else {
+		// No subseconds on this part: the time of an early wakeup is known to the second, rounded down
+		elapsed = (lowpower_rtc_seconds() + 86400 - before) % 86400;
+		slept = elapsed * CH_FREQUENCY < ticks ? elapsed * CH_FREQUENCY : ticks;
+
+		lowpower_stats.early_wakeups++;
+	}
+
+	lowpower_wut_stop();
+
+	palSetPadMode(GPRS_USART_PORT, GPRS_USART_RTS_PIN, PAL_MODE_ALTERNATE(7));
+
+	lowpower_advance(slept);
+
+	lowpower_stats.stops++;
+	lowpower_stats.stop_ticks += slept;
+
+	__enable_irq();
+}
+#else
+// No RTC in the simulator, UTC is only known while there are fixes
+void lowpower_rtc_set(uint32_t utc_s) {
+	(void)utc_s;
+}
+
+uint8_t lowpower_rtc_get(uint32_t *utc_s) {
+	(void)utc_s;
+
+	return FALSE;
+}
+#endif
+
+/*
+ * Holds STOP off until the matching lowpower_allow(), calls nest. The _i
+ * variants are for locked callers and ISRs.
+ */
+void lowpower_inhibit_i(void) {
+	lowpower_inhibits++;
+}
+
+void lowpower_allow_i(void) {
+	if (lowpower_inhibits > 0)
+		lowpower_inhibits--;
+}
+
+void lowpower_inhibit(void) {
+	chSysLock();
+	lowpower_inhibit_i();
+	chSysUnlock();
+}
+
+void lowpower_allow(void) {
+	chSysLock();
+	lowpower_allow_i();
+	chSysUnlock();
+}
+
+void lowpower_get_stats(lowpower_stats_t *stats) {
+	chSysLock();
+	*stats = lowpower_stats;
+	chSysUnlock();
+}
@@ -0,0 +1,69 @@
+/*
+ * lowpower.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef LOWPOWER_H_
+#define LOWPOWER_H_
+
+#include "ch.h"
+#include "hal.h"
+
+#include <stdint.h>
+
+// Shorter idle periods are spent in sleep, STOP does not pay off: the HSE takes about 2 ms to start, ms
+#if !defined(LOWPOWER_MIN_STOP_MS)
+#define LOWPOWER_MIN_STOP_MS	10
+#endif
+
+// Longest STOP period, the wakeup timer counts RTCCLK / 16 in 16 bits, ms
+#if !defined(LOWPOWER_MAX_STOP_MS)
+#define LOWPOWER_MAX_STOP_MS	30000
+#endif
+
+// Wakeup timer clock, RTCCLK / 16 of the 32768 Hz LSE
+#define LOWPOWER_WUT_HZ			2048
+
+#if LOWPOWER_MAX_STOP_MS * LOWPOWER_WUT_HZ / 1000 > 0xFFFF
+#error "LOWPOWER_MAX_STOP_MS does not fit the wakeup timer"
+#endif
+
+/*
+ * Idle counters for diagnostics, kept since power on. stop_ticks against
+ * chTimeNow() is the share of time spent in STOP.
+ */
+typedef struct lowpower_stats {
+	uint32_t stops;
+
+	// System ticks spent in STOP
+	uint32_t stop_ticks;
+
+	// STOP periods ended by an interrupt before the wakeup timer
+	uint32_t early_wakeups;
+
+	// Idle periods spent in sleep as STOP was held off or too short
+	uint32_t sleeps;
+} lowpower_stats_t;
+
+#if HAL_USE_EXT
+extern void lowpower_wakeup_cb(EXTDriver *extp, expchannel_t channel);
+#endif
+
+extern void lowpower_idle(void);
+
+extern void lowpower_inhibit_i(void);
+
+extern void lowpower_allow_i(void);
+
+extern void lowpower_inhibit(void);
+
+extern void lowpower_allow(void);
+
+extern void lowpower_get_stats(lowpower_stats_t *stats);
+
+extern void lowpower_rtc_set(uint32_t utc_s);
+
+extern uint8_t lowpower_rtc_get(uint32_t *utc_s);
+
+#endif /* LOWPOWER_H_ */
@@ -25,12 +25,53 @@
 #include "gprs.h"
 #include "power.h"
 #include "led.h"
+#include "bufpool.h"
+#include "pps.h"
+#include "i2cbus.h"
+#include "motion.h"
+#include "lowpower.h"
 
 SerialConfig SD1_Config = {
    .sc_speed = 19200,
    .sc_cr2 = USART_CR2_STOP1_BITS
 };
 
+/*
+ * External interrupt lines, line n is pin n of the port selected for it.
+ */
+static const EXTConfig EXT_Config = {
+  {
+    {EXT_CH_MODE_DISABLED, NULL},
+    {EXT_CH_MODE_DISABLED, NULL},
+    {EXT_CH_MODE_DISABLED, NULL},
+    {EXT_CH_MODE_DISABLED, NULL},
+    {EXT_CH_MODE_DISABLED, NULL},
+    {EXT_CH_MODE_DISABLED, NULL},
+    // Accelerometer INT1, wake-up on motion
+    {EXT_CH_MODE_RISING_EDGE | EXT_CH_MODE_AUTOSTART, motion_ext_cb},
+    {EXT_CH_MODE_DISABLED, NULL},
+    {EXT_CH_MODE_DISABLED, NULL},
+    {EXT_CH_MODE_DISABLED, NULL},
+    {EXT_CH_MODE_DISABLED, NULL},
+    {EXT_CH_MODE_DISABLED, NULL},
+    {EXT_CH_MODE_DISABLED, NULL},
+    {EXT_CH_MODE_DISABLED, NULL},
+    {EXT_CH_MODE_DISABLED, NULL},
+    // GPS 1PPS
+    {EXT_CH_MODE_RISING_EDGE | EXT_CH_MODE_AUTOSTART, pps_ext_cb},
+    {EXT_CH_MODE_DISABLED, NULL},
+    {EXT_CH_MODE_DISABLED, NULL},
+    {EXT_CH_MODE_DISABLED, NULL},
+    {EXT_CH_MODE_DISABLED, NULL},
+    // RTC wakeup timer, ends STOP mode
+    {EXT_CH_MODE_RISING_EDGE | EXT_CH_MODE_AUTOSTART, lowpower_wakeup_cb},
+    {EXT_CH_MODE_DISABLED, NULL},
+    {EXT_CH_MODE_DISABLED, NULL}
+  },
+  EXT_MODE_EXTI(0, 0, 0, 0, 0, 0, EXT_MODE_GPIOB, 0,
+                0, 0, 0, 0, 0, 0, 0, EXT_MODE_GPIOB)
+};
+
 
 /*
  * Application entry point.
@@ -47,17 +88,27 @@ int main(void) {
   halInit();
   chSysInit();
 
+  bufpool_init();
+
   sdStart(&SD1, &SD1_Config);
   palSetPadMode(EXT_USART_PORT, EXT_USART_TX_PIN, PAL_MODE_ALTERNATE(7));
   palSetPadMode(EXT_USART_PORT, EXT_USART_RX_PIN, PAL_MODE_ALTERNATE(7));
 
-  start_led_thread();
+  led_init();
+
+  // EEPROM and accelerometer
+  i2c_bus_start();
+  motion_init();
 
   init_gprs();
 
+  palSetPadMode(GPIO_GPS_PULSE_PORT, GPIO_GPS_PULSE_PIN, PAL_MODE_INPUT);
+  extStart(&EXTD1, &EXT_Config);
+
   init_gps();
 
-  //init_power_ctl();
+  // Supply monitor, reports through power_event
+  init_power_ctl();
 
   /*
    * Normal main() thread activity, in this demo it does nothing except
@@ -66,10 +117,7 @@ int main(void) {
    * driver 1.
    */
   while (TRUE) {
-	  chThdSleepMilliseconds(500);
-	  //update_power_state();
-    //chThdSleepMilliseconds(500);
-    //print_power_state();
-
+	  // Woken by nothing, a periodic wakeup would cut the STOP periods short
+	  chThdSleep(TIME_INFINITE);
   }
 }
@@ -0,0 +1,115 @@
+/*
+ * motion.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Parked or moving, from the accelerometer wake-up interrupt. Every edge
+ * on INT1 restarts a timer of MOTION_STATIONARY_S, the vehicle is parked
+ * when it runs out. Without a working accelerometer it never parks.
+ */
+
+#include "motion.h"
+
+#if !defined(SIMULATOR)
+#include "accel.h"
+#endif
+
+EVENTSOURCE_DECL(motion_event);
+
+static VirtualTimer motion_timer;
+
+// A floating INT1 without a working part must not park the vehicle for good
+static uint8_t motion_present = FALSE;
+static volatile uint8_t motion_moving = TRUE;
+static systime_t motion_parked_at;
+
+static motion_stats_t motion_stats;
+
+/*
+ * Timer callback, runs locked: no motion for MOTION_STATIONARY_S.
+ */
+static void motion_park(void *arg) {
+	(void)arg;
+
+	motion_moving = FALSE;
+	motion_parked_at = chTimeNow();
+	motion_stats.parks++;
+
+	chEvtBroadcastI(&motion_event);
+}
+
+#if HAL_USE_EXT
+/*
+ * EXT callback of the accelerometer INT1 line, rising edge.
+ */
+void motion_ext_cb(EXTDriver *extp, expchannel_t channel) {
+	(void)extp;
+	(void)channel;
+
+	if (!motion_present)
+		return;
+
+	chSysLockFromIsr();
+
+	motion_stats.interrupts++;
+
+	if (chVTIsArmedI(&motion_timer))
+		chVTResetI(&motion_timer);
+
+	chVTSetI(&motion_timer, S2ST(MOTION_STATIONARY_S), motion_park, NULL);
+
+	if (!motion_moving) {
+		motion_moving = TRUE;
+		motion_stats.wakeups++;
+		motion_stats.parked_s += (chTimeNow() - motion_parked_at) / CH_FREQUENCY;
+
+		chEvtBroadcastI(&motion_event);
+	}
+
+	chSysUnlockFromIsr();
+}
+#endif
+
+/*
+ * Sets up the accelerometer on the started I2C bus. Call before the
+ * EXT driver starts.
+ */
+void motion_init(void) {
+#if !defined(SIMULATOR)
+	palSetPadMode(GPIO_ACCEL_INT_1_PORT, GPIO_ACCEL_INT_1_PIN, PAL_MODE_INPUT_PULLDOWN);
+
+	if (accel_init_wakeup(MOTION_THRESHOLD_MG, MOTION_DURATION_MS) != ACCEL_OK)
+		return;
+
+	// A vehicle that is parked at power on parks after the first period
+	chSysLock();
+	motion_present = TRUE;
+	chVTSetI(&motion_timer, S2ST(MOTION_STATIONARY_S), motion_park, NULL);
+	chSysUnlock();
+#endif
+}
+
+uint8_t motion_is_moving(void) {
+	return motion_moving;
+}
+
+/*
+ * Blocks the calling thread while the vehicle is parked.
+ */
+void motion_wait_moving(void) {
+	EventListener listener;
+
+	// Registered before the check, a wakeup in between is not lost
+	chEvtRegisterMask(&motion_event, &listener, EVENT_MASK(0));
+
+	while (!motion_moving)
+		chEvtWaitOne(EVENT_MASK(0));
+
+	chEvtUnregister(&motion_event, &listener);
+}
+
+void motion_get_stats(motion_stats_t *stats) {
+	chSysLock();
+	*stats = motion_stats;
+	chSysUnlock();
+}
@@ -0,0 +1,59 @@
+/*
+ * motion.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef MOTION_H_
+#define MOTION_H_
+
+#include "ch.h"
+#include "hal.h"
+
+#include <stdint.h>
+
+// Without motion for this long the vehicle is parked and the GPS goes off, seconds
+#if !defined(MOTION_STATIONARY_S)
+#define MOTION_STATIONARY_S		300
+#endif
+
+// Acceleration that counts as motion, after the high-pass filter, mg
+#if !defined(MOTION_THRESHOLD_MG)
+#define MOTION_THRESHOLD_MG		126
+#endif
+
+// How long it has to last, ms
+#if !defined(MOTION_DURATION_MS)
+#define MOTION_DURATION_MS		30
+#endif
+
+/*
+ * Motion counters for diagnostics, kept since power on.
+ */
+typedef struct motion_stats {
+	// Accelerometer interrupts
+	uint32_t interrupts;
+
+	uint32_t parks;
+	uint32_t wakeups;
+
+	// Time parked before the current period, seconds
+	uint32_t parked_s;
+} motion_stats_t;
+
+// Broadcast when the vehicle parks and when it moves again
+extern EventSource motion_event;
+
+#if HAL_USE_EXT
+extern void motion_ext_cb(EXTDriver *extp, expchannel_t channel);
+#endif
+
+extern void motion_init(void);
+
+extern uint8_t motion_is_moving(void);
+
+extern void motion_wait_moving(void);
+
+extern void motion_get_stats(motion_stats_t *stats);
+
+#endif /* MOTION_H_ */
@@ -0,0 +1,674 @@
+/*
+ * nmea.c
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "nmea.h"
+
+#include <string.h>
+
+static int8_t hex_digit(uint8_t c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+
+	return -1;
+}
+
+void nmea_init(nmea_parser_t *p, uint8_t *buf, size_t size) {
+	p->buf = buf;
+	p->size = size;
+
+	nmea_reset(p);
+}
+
+void nmea_reset(nmea_parser_t *p) {
+	p->len = 0;
+	p->state = NMEA_STATE_IDLE;
+	p->chksum = 0;
+	p->rx_chksum = 0;
+}
+
+uint8_t nmea_put(nmea_parser_t *p, uint8_t c) {
+	int8_t digit;
+
+	// Start symbol always restarts the sentence, even in the middle of another one
+	if (c == '$') {
+		uint8_t res = p->state == NMEA_STATE_IDLE ? NMEA_PENDING : NMEA_ERR_FORMAT;
+
+		p->len = 0;
+		p->chksum = 0;
+		p->state = NMEA_STATE_BODY;
+
+		return res;
+	}
+
+	switch (p->state) {
+	case NMEA_STATE_IDLE:
+		return NMEA_PENDING;
+
+	case NMEA_STATE_BODY:
+		if (c == '*') {
+			p->state = NMEA_STATE_CHKSUM_HI;
+			return NMEA_PENDING;
+		}
+
+		if (c == '\r' || c == '\n') {
+			p->state = NMEA_STATE_IDLE;
+			return NMEA_ERR_FORMAT;
+		}
+
+		// Keep one byte for the terminating zero
+		if (p->len >= p->size - 1) {
+			p->state = NMEA_STATE_IDLE;
+			return NMEA_ERR_OVERFLOW;
+		}
+
+		p->buf[p->len++] = c;
+		p->chksum ^= c;
+
+		return NMEA_PENDING;
+
+	case NMEA_STATE_CHKSUM_HI:
+		if ((digit = hex_digit(c)) < 0) {
+			p->state = NMEA_STATE_IDLE;
+			return NMEA_ERR_FORMAT;
+		}
+
+		p->rx_chksum = digit << 4;
+		p->state = NMEA_STATE_CHKSUM_LO;
+
+		return NMEA_PENDING;
+
+	case NMEA_STATE_CHKSUM_LO:
+		p->state = NMEA_STATE_IDLE;
+
+		if ((digit = hex_digit(c)) < 0)
+			return NMEA_ERR_FORMAT;
+
+		p->rx_chksum |= digit;
+
+		if (p->rx_chksum != p->chksum)
+			return NMEA_ERR_CHKSUM;
+
+		p->buf[p->len] = '\0';
+
+		return NMEA_SENTENCE;
+	}
+
+	p->state = NMEA_STATE_IDLE;
+
+	return NMEA_ERR_FORMAT;
+}
+
+/*
+ * Wraps the sentence body into '$' body '*XX' CR LF, out must hold
+ * len + NMEA_FRAME_OVERHEAD bytes. Returns the sentence length.
+ */
+size_t nmea_frame(const uint8_t *body, size_t len, uint8_t *out) {
+	static const char hex[] = "0123456789ABCDEF";
+	uint8_t chksum = 0;
+	size_t i;
+
+	out[0] = '$';
+
+	for (i = 0; i < len; i++) {
+		out[1 + i] = body[i];
+		chksum ^= body[i];
+	}
+
+	out[1 + len] = '*';
+	out[2 + len] = hex[chksum >> 4];
+	out[3 + len] = hex[chksum & 0x0F];
+	out[4 + len] = '\r';
+	out[5 + len] = '\n';
+
+	return len + NMEA_FRAME_OVERHEAD;
+}
+
+uint8_t nmea_index(nmea_sentence_t *s, const uint8_t *buf, size_t len) {
+	size_t i;
+	uint8_t n = 0;
+
+	s->buf = buf;
+	s->fields[0].offset = 0;
+
+	for (i = 0; i < len; i++) {
+		if (buf[i] != ',')
+			continue;
+
+		s->fields[n].len = i - s->fields[n].offset;
+
+		if (++n >= NMEA_MAX_FIELDS) {
+			s->field_count = n;
+			return NMEA_ERR_OVERFLOW;
+		}
+
+		s->fields[n].offset = i + 1;
+	}
+
+	s->fields[n].len = i - s->fields[n].offset;
+	s->field_count = n + 1;
+
+	return NMEA_SENTENCE;
+}
+
+uint8_t nmea_field_empty(const nmea_sentence_t *s, uint8_t n) {
+	return n >= s->field_count || s->fields[n].len == 0;
+}
+
+uint8_t nmea_field_char(const nmea_sentence_t *s, uint8_t n) {
+	if (nmea_field_empty(s, n))
+		return 0;
+
+	return s->buf[s->fields[n].offset];
+}
+
+/*
+ * Converts len digits starting at buf, stops at the first non digit.
+ */
+static uint32_t digits_to_uint(const uint8_t *buf, uint8_t len) {
+	uint32_t value = 0;
+	uint8_t i;
+
+	for (i = 0; i < len; i++) {
+		if (buf[i] < '0' || buf[i] > '9')
+			break;
+
+		value = value * 10 + (buf[i] - '0');
+	}
+
+	return value;
+}
+
+uint32_t nmea_field_uint(const nmea_sentence_t *s, uint8_t n) {
+	if (nmea_field_empty(s, n))
+		return 0;
+
+	return digits_to_uint(s->buf + s->fields[n].offset, s->fields[n].len);
+}
+
+/*
+ * Decimal field scaled by 10^frac_digits: "22.4" with 2 digits gives 2240.
+ * Extra fraction digits are truncated, missing ones are zero padded.
+ */
+static uint32_t fixed_to_uint(const uint8_t *buf, uint8_t len, uint8_t frac_digits) {
+	uint32_t value = 0;
+	uint8_t i = 0, frac = 0, in_frac = 0;
+
+	for (i = 0; i < len; i++) {
+		if (buf[i] == '.') {
+			in_frac = 1;
+			continue;
+		}
+
+		if (buf[i] < '0' || buf[i] > '9')
+			break;
+
+		if (in_frac) {
+			if (frac == frac_digits)
+				break;
+			frac++;
+		}
+
+		value = value * 10 + (buf[i] - '0');
+	}
+
+	for (; frac < frac_digits; frac++)
+		value *= 10;
+
+	return value;
+}
+
+uint32_t nmea_field_fixed(const nmea_sentence_t *s, uint8_t n, uint8_t frac_digits) {
+	if (nmea_field_empty(s, n))
+		return 0;
+
+	return fixed_to_uint(s->buf + s->fields[n].offset, s->fields[n].len, frac_digits);
+}
+
+int32_t nmea_field_sfixed(const nmea_sentence_t *s, uint8_t n, uint8_t frac_digits) {
+	const uint8_t *buf;
+	uint8_t negative;
+	uint32_t value;
+
+	if (nmea_field_empty(s, n))
+		return 0;
+
+	buf = s->buf + s->fields[n].offset;
+	negative = buf[0] == '-';
+
+	value = fixed_to_uint(buf + negative, s->fields[n].len - negative, frac_digits);
+
+	// Saturate instead of overflowing the sign on garbage input
+	if (value > INT32_MAX)
+		value = INT32_MAX;
+
+	return negative ? -(int32_t)value : (int32_t)value;
+}
+
+/*
+ * Coordinate in (d)ddmm.mmmm form. Degrees may have any width, the two
+ * digits before the decimal point are minutes. Minutes are returned in
+ * 1/10000 minute units.
+ */
+uint8_t nmea_field_coord(const nmea_sentence_t *s, uint8_t n, uint8_t *degrees, uint32_t *minutes) {
+	const uint8_t *buf;
+	uint8_t len, dot;
+
+	if (nmea_field_empty(s, n))
+		return NMEA_ERR_FORMAT;
+
+	buf = s->buf + s->fields[n].offset;
+	len = s->fields[n].len;
+
+	for (dot = 0; dot < len && buf[dot] != '.'; dot++) {}
+
+	if (dot < 3)
+		return NMEA_ERR_FORMAT;
+
+	*degrees = digits_to_uint(buf, dot - 2);
+	*minutes = fixed_to_uint(buf + dot - 2, len - dot + 2, 4);
+
+	return NMEA_SENTENCE;
+}
+
+uint8_t nmea_field_time(const nmea_sentence_t *s, uint8_t n, uint8_t *hour, uint8_t *minute, uint8_t *second) {
+	const uint8_t *buf;
+
+	if (nmea_field_empty(s, n) || s->fields[n].len < 6)
+		return NMEA_ERR_FORMAT;
+
+	buf = s->buf + s->fields[n].offset;
+
+	*hour = digits_to_uint(buf, 2);
+	*minute = digits_to_uint(buf + 2, 2);
+	*second = digits_to_uint(buf + 4, 2);
+
+	return NMEA_SENTENCE;
+}
+
+uint8_t nmea_field_date(const nmea_sentence_t *s, uint8_t n, uint8_t *day, uint8_t *month, uint8_t *year) {
+	const uint8_t *buf;
+
+	if (nmea_field_empty(s, n) || s->fields[n].len != 6)
+		return NMEA_ERR_FORMAT;
+
+	buf = s->buf + s->fields[n].offset;
+
+	*day = digits_to_uint(buf, 2);
+	*month = digits_to_uint(buf + 2, 2);
+	*year = digits_to_uint(buf + 4, 2);
+
+	return NMEA_SENTENCE;
+}
+
+// Field numbers, field 0 is the talker + message type
+#define RMC_TIME_FIELD			1
+#define RMC_VALID_FIELD			2
+#define RMC_LATITUDE_FIELD		3
+#define RMC_LONGITUDE_FIELD		5
+#define RMC_SPEED_FIELD			7
+#define RMC_COURSE_FIELD		8
+#define RMC_DATE_FIELD			9
+#define RMC_FIELD_COUNT			10
+
+#define GGA_TIME_FIELD			1
+#define GGA_LATITUDE_FIELD		2
+#define GGA_LONGITUDE_FIELD		4
+#define GGA_QUALITY_FIELD		6
+#define GGA_SATELLITES_FIELD	7
+#define GGA_HDOP_FIELD			8
+#define GGA_ALTITUDE_FIELD		9
+#define GGA_FIELD_COUNT			10
+
+#define GLL_LATITUDE_FIELD		1
+#define GLL_LONGITUDE_FIELD		3
+#define GLL_TIME_FIELD			5
+#define GLL_VALID_FIELD			6
+#define GLL_FIELD_COUNT			7
+
+#define GSA_MODE_FIELD			2
+#define GSA_PRN_FIRST_FIELD		3
+#define GSA_PRN_LAST_FIELD		14
+#define GSA_PDOP_FIELD			15
+#define GSA_HDOP_FIELD			16
+#define GSA_VDOP_FIELD			17
+#define GSA_FIELD_COUNT			18
+
+#define GSV_IN_VIEW_FIELD		3
+#define GSV_FIELD_COUNT			4
+
+#define VTG_COURSE_FIELD		1
+#define VTG_SPEED_FIELD			5
+#define VTG_FIELD_COUNT			6
+
+#define ZDA_TIME_FIELD			1
+#define ZDA_DAY_FIELD			2
+#define ZDA_MONTH_FIELD			3
+#define ZDA_YEAR_FIELD			4
+#define ZDA_FIELD_COUNT			5
+
+uint8_t nmea_message_type(const nmea_sentence_t *s) {
+	const uint8_t *type;
+
+	// Talker ID (2 chars) + message type (3 chars)
+	if (s->field_count == 0 || s->fields[0].len != 5)
+		return GPS_MESSAGE_UNKNOWN;
+
+	type = s->buf + 2;
+
+	switch (type[0]) {
+	case 'G':
+		if (type[1] == 'G' && type[2] == 'A')
+			return GPS_MESSAGE_GPGGA;
+		if (type[1] == 'L' && type[2] == 'L')
+			return GPS_MESSAGE_GPGLL;
+		if (type[1] == 'S' && type[2] == 'A')
+			return GPS_MESSAGE_GPGSA;
+		if (type[1] == 'S' && type[2] == 'V')
+			return GPS_MESSAGE_GPGSV;
+		break;
+	case 'R':
+		if (type[1] == 'M' && type[2] == 'C')
+			return GPS_MESSAGE_GPRMC;
+		break;
+	case 'V':
+		if (type[1] == 'T' && type[2] == 'G')
+			return GPS_MESSAGE_GPVTG;
+		break;
+	case 'Z':
+		if (type[1] == 'D' && type[2] == 'A')
+			return GPS_MESSAGE_GPZDA;
+		break;
+	}
+
+	return GPS_MESSAGE_UNKNOWN;
+}
+
+/*
+ * Seconds of the day the sentence belongs to, -1 for sentences without
+ * a time field (GSA, GSV, VTG) or with an empty one.
+ */
+int32_t nmea_sentence_epoch(const nmea_sentence_t *s, uint8_t type) {
+	uint8_t field, hour, minute, second;
+
+	switch (type) {
+	case GPS_MESSAGE_GPRMC:
+		field = RMC_TIME_FIELD;
+		break;
+	case GPS_MESSAGE_GPGGA:
+		field = GGA_TIME_FIELD;
+		break;
+	case GPS_MESSAGE_GPGLL:
+		field = GLL_TIME_FIELD;
+		break;
+	case GPS_MESSAGE_GPZDA:
+		field = ZDA_TIME_FIELD;
+		break;
+	default:
+		return -1;
+	}
+
+	if (nmea_field_time(s, field, &hour, &minute, &second) != NMEA_SENTENCE)
+		return -1;
+
+	return (int32_t)hour * 3600 + minute * 60 + second;
+}
+
+uint8_t nmea_parse(const nmea_sentence_t *s, uint8_t type, gps_fix_t *fix) {
+	switch (type) {
+	case GPS_MESSAGE_GPRMC:
+		return nmea_parse_rmc(s, fix);
+	case GPS_MESSAGE_GPGGA:
+		return nmea_parse_gga(s, fix);
+	case GPS_MESSAGE_GPGLL:
+		return nmea_parse_gll(s, fix);
+	case GPS_MESSAGE_GPGSA:
+		return nmea_parse_gsa(s, fix);
+	case GPS_MESSAGE_GPGSV:
+		return nmea_parse_gsv(s, fix);
+	case GPS_MESSAGE_GPVTG:
+		return nmea_parse_vtg(s, fix);
+	case GPS_MESSAGE_GPZDA:
+		return nmea_parse_zda(s, fix);
+	}
+
+	return NMEA_ERR_FORMAT;
+}
+
+void nmea_merge_init(nmea_merge_t *m, uint8_t complete) {
+	memset(m, 0, sizeof(*m));
+	m->complete = complete;
+}
+
+/*
+ * Starts the epoch from scratch, nothing of the previous second may leak
+ * into it. The position is invalid until a sentence with one comes in.
+ */
+static void merge_open(nmea_merge_t *m, uint32_t epoch, uint64_t timestamp_us) {
+	memset(&m->work, 0, sizeof(m->work));
+
+	m->work.nav.flags = GPS_DATA_INVALID;
+	m->work.epoch = epoch;
+	m->work.timestamp_us = timestamp_us;
+}
+
+static void merge_close(nmea_merge_t *m, gps_fix_t *fix) {
+	*fix = m->work;
+
+	m->done = 1;
+	m->done_epoch = m->work.epoch;
+	m->work.sentences = 0;
+}
+
+/*
+ * Merges the sentence into the epoch it belongs to. timestamp_us is taken
+ * by the epoch the sentence opens. Returns NMEA_MERGE_FLAGS, with
+ * NMEA_MERGE_FIX the complete epoch is in fix. At most one epoch is
+ * completed per sentence, one that completes on the sentence that closed
+ * the previous epoch goes out with the next second.
+ */
+uint8_t nmea_merge(nmea_merge_t *m, const nmea_sentence_t *s, uint8_t type, uint64_t timestamp_us, gps_fix_t *fix) {
+	int32_t epoch = nmea_sentence_epoch(s, type);
+	uint8_t res = 0;
+
+	if (m->work.sentences != 0 && epoch >= 0 && (uint32_t)epoch != m->work.epoch) {
+		merge_close(m, fix);
+		res |= NMEA_MERGE_FIX;
+	}
+
+	if (m->work.sentences == 0) {
+		if (epoch < 0 || (m->done && (uint32_t)epoch == m->done_epoch))
+			return res | NMEA_MERGE_DROPPED;
+
+		merge_open(m, epoch, timestamp_us);
+	}
+
+	if (nmea_parse(s, type, &m->work) != NMEA_SENTENCE)
+		return res | NMEA_MERGE_ERR_PARSE;
+
+	m->work.sentences |= GPS_FIX_SENTENCE(type);
+
+	if (!(res & NMEA_MERGE_FIX) && (m->work.sentences & m->complete) == m->complete) {
+		merge_close(m, fix);
+		res |= NMEA_MERGE_FIX;
+	}
+
+	return res;
+}
+
+/*
+ * Latitude field followed by N/S, longitude field followed by E/W.
+ * Position is zeroed and marked invalid when the fields are empty.
+ */
+static void parse_position(const nmea_sentence_t *s, uint8_t lat_field, uint8_t lon_field, gps_rmc_state_t *nav) {
+	nav->flags &= ~(LATITUDE_N | LATITUDE_S | LONGITUDE_E | LONGITUDE_W);
+
+	if (nmea_field_coord(s, lat_field, &nav->latitude_degrees, &nav->latitude_seconds) != NMEA_SENTENCE ||
+			nmea_field_coord(s, lon_field, &nav->longitude_degrees, &nav->longitude_seconds) != NMEA_SENTENCE) {
+		nav->latitude_degrees = nav->longitude_degrees = 0;
+		nav->latitude_seconds = nav->longitude_seconds = 0;
+		nav->flags |= GPS_DATA_INVALID;
+		return;
+	}
+
+	if (nmea_field_char(s, lat_field + 1) == 'N') {
+		nav->flags |= LATITUDE_N;
+	} else if (nmea_field_char(s, lat_field + 1) == 'S') {
+		nav->flags |= LATITUDE_S;
+	}
+
+	if (nmea_field_char(s, lon_field + 1) == 'E') {
+		nav->flags |= LONGITUDE_E;
+	} else if (nmea_field_char(s, lon_field + 1) == 'W') {
+		nav->flags |= LONGITUDE_W;
+	}
+}
+
+uint8_t nmea_parse_rmc(const nmea_sentence_t *s, gps_fix_t *fix) {
+	gps_rmc_state_t *nav = &fix->nav;
+
+	if (s->field_count < RMC_FIELD_COUNT)
+		return NMEA_ERR_FORMAT;
+
+	if (nmea_field_time(s, RMC_TIME_FIELD, &nav->hour, &nav->minute, &nav->second) != NMEA_SENTENCE)
+		return NMEA_ERR_FORMAT;
+
+	if (nmea_field_char(s, RMC_VALID_FIELD) == 'A') {
+		nav->flags &= ~GPS_DATA_INVALID;
+	} else {
+		nav->flags |= GPS_DATA_INVALID;
+	}
+
+	parse_position(s, RMC_LATITUDE_FIELD, RMC_LONGITUDE_FIELD, nav);
+
+	// Knots and degrees, both in 1/100 units
+	nav->speed = nmea_field_fixed(s, RMC_SPEED_FIELD, 2);
+	nav->course = nmea_field_fixed(s, RMC_COURSE_FIELD, 2);
+
+	if (nmea_field_date(s, RMC_DATE_FIELD, &nav->day, &nav->month, &nav->year) != NMEA_SENTENCE)
+		nav->day = nav->month = nav->year = 0;
+
+	return NMEA_SENTENCE;
+}
+
+uint8_t nmea_parse_gga(const nmea_sentence_t *s, gps_fix_t *fix) {
+	gps_rmc_state_t *nav = &fix->nav;
+
+	if (s->field_count < GGA_FIELD_COUNT)
+		return NMEA_ERR_FORMAT;
+
+	if (nmea_field_time(s, GGA_TIME_FIELD, &nav->hour, &nav->minute, &nav->second) != NMEA_SENTENCE)
+		return NMEA_ERR_FORMAT;
+
+	fix->quality = nmea_field_uint(s, GGA_QUALITY_FIELD);
+	fix->satellites_used = nmea_field_uint(s, GGA_SATELLITES_FIELD);
+	fix->hdop = nmea_field_fixed(s, GGA_HDOP_FIELD, 2);
+	fix->altitude = nmea_field_sfixed(s, GGA_ALTITUDE_FIELD, 1);
+
+	// RMC of the same epoch carries the validity, GGA alone relies on quality
+	if (!(fix->sentences & GPS_FIX_SENTENCE(GPS_MESSAGE_GPRMC))) {
+		parse_position(s, GGA_LATITUDE_FIELD, GGA_LONGITUDE_FIELD, nav);
+
+		if (fix->quality == 0) {
+			nav->flags |= GPS_DATA_INVALID;
+		} else {
+			nav->flags &= ~GPS_DATA_INVALID;
+		}
+	}
+
+	return NMEA_SENTENCE;
+}
+
+uint8_t nmea_parse_gll(const nmea_sentence_t *s, gps_fix_t *fix) {
+	gps_rmc_state_t *nav = &fix->nav;
+
+	if (s->field_count < GLL_FIELD_COUNT)
+		return NMEA_ERR_FORMAT;
+
+	if (nmea_field_time(s, GLL_TIME_FIELD, &nav->hour, &nav->minute, &nav->second) != NMEA_SENTENCE)
+		return NMEA_ERR_FORMAT;
+
+	if (fix->sentences & (GPS_FIX_SENTENCE(GPS_MESSAGE_GPRMC) | GPS_FIX_SENTENCE(GPS_MESSAGE_GPGGA)))
+		return NMEA_SENTENCE;
+
+	if (nmea_field_char(s, GLL_VALID_FIELD) == 'A') {
+		nav->flags &= ~GPS_DATA_INVALID;
+	} else {
+		nav->flags |= GPS_DATA_INVALID;
+	}
+
+	parse_position(s, GLL_LATITUDE_FIELD, GLL_LONGITUDE_FIELD, nav);
+
+	return NMEA_SENTENCE;
+}
+
+uint8_t nmea_parse_gsa(const nmea_sentence_t *s, gps_fix_t *fix) {
+	uint8_t i, used = 0;
+
+	if (s->field_count < GSA_FIELD_COUNT)
+		return NMEA_ERR_FORMAT;
+
+	fix->mode = nmea_field_uint(s, GSA_MODE_FIELD);
+
+	for (i = GSA_PRN_FIRST_FIELD; i <= GSA_PRN_LAST_FIELD; i++) {
+		if (!nmea_field_empty(s, i))
+			used++;
+	}
+
+	// GGA count is not limited to 12 channels
+	if (!(fix->sentences & GPS_FIX_SENTENCE(GPS_MESSAGE_GPGGA)))
+		fix->satellites_used = used;
+
+	fix->pdop = nmea_field_fixed(s, GSA_PDOP_FIELD, 2);
+	fix->hdop = nmea_field_fixed(s, GSA_HDOP_FIELD, 2);
+	fix->vdop = nmea_field_fixed(s, GSA_VDOP_FIELD, 2);
+
+	return NMEA_SENTENCE;
+}
+
+uint8_t nmea_parse_gsv(const nmea_sentence_t *s, gps_fix_t *fix) {
+	if (s->field_count < GSV_FIELD_COUNT)
+		return NMEA_ERR_FORMAT;
+
+	// Every part of a GSV group repeats the total count
+	fix->satellites_in_view = nmea_field_uint(s, GSV_IN_VIEW_FIELD);
+
+	return NMEA_SENTENCE;
+}
+
+uint8_t nmea_parse_vtg(const nmea_sentence_t *s, gps_fix_t *fix) {
+	if (s->field_count < VTG_FIELD_COUNT)
+		return NMEA_ERR_FORMAT;
+
+	if (fix->sentences & GPS_FIX_SENTENCE(GPS_MESSAGE_GPRMC))
+		return NMEA_SENTENCE;
+
+	fix->nav.course = nmea_field_fixed(s, VTG_COURSE_FIELD, 2);
+	fix->nav.speed = nmea_field_fixed(s, VTG_SPEED_FIELD, 2);
+
+	return NMEA_SENTENCE;
+}
+
+uint8_t nmea_parse_zda(const nmea_sentence_t *s, gps_fix_t *fix) {
+	gps_rmc_state_t *nav = &fix->nav;
+
+	if (s->field_count < ZDA_FIELD_COUNT)
+		return NMEA_ERR_FORMAT;
+
+	if (nmea_field_time(s, ZDA_TIME_FIELD, &nav->hour, &nav->minute, &nav->second) != NMEA_SENTENCE)
+		return NMEA_ERR_FORMAT;
+
+	nav->day = nmea_field_uint(s, ZDA_DAY_FIELD);
+	nav->month = nmea_field_uint(s, ZDA_MONTH_FIELD);
+	nav->year = nmea_field_uint(s, ZDA_YEAR_FIELD) % 100;
+
+	return NMEA_SENTENCE;
+}
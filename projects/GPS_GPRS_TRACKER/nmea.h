@@ -0,0 +1,145 @@
+/*
+ * nmea.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef NMEA_H_
+#define NMEA_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "gps_fix.h"
+
+typedef enum NMEA_RESULT {
+	NMEA_PENDING			=	0x00,
+	NMEA_SENTENCE			=	0x01,
+	NMEA_ERR_CHKSUM			=	0x02,
+	NMEA_ERR_OVERFLOW		=	0x03,
+	NMEA_ERR_FORMAT			=	0x04
+} NMEA_RESULT;
+
+typedef enum NMEA_PARSER_STATE {
+	NMEA_STATE_IDLE			=	0x00,
+	NMEA_STATE_BODY			=	0x01,
+	NMEA_STATE_CHKSUM_HI	=	0x02,
+	NMEA_STATE_CHKSUM_LO	=	0x03
+} NMEA_PARSER_STATE;
+
+#define NMEA_MAX_FIELDS		24
+
+// '$', '*', two checksum digits and CR LF around the body
+#define NMEA_FRAME_OVERHEAD	6
+
+/*
+ * Incremental NMEA tokenizer.
+ * Bytes are pushed one at a time, the sentence body (talker + type + fields,
+ * without '$' and '*XX') is collected into buf and the XOR checksum is
+ * computed on the fly, so a sentence is validated as soon as its last
+ * checksum digit arrives.
+ */
+typedef struct nmea_parser {
+	uint8_t *buf;
+	size_t size;
+	size_t len;
+
+	uint8_t state;
+	uint8_t chksum;
+	uint8_t rx_chksum;
+} nmea_parser_t;
+
+typedef struct nmea_field {
+	uint8_t offset;
+	uint8_t len;
+} nmea_field_t;
+
+/*
+ * Field index of a received sentence.
+ * Built in one pass over the sentence body, fields point into the original
+ * buffer and are never copied. Field 0 is the talker + message type.
+ */
+typedef struct nmea_sentence {
+	const uint8_t *buf;
+	uint8_t field_count;
+	nmea_field_t fields[NMEA_MAX_FIELDS];
+} nmea_sentence_t;
+
+typedef enum NMEA_MERGE_FLAGS {
+	// An epoch is complete and was copied out
+	NMEA_MERGE_FIX			=	1 << 0,
+	// Sentence without a time of its own and no open epoch to attach to
+	NMEA_MERGE_DROPPED		=	1 << 1,
+	// Sentence did not parse and is left out of its epoch
+	NMEA_MERGE_ERR_PARSE	=	1 << 2
+} NMEA_MERGE_FLAGS;
+
+/*
+ * Merges the sentences of one receiver epoch (one UTC second) into a fix.
+ * Only a sentence with the time of a new second opens an epoch, it is
+ * complete once all sentences of the complete mask are in or a sentence
+ * of another second shows up. Sentences without a time field (GSA, GSV,
+ * VTG) belong to the epoch they follow and are dropped once it is out.
+ */
+typedef struct nmea_merge {
+	gps_fix_t work;
+
+	// GPS_FIX_SENTENCE() mask of the sentences that complete an epoch
+	uint8_t complete;
+
+	// Last epoch copied out, its late sentences must not open a new one
+	uint8_t done;
+	uint32_t done_epoch;
+} nmea_merge_t;
+
+extern void nmea_init(nmea_parser_t *p, uint8_t *buf, size_t size);
+
+extern void nmea_reset(nmea_parser_t *p);
+
+extern uint8_t nmea_put(nmea_parser_t *p, uint8_t c);
+
+extern size_t nmea_frame(const uint8_t *body, size_t len, uint8_t *out);
+
+extern uint8_t nmea_index(nmea_sentence_t *s, const uint8_t *buf, size_t len);
+
+extern uint8_t nmea_field_empty(const nmea_sentence_t *s, uint8_t n);
+
+extern uint8_t nmea_field_char(const nmea_sentence_t *s, uint8_t n);
+
+extern uint32_t nmea_field_uint(const nmea_sentence_t *s, uint8_t n);
+
+extern uint32_t nmea_field_fixed(const nmea_sentence_t *s, uint8_t n, uint8_t frac_digits);
+
+extern int32_t nmea_field_sfixed(const nmea_sentence_t *s, uint8_t n, uint8_t frac_digits);
+
+extern uint8_t nmea_field_coord(const nmea_sentence_t *s, uint8_t n, uint8_t *degrees, uint32_t *minutes);
+
+extern uint8_t nmea_field_time(const nmea_sentence_t *s, uint8_t n, uint8_t *hour, uint8_t *minute, uint8_t *second);
+
+extern uint8_t nmea_field_date(const nmea_sentence_t *s, uint8_t n, uint8_t *day, uint8_t *month, uint8_t *year);
+
+extern uint8_t nmea_message_type(const nmea_sentence_t *s);
+
+extern int32_t nmea_sentence_epoch(const nmea_sentence_t *s, uint8_t type);
+
+extern uint8_t nmea_parse(const nmea_sentence_t *s, uint8_t type, gps_fix_t *fix);
+
+extern void nmea_merge_init(nmea_merge_t *m, uint8_t complete);
+
+extern uint8_t nmea_merge(nmea_merge_t *m, const nmea_sentence_t *s, uint8_t type, uint64_t timestamp_us, gps_fix_t *fix);
+
+extern uint8_t nmea_parse_rmc(const nmea_sentence_t *s, gps_fix_t *fix);
+
+extern uint8_t nmea_parse_gga(const nmea_sentence_t *s, gps_fix_t *fix);
+
+extern uint8_t nmea_parse_gll(const nmea_sentence_t *s, gps_fix_t *fix);
+
+extern uint8_t nmea_parse_gsa(const nmea_sentence_t *s, gps_fix_t *fix);
+
+extern uint8_t nmea_parse_gsv(const nmea_sentence_t *s, gps_fix_t *fix);
+
+extern uint8_t nmea_parse_vtg(const nmea_sentence_t *s, gps_fix_t *fix);
+
+extern uint8_t nmea_parse_zda(const nmea_sentence_t *s, gps_fix_t *fix);
+
+#endif /* NMEA_H_ */
@@ -3,45 +3,69 @@
  *
  *  Created on: 23.01.2012
  *      Author: dimaz
+ *
+ * Supply monitor. TIM6 triggers a conversion of both sense lines
+ * POWER_SAMPLE_HZ times a second and the DMA fills a ring of two blocks,
+ * so the CPU only sees the half and full buffer interrupts. Each block
+ * goes through powermon and power_event is broadcast when external power
+ * comes or goes, the battery runs low or charging starts or stops.
  */
 
 #include "power.h"
 
 #include "util.h"
+#if !defined(SIMULATOR)
+#include "lowpower.h"
+#endif
+
+#define POWER_NUM_CHANNELS		2
+
+// Sample order within a sequence, the DMA interleaves the channels
+#define POWER_CH_BAT			0
+#define POWER_CH_EXT			1
+
+// TIM6 counter clock, the trigger period is counted in it
+#define POWER_TIM_HZ			2000
+
+#if POWER_TIM_HZ / POWER_SAMPLE_HZ < 2
+#error "POWER_SAMPLE_HZ too high for POWER_TIM_HZ"
+#endif
 
-/* Total number of channels to be sampled by a single ADC operation.*/
-#define ADC_GRP1_NUM_CHANNELS   2
+EVENTSOURCE_DECL(power_event);
 
-/* Depth of the conversion buffer, channels are sampled four times each.*/
-#define ADC_GRP1_BUF_DEPTH      4
+static powermon_t power_monitor;
+static uint32_t power_blocks;
 
+#if !defined(SIMULATOR)
 /*
- * ADC samples buffer.
+ * ADC samples ring, two blocks.
  */
-static adcsample_t samples[ADC_GRP1_NUM_CHANNELS * ADC_GRP1_BUF_DEPTH];
+static adcsample_t samples[POWER_NUM_CHANNELS * POWER_BLOCK_SAMPLES * 2];
 
-static adcsample_t ext_pwr_level, batt_level;
+static VirtualTimer power_timer;
 
-static void adccb(ADCDriver *adcp, adcsample_t *buffer, size_t n);
+// STOP held off until the next block is in
+static uint8_t power_hold = FALSE;
+
+static void power_adc_cb(ADCDriver *adcp, adcsample_t *buffer, size_t n);
 
 /*
  * ADC conversion group.
- * Mode:        Linear buffer, 4 samples of 2 channels, SW triggered.
- * Channels:    IN10   (48 cycles sample time)
- *              Sensor (192 cycles sample time)
+ * Mode:        Circular buffer, two blocks of 2 channels, TIM6 TRGO triggered.
+ * Channels:    IN5 battery, IN4 external supply (192 cycles sample time)
  */
 static const ADCConversionGroup adcgrpcfg = {
-  FALSE,
-  ADC_GRP1_NUM_CHANNELS,
-  adccb,
+  TRUE,
+  POWER_NUM_CHANNELS,
+  power_adc_cb,
   NULL,
   /* HW dependent part.*/
-  0,                        /* CR1 */
-  ADC_CR2_SWSTART,          /* CR2 */
+  0,                                                /* CR1 */
+  ADC_CR2_EXTEN_0 | ADC_CR2_EXTSEL_SRC(10),         /* CR2, TIM6 TRGO rising */
   0,
-  ADC_SMPR2_SMP_AN10(ADC_SAMPLE_192) | ADC_SMPR2_SMP_SENSOR(ADC_SAMPLE_192),
   0,
-  ADC_SQR1_NUM_CH(ADC_GRP1_NUM_CHANNELS),
+  ADC_SMPR3_SMP_AN4(ADC_SAMPLE_192) | ADC_SMPR3_SMP_AN5(ADC_SAMPLE_192),
+  ADC_SQR1_NUM_CH(POWER_NUM_CHANNELS),
   0,
   0,
   0,
@@ -49,51 +73,104 @@ static const ADCConversionGroup adcgrpcfg = {
 };
 
 /*
- * ADC end conversion callback.
- * The PWM channels are reprogrammed using the latest ADC samples.
- * The latest samples are transmitted into a single SPI transaction.
+ * ADC half and full buffer callback, n sequences of the block that is
+ * complete. The charger pin is read with it, STAT is low while charging.
  */
-void adccb(ADCDriver *adcp, adcsample_t *buffer, size_t n) {
+static void power_adc_cb(ADCDriver *adcp, adcsample_t *buffer, size_t n) {
+	uint16_t ext, bat;
+	uint8_t changed;
 
-  (void) buffer; (void) n;
-  /* Note, only in the ADC_COMPLETE state because the ADC driver fires an
-     intermediate callback when the buffer is half full.*/
-  if (adcp->state == ADC_COMPLETE) {
+	(void)adcp;
 
-    /* Calculates the average values from the ADC samples.*/
-	ext_pwr_level = (samples[0] + samples[2] + samples[4] + samples[6]) / 4;
-    batt_level = (samples[1] + samples[3] + samples[5] + samples[7]) / 4;
+	ext = powermon_median(buffer + POWER_CH_EXT, POWER_NUM_CHANNELS, n);
+	bat = powermon_median(buffer + POWER_CH_BAT, POWER_NUM_CHANNELS, n);
 
-    //chSysLockFromIsr();
+	chSysLockFromIsr();
 
-    //chSysUnlockFromIsr();
-  }
-}
+	changed = powermon_update(&power_monitor, ext, bat, palReadPad(GPIO_CHG_PORT, GPIO_CHG_PIN) == PAL_LOW);
+	power_blocks++;
+
+	if (power_hold) {
+		power_hold = FALSE;
+		lowpower_allow_i();
+	}
 
-void update_power_state() {
-	ext_pwr_level = batt_level = 0;
-	adcStartConversion(&ADCD1, &adcgrpcfg, samples, ADC_GRP1_BUF_DEPTH);
+	if (changed)
+		chEvtBroadcastI(&power_event);
+
+	chSysUnlockFromIsr();
 }
 
-void print_power_state() {
-	char num_buf[10];
-	uint8_t num_len;
+/*
+ * Timer callback, runs locked. The trigger timer stands still in STOP
+ * mode, so it is held off now and then until a block is in.
+ */
+static void power_stop_sample(void *arg) {
+	(void)arg;
 
-	sdWrite(&SD1, "POWER LEVEL: ", sizeof("POWER LEVEL: ") - 1);
-	stoa(ext_pwr_level, num_buf, &num_len);
-	sdWrite(&SD1, num_buf, num_len - 1);
-	sdWrite(&SD1, " ", sizeof(" ") - 1);
-	stoa(batt_level, num_buf, &num_len);
-	sdWrite(&SD1, num_buf, num_len - 1);
-	sdWrite(&SD1, "\r\n", sizeof("\r\n") - 1);
+	if (!power_hold) {
+		power_hold = TRUE;
+		lowpower_inhibit_i();
+	}
+
+	chVTSetI(&power_timer, S2ST(POWER_STOP_SAMPLE_S), power_stop_sample, NULL);
 }
 
+/*
+ * TIM6 update events on TRGO, the ADC starts a sequence on each.
+ */
+static void power_trigger_start(void) {
+	rccEnableAPB1(RCC_APB1ENR_TIM6EN, FALSE);
+
+	TIM6->CR1 = 0;
+	TIM6->PSC = STM32_TIMCLK1 / POWER_TIM_HZ - 1;
+	TIM6->ARR = POWER_TIM_HZ / POWER_SAMPLE_HZ - 1;
+	TIM6->CR2 = TIM_CR2_MMS_1;
+	TIM6->EGR = TIM_EGR_UG;
+	TIM6->CR1 = TIM_CR1_CEN;
+}
+#endif
+
 void init_power_ctl() {
+	powermon_init(&power_monitor);
 
+#if !defined(SIMULATOR)
 	palSetPadMode(GPIO_12V_SENSE_PORT, GPIO_12V_SENSE_PIN, PAL_MODE_INPUT_ANALOG);
 	palSetPadMode(GPIO_VBAT_SENSE_PORT, GPIO_VBAT_SENSE_PIN, PAL_MODE_INPUT_ANALOG);
+	palSetPadMode(GPIO_CHG_PORT, GPIO_CHG_PIN, PAL_MODE_INPUT_PULLUP);
 
 	adcStart(&ADCD1, NULL);
-	adcSTM32EnableTSVREFE();
+	adcStartConversion(&ADCD1, &adcgrpcfg, samples, POWER_BLOCK_SAMPLES * 2);
+
+	power_trigger_start();
+
+	chSysLock();
+	chVTSetI(&power_timer, S2ST(POWER_STOP_SAMPLE_S), power_stop_sample, NULL);
+	chSysUnlock();
+#endif
+}
+
+void power_get_state(power_state_t *state) {
+	chSysLock();
+	state->ext_mv = power_monitor.ext_mv;
+	state->bat_mv = power_monitor.bat_mv;
+	state->flags = power_monitor.flags;
+	state->blocks = power_blocks;
+	chSysUnlock();
+}
 
+void print_power_state() {
+	power_state_t state;
+	char num_buf[10];
+	uint8_t num_len;
+
+	power_get_state(&state);
+
+	sdWrite(&SD1, "POWER MV: ", sizeof("POWER MV: ") - 1);
+	stoa(state.ext_mv, num_buf, &num_len);
+	sdWrite(&SD1, num_buf, num_len - 1);
+	sdWrite(&SD1, " ", sizeof(" ") - 1);
+	stoa(state.bat_mv, num_buf, &num_len);
+	sdWrite(&SD1, num_buf, num_len - 1);
+	sdWrite(&SD1, "\r\n", sizeof("\r\n") - 1);
 }
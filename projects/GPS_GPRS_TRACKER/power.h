@@ -11,9 +11,46 @@
 #include "ch.h"
 #include "hal.h"
 
+#include "powermon.h"
+
+// ADC trigger rate, each trigger converts both sense lines, Hz
+#if !defined(POWER_SAMPLE_HZ)
+#define POWER_SAMPLE_HZ			32
+#endif
+
+// Samples of each line per filter block, one half of the DMA ring
+#if !defined(POWER_BLOCK_SAMPLES)
+#define POWER_BLOCK_SAMPLES		4
+#endif
+
+// The ADC stops with the clock in STOP mode, at least one block this often, seconds
+#if !defined(POWER_STOP_SAMPLE_S)
+#define POWER_STOP_SAMPLE_S		10
+#endif
+
+#if POWER_BLOCK_SAMPLES > POWERMON_MEDIAN_MAX
+#error "POWER_BLOCK_SAMPLES exceeds POWERMON_MEDIAN_MAX"
+#endif
+
+/*
+ * Supply state, flags are POWERMON_EXT, POWERMON_BAT_LOW and
+ * POWERMON_CHARGING.
+ */
+typedef struct power_state {
+	uint16_t ext_mv;
+	uint16_t bat_mv;
+	uint8_t flags;
+
+	// Filter blocks since power on
+	uint32_t blocks;
+} power_state_t;
+
+// Broadcast when a flag of the supply state changes
+extern EventSource power_event;
+
 extern void init_power_ctl();
 
-extern void update_power_state();
+extern void power_get_state(power_state_t *state);
 
 extern void print_power_state();
 
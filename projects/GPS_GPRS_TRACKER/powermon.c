@@ -0,0 +1,89 @@
+/*
+ * powermon.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Supply readings to state: external power present, battery low and
+ * charging, with hysteresis so a level near a threshold does not toggle.
+ */
+
+#include "powermon.h"
+
+#include <string.h>
+
+void powermon_init(powermon_t *pm) {
+	memset(pm, 0, sizeof(*pm));
+}
+
+/*
+ * Median of n samples taken every stride, n up to POWERMON_MEDIAN_MAX.
+ * The mean of the middle two for an even n.
+ */
+uint16_t powermon_median(const uint16_t *samples, size_t stride, size_t n) {
+	uint16_t sorted[POWERMON_MEDIAN_MAX], v;
+	size_t i, j;
+
+	if (n == 0)
+		return 0;
+
+	if (n > POWERMON_MEDIAN_MAX)
+		n = POWERMON_MEDIAN_MAX;
+
+	for (i = 0; i < n; i++) {
+		v = samples[i * stride];
+
+		for (j = i; j > 0 && sorted[j - 1] > v; j--)
+			sorted[j] = sorted[j - 1];
+
+		sorted[j] = v;
+	}
+
+	return n & 1 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+}
+
+static void powermon_filter(int32_t *q4, uint16_t raw, uint8_t primed) {
+	if (!primed)
+		*q4 = (int32_t)raw << 4;
+	else
+		*q4 += (((int32_t)raw << 4) - *q4) >> POWERMON_IIR_SHIFT;
+}
+
+static uint16_t powermon_mv(int32_t q4, uint8_t divider) {
+	return (uint32_t)q4 * POWERMON_VDDA_MV * divider / ((uint32_t)POWERMON_ADC_MAX << 4);
+}
+
+/*
+ * Adds one block median of each line and the charger state. Returns the
+ * flags that changed, 0 mostly. The first block sets the levels as they
+ * are and reports every flag that is set.
+ */
+uint8_t powermon_update(powermon_t *pm, uint16_t ext_raw, uint16_t bat_raw, uint8_t charging) {
+	uint8_t flags = pm->flags, changed;
+
+	powermon_filter(&pm->ext_q4, ext_raw, pm->primed);
+	powermon_filter(&pm->bat_q4, bat_raw, pm->primed);
+	pm->primed = 1;
+
+	pm->ext_mv = powermon_mv(pm->ext_q4, POWERMON_EXT_DIVIDER);
+	pm->bat_mv = powermon_mv(pm->bat_q4, POWERMON_BAT_DIVIDER);
+
+	if (pm->ext_mv >= POWERMON_EXT_ON_MV)
+		flags |= POWERMON_EXT;
+	else if (pm->ext_mv < POWERMON_EXT_OFF_MV)
+		flags &= ~POWERMON_EXT;
+
+	if (pm->bat_mv < POWERMON_BAT_LOW_MV)
+		flags |= POWERMON_BAT_LOW;
+	else if (pm->bat_mv >= POWERMON_BAT_OK_MV)
+		flags &= ~POWERMON_BAT_LOW;
+
+	if (charging)
+		flags |= POWERMON_CHARGING;
+	else
+		flags &= ~POWERMON_CHARGING;
+
+	changed = flags ^ pm->flags;
+	pm->flags = flags;
+
+	return changed;
+}
@@ -0,0 +1,87 @@
+/*
+ * powermon.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef POWERMON_H_
+#define POWERMON_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ADC reference, the supply of the part, mV
+#if !defined(POWERMON_VDDA_MV)
+#define POWERMON_VDDA_MV		3300
+#endif
+
+#define POWERMON_ADC_MAX		4095
+
+// Input dividers of the sense lines on the board, input over ADC pin
+#if !defined(POWERMON_EXT_DIVIDER)
+#define POWERMON_EXT_DIVIDER	11
+#endif
+
+#if !defined(POWERMON_BAT_DIVIDER)
+#define POWERMON_BAT_DIVIDER	2
+#endif
+
+#if POWERMON_ADC_MAX * 16 * POWERMON_VDDA_MV * POWERMON_EXT_DIVIDER > 0xFFFFFFFF || \
+		POWERMON_ADC_MAX * 16 * POWERMON_VDDA_MV * POWERMON_BAT_DIVIDER > 0xFFFFFFFF
+#error "Supply conversion does not fit 32 bits"
+#endif
+
+// External supply present above the first, lost below the second, mV
+#if !defined(POWERMON_EXT_ON_MV)
+#define POWERMON_EXT_ON_MV		9000
+#endif
+
+#if !defined(POWERMON_EXT_OFF_MV)
+#define POWERMON_EXT_OFF_MV		8000
+#endif
+
+// Battery low below the first, good again above the second, mV
+#if !defined(POWERMON_BAT_LOW_MV)
+#define POWERMON_BAT_LOW_MV		3500
+#endif
+
+#if !defined(POWERMON_BAT_OK_MV)
+#define POWERMON_BAT_OK_MV		3650
+#endif
+
+// IIR weight of a new block median, 1 / 2^shift
+#if !defined(POWERMON_IIR_SHIFT)
+#define POWERMON_IIR_SHIFT		2
+#endif
+
+// Most samples powermon_median() takes
+#define POWERMON_MEDIAN_MAX		16
+
+// State flags
+#define POWERMON_EXT			0x01
+#define POWERMON_BAT_LOW		0x02
+#define POWERMON_CHARGING		0x04
+
+/*
+ * Filtered supply state. Each block of samples is reduced to its median,
+ * which drops single spikes such as the modem transmit bursts, and the
+ * medians go through a first order IIR filter kept with 4 fraction bits.
+ */
+typedef struct powermon {
+	int32_t ext_q4;
+	int32_t bat_q4;
+	uint8_t primed;
+
+	uint16_t ext_mv;
+	uint16_t bat_mv;
+
+	uint8_t flags;
+} powermon_t;
+
+extern void powermon_init(powermon_t *pm);
+
+extern uint16_t powermon_median(const uint16_t *samples, size_t stride, size_t n);
+
+extern uint8_t powermon_update(powermon_t *pm, uint16_t ext_raw, uint16_t bat_raw, uint8_t charging);
+
+#endif /* POWERMON_H_ */
@@ -0,0 +1,218 @@
+/*
+ * pps.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * 1PPS edge of the receiver (GPIO_GPS_PULSE) timestamped with the system
+ * clock. The edge marks the start of the UTC second the following
+ * sentences describe, so a fix gets the system time it was valid at
+ * instead of the time its sentences happened to come through the UART.
+ * Synced edges also keep the RTC calendar on UTC for the time the
+ * receiver is off.
+ */
+
+#include "pps.h"
+#include "lowpower.h"
+
+// Weight of a new sample in the drift estimate, 1/n
+#define PPS_DRIFT_FILTER		8
+
+#define PPS_SECOND_US			1000000
+
+static pps_stats_t pps_stats;
+
+// System time of the last edge
+static uint64_t pps_last_us;
+
+// Edge synced to UTC and its second since 2000-01-01
+static uint64_t pps_utc_pulse_us;
+static uint32_t pps_utc_s;
+static uint8_t pps_utc_valid = FALSE;
+
+// Second the RTC calendar was last set to
+static uint32_t pps_rtc_s;
+static uint8_t pps_rtc_valid = FALSE;
+
+// Wraps of systime_t seen so far and the tick count they were counted at
+static uint32_t pps_ticks_high;
+static systime_t pps_ticks_last;
+
+static VirtualTimer pps_wrap_timer;
+
+/*
+ * Locked. chTimeNow() extended to 64 bits, a wrap is seen as long as this
+ * runs at least once per systime_t period (49.7 days at 1 kHz).
+ */
+static uint64_t pps_ticks_I(void) {
+	systime_t ticks = chTimeNow();
+
+	if (ticks < pps_ticks_last)
+		pps_ticks_high++;
+
+	pps_ticks_last = ticks;
+
+	return ((uint64_t)pps_ticks_high << 32) | ticks;
+}
+
+/*
+ * Timer callback, runs locked. Counts the wraps while there are no edges.
+ */
+static void pps_wrap_cb(void *arg) {
+	(void)arg;
+
+	pps_ticks_I();
+	chVTSetI(&pps_wrap_timer, S2ST(PPS_WRAP_CHECK_S), pps_wrap_cb, NULL);
+}
+
+void pps_init(void) {
+	chSysLock();
+	pps_wrap_cb(NULL);
+	chSysUnlock();
+}
+
+/*
+ * Microseconds since start, the extended tick counter plus the SysTick
+ * count within the current tick.
+ */
+static uint64_t pps_now_us_I(void) {
+	uint64_t ticks = pps_ticks_I();
+#if defined(SIMULATOR)
+	return ticks * PPS_SECOND_US / CH_FREQUENCY;
+#else
+	uint32_t val = SysTick->VAL;
+
+	// Counter wrapped but the tick interrupt has not run yet
+	if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+		ticks++;
+		val = SysTick->VAL;
+	}
+
+	return ticks * PPS_SECOND_US / CH_FREQUENCY +
+			(STM32_HCLK / CH_FREQUENCY - 1 - val) / (STM32_HCLK / PPS_SECOND_US);
+#endif
+}
+
+uint64_t pps_now_us(void) {
+	uint64_t now;
+
+	chSysLock();
+	now = pps_now_us_I();
+	chSysUnlock();
+
+	return now;
+}
+
+#if HAL_USE_EXT
+/*
+ * EXT callback of the GPS pulse line, rising edge.
+ */
+void pps_ext_cb(EXTDriver *extp, expchannel_t channel) {
+	uint64_t now, interval;
+	int32_t sample;
+
+	(void)extp;
+	(void)channel;
+
+	chSysLockFromIsr();
+
+	now = pps_now_us_I();
+	interval = now - pps_last_us;
+
+	if (pps_stats.pulses > 0 && interval > PPS_SECOND_US - PPS_MAX_JITTER_US &&
+			interval < PPS_SECOND_US + PPS_MAX_JITTER_US) {
+		pps_stats.interval_us = (uint32_t)interval;
+
+		sample = ((int32_t)interval - PPS_SECOND_US) * 1000;
+		pps_stats.drift_ppb += (sample - pps_stats.drift_ppb) / PPS_DRIFT_FILTER;
+	} else if (pps_stats.pulses > 0) {
+		pps_stats.gaps++;
+	}
+
+	pps_last_us = now;
+	pps_stats.pulses++;
+
+	chSysUnlockFromIsr();
+}
+#endif
+
+/*
+ * System time of the edge that started the epoch being received, 0 when
+ * there was none (no pulse line, receiver without a fix).
+ */
+uint64_t pps_epoch_time(void) {
+	uint64_t pulse, now;
+	uint32_t pulses;
+
+	chSysLock();
+	pulse = pps_last_us;
+	pulses = pps_stats.pulses;
+	now = pps_now_us_I();
+	chSysUnlock();
+
+	if (pulses == 0 || now - pulse >= (uint64_t)PPS_EPOCH_WINDOW_MS * 1000)
+		return 0;
+
+	return pulse;
+}
+
+/*
+ * Ties the edge at pulse_us to the UTC second of the fix it started and
+ * sets the RTC calendar to it every PPS_RTC_SYNC_S. The calendar has no
+ * subseconds, it runs late by the time from the edge to this call.
+ */
+void pps_set_utc(uint64_t pulse_us, uint32_t utc_s) {
+	uint8_t rtc_sync;
+
+	chSysLock();
+	pps_utc_pulse_us = pulse_us;
+	pps_utc_s = utc_s;
+	pps_utc_valid = TRUE;
+	pps_stats.synced++;
+
+	rtc_sync = !pps_rtc_valid || utc_s - pps_rtc_s >= PPS_RTC_SYNC_S;
+
+	if (rtc_sync) {
+		pps_rtc_s = utc_s;
+		pps_rtc_valid = TRUE;
+	}
+	chSysUnlock();
+
+	if (rtc_sync)
+		lowpower_rtc_set(utc_s);
+}
+
+/*
+ * Current UTC, seconds since 2000-01-01 and microseconds. The time since
+ * the last synced edge is corrected by the measured drift of the system
+ * clock. Returns FALSE when never synced or out of holdover.
+ */
+uint8_t pps_get_utc(uint32_t *seconds, uint32_t *micros) {
+	uint64_t pulse, now;
+	int64_t elapsed;
+	uint32_t utc_s;
+	uint8_t valid;
+
+	chSysLock();
+	pulse = pps_utc_pulse_us;
+	utc_s = pps_utc_s;
+	valid = pps_utc_valid;
+	now = pps_now_us_I();
+	chSysUnlock();
+
+	if (!valid || now - pulse > (uint64_t)PPS_HOLDOVER_S * PPS_SECOND_US)
+		return FALSE;
+
+	elapsed = now - pulse;
+	elapsed -= elapsed * pps_stats.drift_ppb / 1000000000;
+
+	*seconds = utc_s + (uint32_t)(elapsed / PPS_SECOND_US);
+	*micros = (uint32_t)(elapsed % PPS_SECOND_US);
+
+	return TRUE;
+}
+
+void pps_get_stats(pps_stats_t *stats) {
+	chSysLock();
+	*stats = pps_stats;
+	chSysUnlock();
+}
@@ -0,0 +1,78 @@
+/*
+ * pps.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef PPS_H_
+#define PPS_H_
+
+#include "ch.h"
+#include "hal.h"
+
+#include <stdint.h>
+
+/*
+ * Sentences of an epoch follow its 1PPS edge within this time, an older
+ * edge belongs to a previous epoch.
+ */
+#if !defined(PPS_EPOCH_WINDOW_MS)
+#define PPS_EPOCH_WINDOW_MS		900
+#endif
+
+// UTC is carried on the system clock this long after the last synced edge
+#if !defined(PPS_HOLDOVER_S)
+#define PPS_HOLDOVER_S			3600
+#endif
+
+// Edges further than this from one second after the previous one are not timing samples
+#if !defined(PPS_MAX_JITTER_US)
+#define PPS_MAX_JITTER_US		1000
+#endif
+
+// RTC calendar is set from a synced edge this often, seconds
+#if !defined(PPS_RTC_SYNC_S)
+#define PPS_RTC_SYNC_S			3600
+#endif
+
+// Wraps of the system time are counted this often without edges, seconds
+#if !defined(PPS_WRAP_CHECK_S)
+#define PPS_WRAP_CHECK_S		86400
+#endif
+
+/*
+ * 1PPS timing counters for diagnostics, kept since power on.
+ */
+typedef struct pps_stats {
+	uint32_t pulses;
+
+	// Edges matched to a fix with a valid UTC date and time
+	uint32_t synced;
+
+	// Edges not one second after the previous one (missed pulses, no fix)
+	uint32_t gaps;
+
+	// Last second measured by the system clock, microseconds
+	uint32_t interval_us;
+
+	// System clock error, parts per billion, positive when it runs fast
+	int32_t drift_ppb;
+} pps_stats_t;
+
+#if HAL_USE_EXT
+extern void pps_ext_cb(EXTDriver *extp, expchannel_t channel);
+#endif
+
+extern void pps_init(void);
+
+extern uint64_t pps_now_us(void);
+
+extern uint64_t pps_epoch_time(void);
+
+extern void pps_set_utc(uint64_t pulse_us, uint32_t utc_s);
+
+extern uint8_t pps_get_utc(uint32_t *seconds, uint32_t *micros);
+
+extern void pps_get_stats(pps_stats_t *stats);
+
+#endif /* PPS_H_ */
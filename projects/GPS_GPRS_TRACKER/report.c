@@ -0,0 +1,106 @@
+/*
+ * report.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Adaptive fix selection for the uplink. A parked vehicle sends a
+ * heartbeat now and then, a moving one a fix every so many meters and
+ * one on every turn, so the track keeps its shape at a fraction of the
+ * fixes. Thresholds depend on the speed band of the current fix.
+ */
+
+#include "report.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "fixcodec.h"
+
+const report_band_t report_default_bands[] = {
+	// Parked, distance only catches a tow away, not the position noise
+	{150, 200, 0, 5, 1800},
+	// City, up to 46 km/h
+	{2500, 100, 1500, 2, 60},
+	// Road, up to 111 km/h
+	{6000, 300, 1000, 2, 60},
+	// Highway
+	{0xFFFF, 1000, 500, 1, 120}
+};
+
+void report_init(report_t *r, const report_band_t *bands) {
+	r->bands = bands != NULL ? bands : report_default_bands;
+	r->has_last = 0;
+
+	memset(&r->stats, 0, sizeof(r->stats));
+}
+
+const report_band_t *report_band(const report_t *r, uint16_t speed) {
+	const report_band_t *band = r->bands;
+
+	while (speed > band->speed_max)
+		band++;
+
+	return band;
+}
+
+static uint8_t report_decide(report_t *r, const gps_fix_t *fix, const geo_point_t *point, uint32_t time) {
+	const report_band_t *band = report_band(r, fix->nav.speed);
+	uint32_t elapsed;
+	int16_t turn;
+
+	if (!r->has_last)
+		return REPORT_FIRST;
+
+	// Clock went back or skipped ahead (receiver reset, bad date)
+	if (time < r->last_time || time - r->last_time > 0xFFFF)
+		return REPORT_TIME_JUMP;
+
+	elapsed = time - r->last_time;
+
+	if (elapsed < band->min_interval_s)
+		return REPORT_SKIP;
+
+	if (elapsed >= band->max_interval_s)
+		return REPORT_INTERVAL;
+
+	if (band->distance_m && geo_distance(&r->last_point, point) >= (uint32_t)band->distance_m * 100)
+		return REPORT_DISTANCE;
+
+	if (band->heading_cdeg && fix->nav.speed >= REPORT_HEADING_MIN_SPEED) {
+		turn = geo_course_diff(r->last_course, fix->nav.course);
+
+		if (turn >= band->heading_cdeg || -turn >= band->heading_cdeg)
+			return REPORT_HEADING;
+	}
+
+	return REPORT_SKIP;
+}
+
+/*
+ * Returns the REPORT_REASON the fix is worth sending for, REPORT_SKIP
+ * when it is not. Expects usable fixes only, see gps_fix_is_usable().
+ */
+uint8_t report_select(report_t *r, const gps_fix_t *fix) {
+	uint32_t time = fix_codec_timestamp(&fix->nav);
+	geo_point_t point;
+	uint8_t reason;
+
+	geo_from_nav(&fix->nav, &point);
+
+	reason = report_decide(r, fix, &point, time);
+
+	r->stats.fixes++;
+	r->stats.reasons[reason]++;
+
+	if (reason == REPORT_SKIP)
+		return REPORT_SKIP;
+
+	r->stats.reported++;
+
+	r->last_point = point;
+	r->last_time = time;
+	r->last_course = fix->nav.course;
+	r->has_last = 1;
+
+	return reason;
+}
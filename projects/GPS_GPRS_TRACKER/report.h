@@ -0,0 +1,79 @@
+/*
+ * report.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef REPORT_H_
+#define REPORT_H_
+
+#include <stdint.h>
+
+#include "gps_fix.h"
+#include "geo.h"
+
+// Course of a slower fix is too noisy for the heading rule, 1/100 knots
+#if !defined(REPORT_HEADING_MIN_SPEED)
+#define REPORT_HEADING_MIN_SPEED	300
+#endif
+
+typedef enum REPORT_REASON {
+	REPORT_SKIP				=	0x00,
+	REPORT_FIRST			=	0x01,
+	REPORT_DISTANCE			=	0x02,
+	REPORT_HEADING			=	0x03,
+	REPORT_INTERVAL			=	0x04,
+	REPORT_TIME_JUMP		=	0x05,
+	REPORT_REASON_COUNT		=	0x06
+} REPORT_REASON;
+
+/*
+ * Reporting rules for fixes up to speed_max, 1/100 knots. Zero distance
+ * or heading turns the rule off. Bands are sorted by speed_max, the last
+ * one has speed_max 0xFFFF.
+ */
+typedef struct report_band {
+	uint16_t speed_max;
+
+	// Distance from the last reported fix, m
+	uint16_t distance_m;
+
+	// Turn from the course of the last reported fix, 1/100 degrees
+	uint16_t heading_cdeg;
+
+	// No report sooner than min_interval_s, always one after max_interval_s
+	uint16_t min_interval_s;
+	uint16_t max_interval_s;
+} report_band_t;
+
+typedef struct report_stats {
+	uint32_t fixes;
+	uint32_t reported;
+	uint32_t reasons[REPORT_REASON_COUNT];
+} report_stats_t;
+
+/*
+ * Per fix decision whether it goes to the uplink. Only fixes the uplink
+ * got are remembered, so slow drift and gentle curves add up until they
+ * cross a threshold.
+ */
+typedef struct report {
+	const report_band_t *bands;
+
+	geo_point_t last_point;
+	uint32_t last_time;
+	uint16_t last_course;
+	uint8_t has_last;
+
+	report_stats_t stats;
+} report_t;
+
+extern const report_band_t report_default_bands[];
+
+extern void report_init(report_t *r, const report_band_t *bands);
+
+extern uint8_t report_select(report_t *r, const gps_fix_t *fix);
+
+extern const report_band_t *report_band(const report_t *r, uint16_t speed);
+
+#endif /* REPORT_H_ */
@@ -0,0 +1,18 @@
+/*
+ * board.c
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "ch.h"
+#include "hal.h"
+
+#if HAL_USE_PAL
+const PALConfig pal_default_config = {
+	{0, 0, 0},
+	{0, 0, 0}
+};
+#endif
+
+void boardInit(void) {
+}
@@ -0,0 +1,87 @@
+/*
+ * board.h
+ *
+ *  Created on: 16.10.2026
+ *
+ * Tracker pin assignments on the virtual I/O ports of the Posix simulator,
+ * port A is IOPORT1 and port B is IOPORT2. Pin numbers are the same as on
+ * boards/GPS_GPRS_TRACKER_BOARD.
+ */
+
+#ifndef _BOARD_H_
+#define _BOARD_H_
+
+#define BOARD_NAME					"GPS Tracker simulator"
+
+#define GPIOA						IOPORT1
+#define GPIOB						IOPORT2
+
+// Alternate functions have no meaning on the virtual ports
+#define PAL_MODE_ALTERNATE(n)		PAL_MODE_UNCONNECTED
+
+#define GPIO_LED_0_PORT				GPIOB
+#define GPIO_LED_0_PIN				0
+#define GPIO_LED_1_PORT				GPIOB
+#define GPIO_LED_1_PIN				1
+
+#define GPIO_GPRS_PWR_BAT_PORT		GPIOB
+#define GPIO_GPRS_PWR_BAT_PIN		12
+#define GPIO_GPRS_PWR_EXT_PORT		GPIOB
+#define GPIO_GPRS_PWR_EXT_PIN		13
+#define GPIO_GPS_PWR_PORT			GPIOB
+#define GPIO_GPS_PWR_PIN			14
+
+#define GPIO_EEPROM_WC_PORT			GPIOB
+#define GPIO_EEPROM_WC_PIN			5
+
+#define GPIO_ACCEL_INT_1_PORT		GPIOB
+#define GPIO_ACCEL_INT_1_PIN		6
+#define GPIO_ACCEL_INT_2_PORT		GPIOB
+#define GPIO_ACCEL_INT_2_PIN		7
+
+#define GPIO_GPS_PULSE_PORT			GPIOB
+#define GPIO_GPS_PULSE_PIN			15
+
+#define GPIO_GPRS_RESET_PORT		GPIOA
+#define GPIO_GPRS_RESET_PIN			7
+
+#define GPIO_CHG_PORT				GPIOA
+#define GPIO_CHG_PIN				6
+
+#define GPIO_12V_SENSE_PORT			GPIOA
+#define GPIO_12V_SENSE_PIN			4
+#define GPIO_12V_SENSE_CHANNEL		4
+
+#define GPIO_VBAT_SENSE_PORT		GPIOA
+#define GPIO_VBAT_SENSE_PIN			5
+#define GPIO_VBAT_SENSE_CHANNEL		5
+
+#define GPRS_USART_PORT				GPIOA
+#define GPRS_USART_TX_PIN			3
+#define GPRS_USART_RX_PIN			2
+#define GPRS_USART_RTS_PIN			0
+#define GPRS_USART_CTS_PIN			1
+
+#define GPS_USART_PORT				GPIOB
+#define GPS_USART_TX_PIN			11
+#define GPS_USART_RX_PIN			10
+
+#define EXT_USART_PORT				GPIOA
+#define EXT_USART_TX_PIN			9
+#define EXT_USART_RX_PIN			10
+
+#define I2C_PORT					GPIOB
+#define I2C_SCL_PIN					8
+#define I2C_SDA_PIN					9
+
+#if !defined(_FROM_ASM_)
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void boardInit(void);
+#ifdef __cplusplus
+}
+#endif
+#endif /* _FROM_ASM_ */
+
+#endif /* _BOARD_H_ */
@@ -0,0 +1,165 @@
+/*
+ * main.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Tracker application on the Posix simulator. The GPS receiver and the
+ * modem are TCP ports played by the replay tool, see readme.txt.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+
+#include "gps.h"
+#include "gprs.h"
+#include "led.h"
+#include "bufpool.h"
+#include "uplink.h"
+
+#define SIM_STATS_INTERVAL_S	10
+
+// Size of the flash region the device keeps its fence image in
+#define SIM_FENCES_SIZE			(16 * 1024)
+
+// Fence image, word aligned as in flash
+static uint32_t fence_image[SIM_FENCES_SIZE / sizeof(uint32_t)];
+
+/*
+ * Ticks the thread spent running, the idle thread is busy polling the
+ * simulated interrupt sources and is not counted.
+ */
+static systime_t thread_time(const char *name) {
+	Thread *tp = chRegFirstThread();
+	systime_t time = 0;
+
+	do {
+		if (tp->p_name != NULL && strcmp(tp->p_name, name) == 0)
+			time = tp->p_time;
+
+		tp = chRegNextThread(tp);
+	} while (tp != NULL);
+
+	return time;
+}
+
+static void print_stats(uint32_t fixes, uint32_t usable) {
+	gprs_stats_t link;
+	gps_stats_t rx;
+	report_stats_t report;
+	simplify_stats_t simplify;
+	geofence_stats_t fences;
+	fixlog_stats_t log;
+	systime_t gps_time = thread_time("gps_thread");
+	systime_t gprs_time = thread_time("gprs_thread");
+
+	gprs_get_stats(&link);
+	gps_get_stats(&rx);
+	uplink_get_report_stats(&report);
+	uplink_get_simplify_stats(&simplify);
+	uplink_get_geofence_stats(&fences);
+	uplink_get_fixlog_stats(&log);
+
+	printf("fixes %lu (usable %lu), gps thread %lu ms", (unsigned long)fixes,
+			(unsigned long)usable, (unsigned long)(gps_time * 1000 / CH_FREQUENCY));
+
+	if (fixes > 0)
+		printf(" (%lu us/fix)", (unsigned long)((uint64_t)gps_time * 1000000 / CH_FREQUENCY / fixes));
+
+	printf(", gprs thread %lu ms\n", (unsigned long)(gprs_time * 1000 / CH_FREQUENCY));
+
+	printf("gps sentences %lu, timeouts %lu, overruns %lu, chksum %lu, format %lu, unknown %lu, parse %lu, resets %lu (reconfigured %lu)\n",
+			(unsigned long)rx.sentences, (unsigned long)rx.timeouts, (unsigned long)rx.overruns,
+			(unsigned long)rx.chksum_errors, (unsigned long)rx.format_errors,
+			(unsigned long)rx.unknown_types, (unsigned long)rx.parse_errors, (unsigned long)rx.resets,
+			(unsigned long)rx.reconfigurations);
+
+	printf("link state %u, attempts %lu, connects %lu (last %lu ms), drops %lu, sent %lu bytes, backoff %lu s\n",
+			link.state, (unsigned long)link.connect_attempts, (unsigned long)link.connects,
+			(unsigned long)link.time_to_connect_ms, (unsigned long)link.drops,
+			(unsigned long)link.bytes_sent, (unsigned long)link.backoff_s);
+
+	printf("reported %lu of %lu fixes: distance %lu, heading %lu, interval %lu, %lu left after simplification\n",
+			(unsigned long)report.reported, (unsigned long)report.fixes,
+			(unsigned long)report.reasons[REPORT_DISTANCE], (unsigned long)report.reasons[REPORT_HEADING],
+			(unsigned long)report.reasons[REPORT_INTERVAL], (unsigned long)simplify.emitted);
+
+	if (fences.fixes > 0)
+		printf("geofence events %lu (dropped %lu), %lu fence tests per fix\n", (unsigned long)fences.events,
+				(unsigned long)fences.dropped, (unsigned long)(fences.tests / fences.fixes));
+
+	printf("log records %lu, pages written %lu, lost %lu, crc errors %lu, io errors %lu\n",
+			(unsigned long)log.records, (unsigned long)log.pages_written, (unsigned long)log.pages_lost,
+			(unsigned long)log.crc_errors, (unsigned long)log.io_errors);
+
+	fflush(stdout);
+}
+
+/*
+ * Loads the fence image the device reads from flash, made by test/mkfences.
+ */
+static int load_fences(const char *path) {
+	FILE *f = fopen(path, "rb");
+	size_t len;
+
+	if (f == NULL) {
+		perror(path);
+		return -1;
+	}
+
+	len = fread(fence_image, 1, sizeof(fence_image), f);
+	fclose(f);
+
+	if (uplink_set_geofences((const uint8_t *)fence_image, len) != GEOFENCE_OK) {
+		fprintf(stderr, "%s: not a fence image\n", path);
+		return -1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	EventListener fix_listener;
+	fix_ring_reader_t reader;
+	gps_fix_t fix;
+	uint32_t fixes = 0, usable = 0;
+	systime_t last_stats;
+
+	halInit();
+	chSysInit();
+
+	bufpool_init();
+
+	led_init();
+
+	if (argc > 1 && load_fences(argv[1]) != 0)
+		return 1;
+
+	init_gprs();
+	init_gps();
+
+	gps_fix_reader_init(&reader);
+	chEvtRegister(&gps_fix_event, &fix_listener, 0);
+
+	last_stats = chTimeNow();
+
+	while (TRUE) {
+		chEvtWaitAnyTimeout(ALL_EVENTS, S2ST(1));
+
+		while (gps_fix_read(&reader, &fix) == FIX_RING_OK) {
+			fixes++;
+
+			if (gps_fix_is_usable(&fix))
+				usable++;
+		}
+
+		if (chTimeNow() - last_stats >= S2ST(SIM_STATS_INTERVAL_S)) {
+			print_stats(fixes, usable);
+			last_stats = chTimeNow();
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,689 @@
+/*
+ * replay.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Plays the GPS receiver and the modem for the tracker simulator.
+ * NMEA text from a log (or the synthetic test track) is sent to the GPS
+ * port one epoch at a time, the modem port answers AT commands from a
+ * script and counts what the tracker uploads.
+ *
+ * Usage: replay [-x speed] [-l linger] [-v] [-m modem.script] [-s seed | track.nmea]
+ *   -x  epochs per second of real time, 0 sends as fast as possible (default 10)
+ *   -l  seconds to keep answering the modem after the last epoch (default 10)
+ *   -v  print the modem dialog and everything the tracker sends to the GPS
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "nmea.h"
+#include "track.h"
+
+#define GPS_PORT				29001
+#define MODEM_PORT				29002
+
+#define CONNECT_TIMEOUT_MS		30000
+
+// Silence after "+++" that makes it an escape and not data
+#define ESCAPE_GUARD_MS			500
+
+#define MAX_RULES				64
+#define MAX_RESPONSES			4
+#define MAX_LINE				256
+
+#define DLE						0x10
+
+/*
+ * Script line: [count*]<command prefix> => <response> | <response> ...
+ * The first rule whose prefix matches and that has uses left answers.
+ * "@<seconds> <line>" sends an unsolicited line that long after start.
+ */
+typedef struct rule {
+	char prefix[64];
+	char responses[MAX_RESPONSES][64];
+	int response_count;
+	int uses;
+	int at_ms;
+} rule_t;
+
+static const char *default_script =
+		"ATZ => OK\n"
+		"ATE0 => OK\n"
+		"AT+CREG=1 => OK\n"
+		"AT+CGREG=1 => OK\n"
+		"AT+CREG? => +CREG: 1,1 | OK\n"
+		"AT+CGREG? => +CGREG: 1,1 | OK\n"
+		"AT+CSQ => +CSQ: 17,99 | OK\n"
+		"AT+WIPCFG => OK\n"
+		"AT+WIPBR => OK\n"
+		"AT+WIPCREATE => OK | +WIPREADY: 2,1\n"
+		"AT+WIPDATA => CONNECT\n"
+		"AT+WIPCLOSE => OK\n";
+
+static rule_t rules[MAX_RULES];
+static int rule_count;
+
+static int verbose;
+
+static struct {
+	size_t sentences;
+	size_t epochs;
+	size_t bytes;
+
+	size_t commands;
+	size_t unknown_commands;
+	size_t sessions;
+	size_t wire_bytes;
+	size_t payload_bytes;
+	size_t batches;
+	size_t bad_batches;
+	size_t fixes;
+	size_t events;
+} stats;
+
+static long now_ms() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+static char *trim(char *s) {
+	char *end;
+
+	while (*s == ' ' || *s == '\t')
+		s++;
+
+	end = s + strlen(s);
+
+	while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n'))
+		*--end = '\0';
+
+	return s;
+}
+
+static void parse_rule(char *line) {
+	rule_t *r;
+	char *p, *sep, *resp;
+
+	line = trim(line);
+
+	if (*line == '\0' || *line == '#')
+		return;
+
+	if (rule_count == MAX_RULES) {
+		fprintf(stderr, "replay: too many script rules\n");
+		exit(1);
+	}
+
+	r = &rules[rule_count];
+	memset(r, 0, sizeof(*r));
+	r->uses = -1;
+	r->at_ms = -1;
+
+	if (*line == '@') {
+		r->at_ms = (int)(strtod(line + 1, &p) * 1000);
+		snprintf(r->responses[0], sizeof(r->responses[0]), "%s", trim(p));
+		r->response_count = 1;
+		rule_count++;
+		return;
+	}
+
+	if ((p = strchr(line, '*')) != NULL && p < strstr(line, "=>")) {
+		r->uses = atoi(line);
+		line = p + 1;
+	}
+
+	if ((sep = strstr(line, "=>")) == NULL) {
+		fprintf(stderr, "replay: bad script line: %s\n", line);
+		exit(1);
+	}
+
+	*sep = '\0';
+	snprintf(r->prefix, sizeof(r->prefix), "%s", trim(line));
+
+	for (resp = strtok(sep + 2, "|"); resp != NULL && r->response_count < MAX_RESPONSES; resp = strtok(NULL, "|"))
+		snprintf(r->responses[r->response_count++], sizeof(r->responses[0]), "%s", trim(resp));
+
+	rule_count++;
+}
+
+static void load_script(const char *path) {
+	char line[MAX_LINE];
+	char *text, *p, *next;
+	FILE *f;
+
+	if (path == NULL) {
+		text = strdup(default_script);
+
+		for (p = text; p != NULL && *p; p = next) {
+			next = strchr(p, '\n');
+
+			if (next != NULL)
+				*next++ = '\0';
+
+			parse_rule(p);
+		}
+
+		free(text);
+		return;
+	}
+
+	if ((f = fopen(path, "r")) == NULL) {
+		perror(path);
+		exit(1);
+	}
+
+	while (fgets(line, sizeof(line), f) != NULL)
+		parse_rule(line);
+
+	fclose(f);
+}
+
+static int connect_port(int port) {
+	struct sockaddr_in sa;
+	long deadline = now_ms() + CONNECT_TIMEOUT_MS;
+	int fd, one = 1;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_port = htons(port);
+	sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	// The simulator opens its ports when the threads start the drivers
+	while (now_ms() < deadline) {
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+
+		if (fd < 0) {
+			perror("socket");
+			exit(1);
+		}
+
+		if (connect(fd, (struct sockaddr *)&sa, sizeof(sa)) == 0) {
+			setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+			return fd;
+		}
+
+		close(fd);
+		usleep(100000);
+	}
+
+	fprintf(stderr, "replay: nothing listens on port %d\n", port);
+	exit(1);
+}
+
+static void send_all(int fd, const void *data, size_t len) {
+	const uint8_t *p = data;
+	ssize_t n;
+
+	while (len > 0) {
+		n = send(fd, p, len, MSG_NOSIGNAL);
+
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+
+			perror("replay: send");
+			exit(1);
+		}
+
+		p += n;
+		len -= n;
+	}
+}
+
+/*
+ * NMEA text split into epochs, the tracker gets one epoch per tick.
+ */
+typedef struct feed {
+	const char *text;
+	size_t len;
+	size_t pos;
+
+	nmea_parser_t parser;
+	uint8_t buf[256];
+	nmea_sentence_t sentence;
+	int32_t epoch;
+} feed_t;
+
+static void feed_init(feed_t *f, const char *text, size_t len) {
+	memset(f, 0, sizeof(*f));
+	f->text = text;
+	f->len = len;
+	f->epoch = -1;
+
+	nmea_init(&f->parser, f->buf, sizeof(f->buf));
+}
+
+/*
+ * Length of the text up to the first sentence of the next epoch.
+ */
+static size_t feed_next_epoch(feed_t *f) {
+	size_t start = f->pos, line_start = f->pos;
+	int seen = 0;
+	int32_t epoch;
+
+	while (f->pos < f->len) {
+		char c = f->text[f->pos++];
+
+		if (c == '$')
+			line_start = f->pos - 1;
+
+		if (nmea_put(&f->parser, (uint8_t)c) != NMEA_SENTENCE)
+			continue;
+
+		nmea_index(&f->sentence, f->buf, f->parser.len);
+		epoch = nmea_sentence_epoch(&f->sentence, nmea_message_type(&f->sentence));
+
+		if (epoch >= 0 && epoch != f->epoch) {
+			if (seen) {
+				// Opens the next epoch, sent next time
+				f->pos = line_start;
+				nmea_reset(&f->parser);
+
+				return line_start - start;
+			}
+
+			f->epoch = epoch;
+		}
+
+		if (epoch >= 0)
+			seen = 1;
+
+		stats.sentences++;
+	}
+
+	return f->pos - start;
+}
+
+static void print_line(const char *dir, const char *line) {
+	if (verbose)
+		fprintf(stderr, "%s %s\n", dir, line);
+}
+
+static void modem_send_line(int fd, const char *line) {
+	print_line("modem>", line);
+
+	send_all(fd, "\r\n", 2);
+	send_all(fd, line, strlen(line));
+	send_all(fd, "\r\n", 2);
+}
+
+/*
+ * Uplink batches: 'G' 'T' <count> <length, 2 bytes> <payload>, geofence
+ * events the same with 'G' 'E'
+ */
+static void count_batches(const uint8_t *data, size_t len) {
+	size_t pos = 0, payload;
+
+	while (pos + 5 <= len) {
+		if (data[pos] != 'G' || (data[pos + 1] != 'T' && data[pos + 1] != 'E')) {
+			stats.bad_batches++;
+			return;
+		}
+
+		payload = ((size_t)data[pos + 3] << 8) | data[pos + 4];
+
+		if (pos + 5 + payload > len) {
+			stats.bad_batches++;
+			return;
+		}
+
+		if (data[pos + 1] == 'E') {
+			stats.events += data[pos + 2];
+
+			if (verbose)
+				fprintf(stderr, "modem: %u geofence events\n", data[pos + 2]);
+		} else {
+			stats.batches++;
+			stats.fixes += data[pos + 2];
+
+			if (verbose)
+				fprintf(stderr, "modem: batch of %u fixes, %zu bytes\n", data[pos + 2], payload + 5);
+		}
+
+		pos += 5 + payload;
+	}
+
+	if (pos != len)
+		stats.bad_batches++;
+}
+
+typedef struct modem {
+	int fd;
+
+	char line[MAX_LINE];
+	size_t line_len;
+
+	int data_mode;
+	int escaped;
+	int plus_count;
+	long last_rx;
+
+	uint8_t *payload;
+	size_t payload_len;
+	size_t payload_size;
+} modem_t;
+
+static void modem_command(modem_t *m) {
+	rule_t *r;
+	int i, j;
+
+	print_line("modem<", m->line);
+	stats.commands++;
+
+	for (i = 0; i < rule_count; i++) {
+		r = &rules[i];
+
+		if (r->at_ms >= 0 || r->uses == 0)
+			continue;
+
+		if (strncmp(m->line, r->prefix, strlen(r->prefix)) != 0)
+			continue;
+
+		if (r->uses > 0)
+			r->uses--;
+
+		for (j = 0; j < r->response_count; j++) {
+			modem_send_line(m->fd, r->responses[j]);
+
+			if (strncmp(r->responses[j], "CONNECT", 7) == 0) {
+				m->data_mode = 1;
+				m->escaped = 0;
+				m->plus_count = 0;
+				m->payload_len = 0;
+				stats.sessions++;
+			}
+		}
+
+		return;
+	}
+
+	stats.unknown_commands++;
+
+	if (verbose)
+		fprintf(stderr, "modem: no rule for %s\n", m->line);
+
+	modem_send_line(m->fd, "ERROR");
+}
+
+static void modem_payload_put(modem_t *m, uint8_t c) {
+	if (m->payload_len == m->payload_size) {
+		m->payload_size = m->payload_size ? m->payload_size * 2 : 4096;
+		m->payload = realloc(m->payload, m->payload_size);
+
+		if (m->payload == NULL) {
+			fprintf(stderr, "replay: out of memory\n");
+			exit(1);
+		}
+	}
+
+	m->payload[m->payload_len++] = c;
+}
+
+static void modem_rx(modem_t *m, const uint8_t *data, size_t len) {
+	size_t i;
+
+	m->last_rx = now_ms();
+
+	for (i = 0; i < len; i++) {
+		uint8_t c = data[i];
+
+		if (m->data_mode) {
+			stats.wire_bytes++;
+
+			// Kept back until it is clear the '+' are not the escape
+			m->plus_count = (c == '+' && !m->escaped) ? m->plus_count + 1 : 0;
+
+			if (m->escaped) {
+				m->escaped = 0;
+				modem_payload_put(m, c);
+			} else if (c == DLE) {
+				m->escaped = 1;
+			} else {
+				modem_payload_put(m, c);
+			}
+
+			continue;
+		}
+
+		if (c == '\n')
+			continue;
+
+		if (c == '\r') {
+			m->line[m->line_len] = '\0';
+
+			if (m->line_len > 0)
+				modem_command(m);
+
+			m->line_len = 0;
+			continue;
+		}
+
+		if (m->line_len < sizeof(m->line) - 1)
+			m->line[m->line_len++] = c;
+	}
+}
+
+/*
+ * Leaves data mode once "+++" was followed by the guard time of silence.
+ */
+static void modem_check_escape(modem_t *m) {
+	if (!m->data_mode || m->plus_count < 3 || now_ms() - m->last_rx < ESCAPE_GUARD_MS)
+		return;
+
+	m->payload_len -= 3;
+	stats.wire_bytes -= 3;
+	stats.payload_bytes += m->payload_len;
+
+	count_batches(m->payload, m->payload_len);
+
+	m->data_mode = 0;
+	m->plus_count = 0;
+
+	modem_send_line(m->fd, "OK");
+}
+
+static void modem_timed_events(modem_t *m, long elapsed_ms) {
+	int i;
+
+	for (i = 0; i < rule_count; i++) {
+		if (rules[i].at_ms < 0 || rules[i].at_ms > elapsed_ms)
+			continue;
+
+		modem_send_line(m->fd, rules[i].responses[0]);
+
+		// Once only
+		rules[i].at_ms = -1;
+		rules[i].uses = 0;
+	}
+}
+
+static void gps_rx(const uint8_t *data, size_t len) {
+	static char line[MAX_LINE];
+	static size_t line_len;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if (data[i] == '\r' || data[i] == '\n') {
+			line[line_len] = '\0';
+
+			if (line_len > 0)
+				print_line("gps<", line);
+
+			line_len = 0;
+		} else if (line_len < sizeof(line) - 1) {
+			line[line_len++] = data[i];
+		}
+	}
+}
+
+static void usage() {
+	fprintf(stderr, "usage: replay [-x speed] [-l linger] [-v] [-m modem.script] [-s seed | track.nmea]\n");
+	exit(1);
+}
+
+int main(int argc, char **argv) {
+	double speed = 10;
+	int linger_s = 10;
+	const char *script = NULL, *nmea_path = NULL;
+	int synthetic = 0;
+	unsigned seed = 1;
+	char *text = NULL;
+	size_t text_len = 0;
+	long start, next_epoch, done_at = -1, elapsed;
+	feed_t feed;
+	modem_t modem;
+	int gps_fd, opt;
+
+	while ((opt = getopt(argc, argv, "x:l:m:s:v")) != -1) {
+		switch (opt) {
+		case 'x': speed = atof(optarg); break;
+		case 'l': linger_s = atoi(optarg); break;
+		case 'm': script = optarg; break;
+		case 's': synthetic = 1; seed = (unsigned)atoi(optarg); break;
+		case 'v': verbose = 1; break;
+		default: usage();
+		}
+	}
+
+	if (optind < argc)
+		nmea_path = argv[optind];
+	else if (!synthetic)
+		usage();
+
+	if (nmea_path != NULL) {
+		FILE *f = fopen(nmea_path, "rb");
+		long size;
+
+		if (f == NULL) {
+			perror(nmea_path);
+			return 1;
+		}
+
+		fseek(f, 0, SEEK_END);
+		size = ftell(f);
+		fseek(f, 0, SEEK_SET);
+
+		text = malloc(size > 0 ? size : 1);
+		text_len = fread(text, 1, size, f);
+		fclose(f);
+	} else {
+		track_t track;
+
+		track_init(&track);
+		track.nmea_out = open_memstream(&text, &text_len);
+		track_synthetic(&track, seed);
+		fclose(track.nmea_out);
+		track_free(&track);
+	}
+
+	load_script(script);
+
+	gps_fd = connect_port(GPS_PORT);
+
+	memset(&modem, 0, sizeof(modem));
+	modem.fd = connect_port(MODEM_PORT);
+
+	feed_init(&feed, text, text_len);
+
+	start = next_epoch = now_ms();
+
+	for (;;) {
+		struct pollfd fds[2];
+		uint8_t buf[512];
+		int timeout = 100;
+		ssize_t n;
+
+		elapsed = now_ms() - start;
+
+		if (done_at < 0 && now_ms() >= next_epoch) {
+			size_t len = feed_next_epoch(&feed);
+
+			if (len > 0) {
+				send_all(gps_fd, text + feed.pos - len, len);
+				stats.bytes += len;
+				stats.epochs++;
+			}
+
+			if (feed.pos >= feed.len) {
+				done_at = now_ms();
+				fprintf(stderr, "replay: track done, %zu epochs\n", stats.epochs);
+			}
+
+			next_epoch += speed > 0 ? (long)(1000 / speed) : 0;
+		}
+
+		if (done_at >= 0 && now_ms() - done_at >= linger_s * 1000L)
+			break;
+
+		if (done_at < 0) {
+			long wait = next_epoch - now_ms();
+
+			timeout = wait < 0 ? 0 : (wait < timeout ? (int)wait : timeout);
+		}
+
+		fds[0].fd = gps_fd;
+		fds[0].events = POLLIN;
+		fds[1].fd = modem.fd;
+		fds[1].events = POLLIN;
+
+		if (poll(fds, 2, timeout) < 0 && errno != EINTR) {
+			perror("replay: poll");
+			return 1;
+		}
+
+		if (fds[0].revents & (POLLIN | POLLHUP)) {
+			if ((n = recv(gps_fd, buf, sizeof(buf), 0)) <= 0) {
+				fprintf(stderr, "replay: GPS port closed\n");
+				break;
+			}
+
+			gps_rx(buf, n);
+		}
+
+		if (fds[1].revents & (POLLIN | POLLHUP)) {
+			if ((n = recv(modem.fd, buf, sizeof(buf), 0)) <= 0) {
+				fprintf(stderr, "replay: modem port closed\n");
+				break;
+			}
+
+			modem_rx(&modem, buf, n);
+		}
+
+		modem_check_escape(&modem);
+		modem_timed_events(&modem, elapsed);
+	}
+
+	elapsed = (done_at >= 0 ? done_at : now_ms()) - start;
+
+	printf("gps: %zu sentences, %zu epochs, %zu bytes in %.1f s, %.0f sentences/s\n",
+			stats.sentences, stats.epochs, stats.bytes, elapsed / 1000.0,
+			elapsed > 0 ? stats.sentences * 1000.0 / elapsed : 0.0);
+
+	printf("modem: %zu commands (%zu unknown), %zu data sessions, %zu bytes on the wire, %zu payload\n",
+			stats.commands, stats.unknown_commands, stats.sessions, stats.wire_bytes, stats.payload_bytes);
+
+	printf("uplink: %zu batches (%zu bad), %zu fixes, %zu geofence events, %.2f bytes/fix on the wire\n",
+			stats.batches, stats.bad_batches, stats.fixes, stats.events,
+			stats.fixes > 0 ? (double)stats.wire_bytes / stats.fixes : 0.0);
+
+	close(gps_fd);
+	close(modem.fd);
+	free(modem.payload);
+	free(text);
+
+	return 0;
+}
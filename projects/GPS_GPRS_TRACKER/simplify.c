@@ -0,0 +1,131 @@
+/*
+ * simplify.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Line simplification of the reported fixes before the uplink encoder.
+ * Straight stretches shrink to their end points, curves keep as many
+ * vertices as it takes to stay within the tolerance.
+ */
+
+#include "simplify.h"
+
+#include <string.h>
+
+// Microdegrees of arc per km on the mean radius
+#define SIMPLIFY_UDEG_PER_KM	8993
+
+void simplify_init(simplify_t *s, uint16_t tolerance_m) {
+	s->tolerance = ((uint32_t)tolerance_m * SIMPLIFY_UDEG_PER_KM + 500) / 1000;
+	s->has_anchor = 0;
+	s->count = 0;
+
+	memset(&s->stats, 0, sizeof(s->stats));
+}
+
+/*
+ * Whether every fix in the window is within the tolerance of the segment
+ * from the anchor to p. All in microdegrees of arc on the tangent plane
+ * of the anchor: |cross| / |ap| is the distance from the line, beyond the
+ * segment ends the distance to the end point counts.
+ */
+static uint8_t simplify_fits(const simplify_t *s, const geo_point_t *p) {
+	int32_t px, py, qx, qy;
+	int64_t cross, dot, length2, tolerance2 = (int64_t)s->tolerance * s->tolerance;
+	uint32_t length;
+	uint8_t i;
+
+	geo_local(&s->anchor, p, &px, &py);
+
+	length2 = (int64_t)px * px + (int64_t)py * py;
+	length = geo_sqrt((uint64_t)length2);
+
+	for (i = 0; i < s->count; i++) {
+		geo_local(&s->anchor, &s->window[i], &qx, &qy);
+
+		dot = (int64_t)qx * px + (int64_t)qy * py;
+
+		if (dot <= 0) {
+			if ((int64_t)qx * qx + (int64_t)qy * qy > tolerance2)
+				return 0;
+		} else if (dot >= length2) {
+			qx -= px;
+			qy -= py;
+
+			if ((int64_t)qx * qx + (int64_t)qy * qy > tolerance2)
+				return 0;
+		} else {
+			cross = (int64_t)qx * py - (int64_t)qy * px;
+
+			if (cross < 0)
+				cross = -cross;
+
+			if (cross > (int64_t)s->tolerance * length)
+				return 0;
+		}
+	}
+
+	return 1;
+}
+
+/*
+ * Takes the next fix and writes the fixes to send into out, oldest
+ * first. Returns how many, 0 to 2. A forced fix (first one, heartbeat)
+ * is emitted right away and the previous one with it when needed.
+ */
+uint8_t simplify_push(simplify_t *s, const gps_fix_t *fix, uint8_t force, gps_fix_t *out) {
+	geo_point_t p;
+	uint8_t n = 0;
+
+	geo_from_nav(&fix->nav, &p);
+	s->stats.fixes++;
+
+	if (!s->has_anchor) {
+		s->anchor = p;
+		s->has_anchor = 1;
+		s->count = 0;
+
+		out[n++] = *fix;
+		s->stats.emitted++;
+
+		return n;
+	}
+
+	if (s->count > 0 && !simplify_fits(s, &p)) {
+		out[n++] = s->last;
+		s->anchor = s->window[s->count - 1];
+		s->count = 0;
+	}
+
+	s->window[s->count++] = p;
+	s->last = *fix;
+
+	if (force || s->count == SIMPLIFY_WINDOW) {
+		if (!force)
+			s->stats.window_full++;
+
+		out[n++] = *fix;
+		s->anchor = p;
+		s->count = 0;
+	}
+
+	s->stats.emitted += n;
+
+	return n;
+}
+
+/*
+ * Emits the newest fix if it is held back, e.g. before a batch goes out
+ * so it ends at the current position. Returns 1 when out was written.
+ */
+uint8_t simplify_flush(simplify_t *s, gps_fix_t *out) {
+	if (s->count == 0)
+		return 0;
+
+	*out = s->last;
+	s->anchor = s->window[s->count - 1];
+	s->count = 0;
+	s->stats.emitted++;
+
+	return 1;
+}
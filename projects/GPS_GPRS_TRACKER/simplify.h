@@ -0,0 +1,61 @@
+/*
+ * simplify.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef SIMPLIFY_H_
+#define SIMPLIFY_H_
+
+#include <stdint.h>
+
+#include "gps_fix.h"
+#include "geo.h"
+
+// Largest distance of a dropped fix from the simplified track, m
+#if !defined(SIMPLIFY_TOLERANCE_M)
+#define SIMPLIFY_TOLERANCE_M	10
+#endif
+
+// Fixes held back at most, bounds both the memory and the work per fix
+#if !defined(SIMPLIFY_WINDOW)
+#define SIMPLIFY_WINDOW			32
+#endif
+
+typedef struct simplify_stats {
+	uint32_t fixes;
+	uint32_t emitted;
+
+	// Vertices emitted because the window was full
+	uint32_t window_full;
+} simplify_stats_t;
+
+/*
+ * Streaming opening window simplification. The fixes after the last
+ * emitted one (the anchor) are held in the window while every one of
+ * them is within the tolerance of the segment from the anchor to the
+ * newest fix. When a fix breaks that, the one before it is emitted and
+ * becomes the new anchor. Only positions are kept in the window, the
+ * newest fix is kept whole because it is the one emitted next.
+ */
+typedef struct simplify {
+	uint32_t tolerance;
+
+	geo_point_t anchor;
+	uint8_t has_anchor;
+
+	geo_point_t window[SIMPLIFY_WINDOW];
+	uint8_t count;
+
+	gps_fix_t last;
+
+	simplify_stats_t stats;
+} simplify_t;
+
+extern void simplify_init(simplify_t *s, uint16_t tolerance_m);
+
+extern uint8_t simplify_push(simplify_t *s, const gps_fix_t *fix, uint8_t force, gps_fix_t *out);
+
+extern uint8_t simplify_flush(simplify_t *s, gps_fix_t *out);
+
+#endif /* SIMPLIFY_H_ */
@@ -0,0 +1,252 @@
+/*
+ * sirf.c
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "sirf.h"
+
+// Geodetic Navigation Data (MID 41) payload layout
+#define GEO_NAV_VALID_OFFSET		1
+#define GEO_NAV_TYPE_OFFSET			3
+#define GEO_UTC_YEAR_OFFSET			11
+#define GEO_UTC_MONTH_OFFSET		13
+#define GEO_UTC_DAY_OFFSET			14
+#define GEO_UTC_HOUR_OFFSET			15
+#define GEO_UTC_MINUTE_OFFSET		16
+#define GEO_UTC_SECOND_OFFSET		17
+#define GEO_LATITUDE_OFFSET			23
+#define GEO_LONGITUDE_OFFSET		27
+#define GEO_ALTITUDE_MSL_OFFSET		35
+#define GEO_SPEED_OFFSET			40
+#define GEO_COURSE_OFFSET			42
+#define GEO_SATELLITES_OFFSET		88
+#define GEO_HDOP_OFFSET				89
+#define GEO_PAYLOAD_LEN				91
+
+#define GEO_NAV_TYPE_MASK			0x07
+#define GEO_NAV_TYPE_DGPS			0x80
+
+void sirf_init(sirf_parser_t *p, uint8_t *buf, size_t size) {
+	p->buf = buf;
+	p->size = size;
+
+	sirf_reset(p);
+}
+
+void sirf_reset(sirf_parser_t *p) {
+	p->len = 0;
+	p->payload_len = 0;
+	p->state = SIRF_STATE_START_1;
+	p->chksum = 0;
+	p->rx_chksum = 0;
+}
+
+uint8_t sirf_put(sirf_parser_t *p, uint8_t c) {
+	switch (p->state) {
+	case SIRF_STATE_START_1:
+		if (c == SIRF_START_1)
+			p->state = SIRF_STATE_START_2;
+		return SIRF_PENDING;
+
+	case SIRF_STATE_START_2:
+		if (c == SIRF_START_2) {
+			p->state = SIRF_STATE_LEN_HI;
+		} else if (c != SIRF_START_1) {
+			p->state = SIRF_STATE_START_1;
+		}
+		return SIRF_PENDING;
+
+	case SIRF_STATE_LEN_HI:
+		p->payload_len = (size_t)(c & 0x7F) << 8;
+		p->state = SIRF_STATE_LEN_LO;
+		return SIRF_PENDING;
+
+	case SIRF_STATE_LEN_LO:
+		p->payload_len |= c;
+		p->len = 0;
+		p->chksum = 0;
+
+		if (p->payload_len == 0 || p->payload_len > SIRF_MAX_PAYLOAD) {
+			p->state = SIRF_STATE_START_1;
+			return SIRF_ERR_FORMAT;
+		}
+
+		if (p->payload_len > p->size) {
+			p->state = SIRF_STATE_START_1;
+			return SIRF_ERR_OVERFLOW;
+		}
+
+		p->state = SIRF_STATE_PAYLOAD;
+		return SIRF_PENDING;
+
+	case SIRF_STATE_PAYLOAD:
+		p->buf[p->len++] = c;
+		p->chksum = (p->chksum + c) & 0x7FFF;
+
+		if (p->len == p->payload_len)
+			p->state = SIRF_STATE_CHKSUM_HI;
+		return SIRF_PENDING;
+
+	case SIRF_STATE_CHKSUM_HI:
+		p->rx_chksum = (uint16_t)c << 8;
+		p->state = SIRF_STATE_CHKSUM_LO;
+		return SIRF_PENDING;
+
+	case SIRF_STATE_CHKSUM_LO:
+		p->rx_chksum |= c;
+		p->state = SIRF_STATE_END_1;
+		return SIRF_PENDING;
+
+	case SIRF_STATE_END_1:
+		if (c != SIRF_END_1) {
+			p->state = SIRF_STATE_START_1;
+			return SIRF_ERR_FORMAT;
+		}
+
+		p->state = SIRF_STATE_END_2;
+		return SIRF_PENDING;
+
+	case SIRF_STATE_END_2:
+		p->state = SIRF_STATE_START_1;
+
+		if (c != SIRF_END_2)
+			return SIRF_ERR_FORMAT;
+
+		if (p->rx_chksum != p->chksum)
+			return SIRF_ERR_CHKSUM;
+
+		return SIRF_FRAME;
+	}
+
+	p->state = SIRF_STATE_START_1;
+
+	return SIRF_ERR_FORMAT;
+}
+
+/*
+ * Wraps payload into a frame, frame must hold len + SIRF_FRAME_OVERHEAD
+ * bytes. Returns the frame length.
+ */
+size_t sirf_frame(const uint8_t *payload, size_t len, uint8_t *frame) {
+	uint16_t chksum = 0;
+	size_t i;
+
+	frame[0] = SIRF_START_1;
+	frame[1] = SIRF_START_2;
+	frame[2] = (len >> 8) & 0x7F;
+	frame[3] = len & 0xFF;
+
+	for (i = 0; i < len; i++) {
+		frame[4 + i] = payload[i];
+		chksum = (chksum + payload[i]) & 0x7FFF;
+	}
+
+	frame[4 + len] = chksum >> 8;
+	frame[5 + len] = chksum & 0xFF;
+	frame[6 + len] = SIRF_END_1;
+	frame[7 + len] = SIRF_END_2;
+
+	return len + SIRF_FRAME_OVERHEAD;
+}
+
+static uint16_t get_u16(const uint8_t *buf) {
+	return ((uint16_t)buf[0] << 8) | buf[1];
+}
+
+static uint32_t get_u32(const uint8_t *buf) {
+	return ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) |
+			((uint32_t)buf[2] << 8) | buf[3];
+}
+
+/*
+ * 1e-7 degree units to whole degrees and 1/10000 minute units.
+ */
+static void put_coord(int32_t value, uint8_t *degrees, uint32_t *minutes) {
+	uint32_t abs_value = value < 0 ? -value : value;
+	uint32_t frac = abs_value % 10000000;
+
+	*degrees = abs_value / 10000000;
+
+	// frac * 60 * 10000 / 1e7 without overflowing 32 bits
+	*minutes = (frac * 6) / 100;
+}
+
+/*
+ * Fills the fix from Geodetic Navigation Data (MID 41). The message
+ * carries everything RMC and GGA give for an epoch, so the resulting fix
+ * is complete on its own.
+ */
+uint8_t sirf_parse_geodetic(const uint8_t *payload, size_t len, gps_fix_t *fix) {
+	gps_rmc_state_t *nav = &fix->nav;
+	uint8_t nav_type;
+	int32_t latitude, longitude;
+	uint16_t millis;
+
+	if (len < GEO_PAYLOAD_LEN || payload[0] != SIRF_MID_GEODETIC_NAV)
+		return SIRF_ERR_FORMAT;
+
+	nav_type = payload[GEO_NAV_TYPE_OFFSET + 1];
+
+	nav->flags = 0;
+
+	if (get_u16(payload + GEO_NAV_VALID_OFFSET) != 0 || (nav_type & GEO_NAV_TYPE_MASK) == 0)
+		nav->flags |= GPS_DATA_INVALID;
+
+	nav->year = get_u16(payload + GEO_UTC_YEAR_OFFSET) % 100;
+	nav->month = payload[GEO_UTC_MONTH_OFFSET];
+	nav->day = payload[GEO_UTC_DAY_OFFSET];
+	nav->hour = payload[GEO_UTC_HOUR_OFFSET];
+	nav->minute = payload[GEO_UTC_MINUTE_OFFSET];
+
+	millis = get_u16(payload + GEO_UTC_SECOND_OFFSET);
+	nav->second = millis / 1000;
+
+	latitude = (int32_t)get_u32(payload + GEO_LATITUDE_OFFSET);
+	longitude = (int32_t)get_u32(payload + GEO_LONGITUDE_OFFSET);
+
+	put_coord(latitude, &nav->latitude_degrees, &nav->latitude_seconds);
+	put_coord(longitude, &nav->longitude_degrees, &nav->longitude_seconds);
+
+	nav->flags |= latitude < 0 ? LATITUDE_S : LATITUDE_N;
+	nav->flags |= longitude < 0 ? LONGITUDE_W : LONGITUDE_E;
+
+	// m/s * 100 to knots * 100
+	nav->speed = ((uint32_t)get_u16(payload + GEO_SPEED_OFFSET) * 19438 + 5000) / 10000;
+	nav->course = get_u16(payload + GEO_COURSE_OFFSET);
+
+	fix->epoch = (uint32_t)nav->hour * 3600 + nav->minute * 60 + nav->second;
+
+	// cm to 1/10 m
+	fix->altitude = (int32_t)get_u32(payload + GEO_ALTITUDE_MSL_OFFSET) / 10;
+
+	fix->satellites_used = payload[GEO_SATELLITES_OFFSET];
+
+	// HDOP is sent in 0.2 units
+	fix->hdop = payload[GEO_HDOP_OFFSET] * 20;
+	fix->pdop = fix->vdop = 0;
+	fix->satellites_in_view = 0;
+
+	switch (nav_type & GEO_NAV_TYPE_MASK) {
+	case 0:
+		fix->mode = GPS_FIX_MODE_NONE;
+		break;
+	case 4:
+	case 6:
+		fix->mode = GPS_FIX_MODE_3D;
+		break;
+	default:
+		fix->mode = GPS_FIX_MODE_2D;
+		break;
+	}
+
+	if ((nav_type & GEO_NAV_TYPE_MASK) == 0) {
+		fix->quality = 0;
+	} else {
+		fix->quality = (nav_type & GEO_NAV_TYPE_DGPS) ? 2 : 1;
+	}
+
+	fix->sentences = GPS_FIX_SENTENCE(GPS_MESSAGE_GPRMC) | GPS_FIX_SENTENCE(GPS_MESSAGE_GPGGA);
+
+	return SIRF_FRAME;
+}
@@ -0,0 +1,81 @@
+/*
+ * sirf.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef SIRF_H_
+#define SIRF_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "gps_fix.h"
+
+#define SIRF_START_1			0xA0
+#define SIRF_START_2			0xA2
+#define SIRF_END_1				0xB0
+#define SIRF_END_2				0xB3
+
+// Start, length, checksum and end sequence around the payload
+#define SIRF_FRAME_OVERHEAD		8
+
+#define SIRF_MAX_PAYLOAD		1023
+
+typedef enum SIRF_MID {
+	SIRF_MID_MEASURED_NAV		=	2,
+	SIRF_MID_MEASURED_TRACKER	=	4,
+	SIRF_MID_CLOCK_STATUS		=	7,
+	SIRF_MID_CPU_THROUGHPUT		=	9,
+	SIRF_MID_GEODETIC_NAV		=	41,
+	SIRF_MID_SWITCH_TO_NMEA		=	129,
+	SIRF_MID_SET_MSG_RATE		=	166
+} SIRF_MID;
+
+typedef enum SIRF_RESULT {
+	SIRF_PENDING			=	0x00,
+	SIRF_FRAME				=	0x01,
+	SIRF_ERR_CHKSUM			=	0x02,
+	SIRF_ERR_OVERFLOW		=	0x03,
+	SIRF_ERR_FORMAT			=	0x04
+} SIRF_RESULT;
+
+typedef enum SIRF_PARSER_STATE {
+	SIRF_STATE_START_1		=	0x00,
+	SIRF_STATE_START_2		=	0x01,
+	SIRF_STATE_LEN_HI		=	0x02,
+	SIRF_STATE_LEN_LO		=	0x03,
+	SIRF_STATE_PAYLOAD		=	0x04,
+	SIRF_STATE_CHKSUM_HI	=	0x05,
+	SIRF_STATE_CHKSUM_LO	=	0x06,
+	SIRF_STATE_END_1		=	0x07,
+	SIRF_STATE_END_2		=	0x08
+} SIRF_PARSER_STATE;
+
+/*
+ * Incremental SiRF binary frame parser, same model as nmea_parser_t:
+ * the payload is collected into buf and its 15-bit checksum is summed
+ * while the bytes arrive.
+ */
+typedef struct sirf_parser {
+	uint8_t *buf;
+	size_t size;
+	size_t len;
+	size_t payload_len;
+
+	uint8_t state;
+	uint16_t chksum;
+	uint16_t rx_chksum;
+} sirf_parser_t;
+
+extern void sirf_init(sirf_parser_t *p, uint8_t *buf, size_t size);
+
+extern void sirf_reset(sirf_parser_t *p);
+
+extern uint8_t sirf_put(sirf_parser_t *p, uint8_t c);
+
+extern size_t sirf_frame(const uint8_t *payload, size_t len, uint8_t *frame);
+
+extern uint8_t sirf_parse_geodetic(const uint8_t *payload, size_t len, gps_fix_t *fix);
+
+#endif /* SIRF_H_ */
@@ -0,0 +1,321 @@
+/*
+ * bench_geofence.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Geofence evaluation cost for 1, 100 and 1000 fences, half circles and
+ * half polygons of 100 m to 2 km, 100 of them per 40 x 40 km. A vehicle
+ * drives a random walk through them at 15 m/s, one fix per second. The
+ * fences the grid finds are checked against testing every fence for each
+ * fix, and the fences tested per fix must not grow with the fence count.
+ * Usage: bench_geofence [-n fixes]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "geofence.h"
+#include "check.h"
+
+#define DEFAULT_FIXES		200000
+#define MAX_VERTICES		24
+
+// Area of the fences, microdegrees
+#define AREA_LATITUDE		55750000
+#define AREA_LONGITUDE		37620000
+
+// Side of the area of 100 fences, it grows with the count at the same density
+#define AREA_SIZE_M			40000.0
+#define AREA_FENCES			100
+
+// Fences tested per fix may differ this much between the counts
+#define TESTS_SPREAD		1.5
+
+#define UDEG_PER_M			8.99321
+
+static uint32_t rng_state = 0x2545F491;
+
+static uint32_t rng(void) {
+	rng_state = rng_state * 1664525 + 1013904223;
+
+	return rng_state;
+}
+
+static double rng_unit(void) {
+	return rng() / 4294967296.0;
+}
+
+static double now_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Point the given meters north and east of the area corner
+static void area_point(double north_m, double east_m, geo_point_t *p) {
+	p->latitude = AREA_LATITUDE + (int32_t)(north_m * UDEG_PER_M);
+	p->longitude = AREA_LONGITUDE + (int32_t)(east_m * UDEG_PER_M / cos(AREA_LATITUDE / 1e6 * M_PI / 180.0));
+}
+
+// Star shaped polygons and circles, vertices holds MAX_VERTICES per fence
+static void make_fences(geofence_def_t *defs, geo_point_t *vertices, uint16_t count, double size_m) {
+	double north, east, radius, angle, r;
+	uint16_t i, j;
+
+	for (i = 0; i < count; i++) {
+		north = rng_unit() * size_m;
+		east = rng_unit() * size_m;
+		radius = 100 + rng_unit() * 1900;
+
+		memset(&defs[i], 0, sizeof(defs[i]));
+		defs[i].id = 1000 + i;
+
+		if (i % 2 == 0) {
+			defs[i].type = GEOFENCE_CIRCLE;
+			area_point(north, east, &defs[i].center);
+			defs[i].radius_m = (uint32_t)radius;
+			continue;
+		}
+
+		defs[i].type = GEOFENCE_POLYGON;
+		defs[i].vertices = vertices + (size_t)i * MAX_VERTICES;
+		defs[i].vertex_count = 6 + rng() % (MAX_VERTICES - 5);
+
+		for (j = 0; j < defs[i].vertex_count; j++) {
+			angle = 2 * M_PI * j / defs[i].vertex_count;
+			r = radius * (0.4 + 0.6 * rng_unit());
+			area_point(north + r * cos(angle), east + r * sin(angle), &vertices[(size_t)i * MAX_VERTICES + j]);
+		}
+	}
+}
+
+// Random walk through the area, bounces off its edges
+static void make_track(geo_point_t *track, size_t count, double size_m) {
+	double north = size_m / 2, east = size_m / 2, heading = 0;
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		heading += (rng_unit() - 0.5) * 0.3;
+		north += 15 * cos(heading);
+		east += 15 * sin(heading);
+
+		if (north < 0 || north > size_m || east < 0 || east > size_m) {
+			heading += M_PI;
+			north = fmin(fmax(north, 0), size_m);
+			east = fmin(fmax(east, 0), size_m);
+		}
+
+		area_point(north, east, &track[i]);
+	}
+}
+
+/*
+ * Events must match the fences entered and left by testing all of them,
+ * as long as no more than GEOFENCE_MAX_INSIDE are entered at a time.
+ */
+static void check_against_all(const uint8_t *image, size_t len, uint16_t count, const geo_point_t *track, size_t fixes) {
+	geofence_t gf;
+	geofence_event_t events[2 * GEOFENCE_MAX_INSIDE];
+	uint8_t *inside = calloc(count, 1), now;
+	size_t i, enters = 0, exits = 0, expected_enters = 0, expected_exits = 0;
+	uint16_t j;
+	uint8_t n, k;
+
+	CHECK(geofence_open(&gf, image, len) == GEOFENCE_OK);
+
+	for (i = 0; i < fixes; i++) {
+		n = geofence_check(&gf, &track[i], events, sizeof(events) / sizeof(events[0]));
+
+		for (k = 0; k < n; k++) {
+			if (events[k].type == GEOFENCE_ENTER)
+				enters++;
+			else
+				exits++;
+		}
+
+		for (j = 0; j < count; j++) {
+			now = geofence_contains(&gf, j, &track[i]);
+
+			if (now && !inside[j])
+				expected_enters++;
+			else if (!now && inside[j])
+				expected_exits++;
+
+			inside[j] = now;
+		}
+	}
+
+	if (gf.stats.overflows == 0) {
+		CHECK(enters == expected_enters);
+		CHECK(exits == expected_exits);
+	}
+
+	printf("  %u enter and %u exit events, %u overflows\n", (unsigned)enters, (unsigned)exits,
+			(unsigned)gf.stats.overflows);
+
+	free(inside);
+}
+
+/*
+ * Returns the fences tested per fix, 0 when the image could not be built.
+ */
+static double bench(uint16_t count, size_t fixes) {
+	// Images are read in place and must be 4 byte aligned
+	static uint32_t image_words[1 << 18];
+	uint8_t *image = (uint8_t *)image_words;
+	geofence_def_t *defs = calloc(count, sizeof(*defs));
+	geo_point_t *vertices = calloc((size_t)count * MAX_VERTICES, sizeof(*vertices));
+	geo_point_t *track = malloc(fixes * sizeof(*track));
+	geofence_event_t events[2 * GEOFENCE_MAX_INSIDE];
+	geofence_t gf;
+	volatile uint32_t sink = 0;
+	size_t len, i;
+	uint16_t j;
+	double start, ns, brute_ns, tests = 0, size_m = AREA_SIZE_M * sqrt((double)count / AREA_FENCES);
+
+	make_fences(defs, vertices, count, size_m);
+	make_track(track, fixes, size_m);
+
+	len = geofence_build(defs, count, image, sizeof(image_words));
+	CHECK(len > 0);
+
+	if (len == 0)
+		goto done;
+
+	CHECK(geofence_open(&gf, image, len) == GEOFENCE_OK);
+
+	printf("%u fences over %.0f km: image %u bytes (%.1f per fence), grid %u x %u, %u cell entries, at most %u per cell\n",
+			count, size_m / 1000, (unsigned)len, (double)len / count, gf.header->cols, gf.header->rows,
+			(unsigned)gf.header->list_count, gf.header->cell_max);
+
+	start = now_ns();
+
+	for (i = 0; i < fixes; i++)
+		sink += geofence_check(&gf, &track[i], events, sizeof(events) / sizeof(events[0]));
+
+	ns = (now_ns() - start) / fixes;
+
+	// The same fixes testing every fence
+	start = now_ns();
+
+	for (i = 0; i < fixes / 10; i++) {
+		for (j = 0; j < count; j++)
+			sink += geofence_contains(&gf, j, &track[i]);
+	}
+
+	brute_ns = (now_ns() - start) / (fixes / 10);
+
+	tests = (double)gf.stats.tests / gf.stats.fixes;
+
+	printf("  grid %7.1f ns/fix, %.2f fence tests/fix; all fences %9.1f ns/fix\n", ns, tests, brute_ns);
+
+	check_against_all(image, len, count, track, fixes / 10);
+
+done:
+	free(defs);
+	free(vertices);
+	free(track);
+
+	return tests;
+}
+
+static void test_shapes(void) {
+	static uint32_t image_words[1024];
+	uint8_t *image = (uint8_t *)image_words;
+	geo_point_t square[4], notch[6], p;
+	geofence_def_t defs[3];
+	geofence_event_t events[4];
+	geofence_t gf;
+	size_t len;
+
+	// 1 km square, an L shape beside it and a 500 m circle on the square corner
+	area_point(0, 0, &square[0]);
+	area_point(1000, 0, &square[1]);
+	area_point(1000, 1000, &square[2]);
+	area_point(0, 1000, &square[3]);
+
+	area_point(0, 2000, &notch[0]);
+	area_point(1000, 2000, &notch[1]);
+	area_point(1000, 2500, &notch[2]);
+	area_point(500, 2500, &notch[3]);
+	area_point(500, 3000, &notch[4]);
+	area_point(0, 3000, &notch[5]);
+
+	memset(defs, 0, sizeof(defs));
+	defs[0].id = 1; defs[0].type = GEOFENCE_POLYGON; defs[0].vertices = square; defs[0].vertex_count = 4;
+	defs[1].id = 2; defs[1].type = GEOFENCE_POLYGON; defs[1].vertices = notch; defs[1].vertex_count = 6;
+	defs[2].id = 3; defs[2].type = GEOFENCE_CIRCLE; defs[2].center = square[2]; defs[2].radius_m = 500;
+
+	len = geofence_build(defs, 3, image, sizeof(image_words));
+	CHECK(len > 0 && geofence_open(&gf, image, len) == GEOFENCE_OK);
+
+	area_point(500, 500, &p);
+	CHECK(geofence_check(&gf, &p, events, 4) == 1 && events[0].id == 1 && events[0].type == GEOFENCE_ENTER);
+
+	// Same place, no new events
+	CHECK(geofence_check(&gf, &p, events, 4) == 0);
+
+	// Corner: still in the square, into the circle
+	area_point(900, 900, &p);
+	CHECK(geofence_check(&gf, &p, events, 4) == 1 && events[0].id == 3 && events[0].type == GEOFENCE_ENTER);
+
+	// Out of both, exits only
+	area_point(1600, 1000, &p);
+	CHECK(geofence_check(&gf, &p, events, 4) == 2 && events[0].type == GEOFENCE_EXIT &&
+			events[1].type == GEOFENCE_EXIT);
+
+	// The notch of the L is outside, its arm inside
+	area_point(750, 2750, &p);
+	CHECK(geofence_check(&gf, &p, events, 4) == 0);
+	area_point(250, 2750, &p);
+	CHECK(geofence_check(&gf, &p, events, 4) == 1 && events[0].id == 2);
+
+	// Far outside the grid
+	p.latitude = -AREA_LATITUDE;
+	CHECK(geofence_check(&gf, &p, events, 4) == 1 && events[0].type == GEOFENCE_EXIT);
+
+	// Broken images
+	CHECK(geofence_open(&gf, image, len - 1) == GEOFENCE_ERR_SIZE);
+	image[0] = 'X';
+	CHECK(geofence_open(&gf, image, len) == GEOFENCE_ERR_FORMAT);
+	CHECK(geofence_check(&gf, &p, events, 4) == 0);
+
+	defs[1].vertex_count = 2;
+	CHECK(geofence_build(defs, 3, image, sizeof(image_words)) == 0);
+	CHECK(geofence_build(defs, 1, image, 16) == 0);
+}
+
+int main(int argc, char **argv) {
+	static const uint16_t counts[] = {1, 100, 1000};
+	double tests[sizeof(counts) / sizeof(counts[0])];
+	size_t fixes = DEFAULT_FIXES;
+	unsigned i;
+
+	if (argc > 2 && strcmp(argv[1], "-n") == 0)
+		fixes = strtoul(argv[2], NULL, 10);
+
+	test_shapes();
+
+	for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+		tests[i] = bench(counts[i], fixes);
+
+	// Flat from 1 to 1000 fences at the same density, counts[1] is AREA_FENCES
+	for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+		CHECK(tests[i] <= tests[1] * TESTS_SPREAD);
+
+	CHECK(tests[2] * TESTS_SPREAD >= tests[1]);
+
+	if (failures) {
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+
+	printf("OK\n");
+
+	return 0;
+}
@@ -0,0 +1,212 @@
+/*
+ * bench_nmea.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Throughput of the NMEA receive path, same calls gps_read_msg() and
+ * gps_process_msg() make per sentence. Each stage is timed separately:
+ *   tokenize - nmea_put() for every byte, checksum included
+ *   index    - tokenize + nmea_index() + nmea_message_type()
+ *   parse    - index + nmea_sentence_epoch() + nmea_parse()
+ * Usage: bench_nmea [-n sentences] [track.nmea ...], without files a
+ * synthetic track plus a few receiver captures are used.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "nmea.h"
+#include "track.h"
+
+#define DEFAULT_SENTENCES	2000000
+
+// Receive buffer of the firmware, see GPS_CMD_BUF in gps.c
+#define NMEA_BUF_SIZE		256
+
+typedef enum BENCH_STAGE {
+	STAGE_TOKENIZE			=	0x00,
+	STAGE_INDEX				=	0x01,
+	STAGE_PARSE				=	0x02,
+	STAGE_COUNT				=	0x03
+} BENCH_STAGE;
+
+static const char *stage_names[STAGE_COUNT] = {"tokenize", "index", "parse"};
+
+// Sentences captured from SiRF III and MTK receivers, including the ones the tracker ignores
+static const char captured[] =
+		"$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n"
+		"$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0A\r\n"
+		"$GPGSV,3,1,11,10,63,137,17,07,61,098,15,05,59,290,20,08,54,157,30*70\r\n"
+		"$GPGSV,3,2,11,02,39,223,19,13,28,070,17,26,23,252,,04,14,186,14*79\r\n"
+		"$GPGSV,3,3,11,29,09,301,24,16,09,020,,36,,,*76\r\n"
+		"$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*43\r\n"
+		"$GPVTG,31.66,T,,M,0.02,N,0.04,K,A*09\r\n"
+		"$GPGLL,5321.6802,N,00630.3372,W,092750.000,A,A*4B\r\n"
+		"$GPZDA,092750.000,28,05,2011,,*52\r\n"
+		"$PSRF151,3,1485,147954.0,0x00000000*45\r\n";
+
+static double now_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * Runs the text through the given stage until at least target sentences
+ * are accepted. Returns the number of sentences, the checksum of the
+ * parsed values keeps the compiler from dropping the work.
+ */
+static size_t run_stage(uint8_t stage, const char *text, size_t len, size_t target, uint32_t *sink) {
+	static uint8_t buf[NMEA_BUF_SIZE];
+	nmea_parser_t parser;
+	nmea_sentence_t sentence;
+	gps_fix_t fix;
+	size_t i, pass, sentences = 0;
+	uint8_t type;
+
+	nmea_init(&parser, buf, sizeof(buf));
+	memset(&fix, 0, sizeof(fix));
+
+	while (sentences < target) {
+		pass = sentences;
+
+		for (i = 0; i < len; i++) {
+			if (nmea_put(&parser, (uint8_t)text[i]) != NMEA_SENTENCE)
+				continue;
+
+			sentences++;
+
+			if (stage == STAGE_TOKENIZE) {
+				*sink += parser.chksum;
+				continue;
+			}
+
+			nmea_index(&sentence, buf, parser.len);
+			type = nmea_message_type(&sentence);
+
+			if (stage == STAGE_INDEX) {
+				*sink += type + sentence.field_count;
+				continue;
+			}
+
+			*sink += nmea_sentence_epoch(&sentence, type);
+
+			if (nmea_parse(&sentence, type, &fix) == NMEA_SENTENCE)
+				*sink += fix.nav.latitude_seconds + fix.hdop;
+		}
+
+		// Nothing valid in the text
+		if (sentences == pass)
+			break;
+	}
+
+	return sentences;
+}
+
+static void bench(const char *name, const char *text, size_t len, size_t target) {
+	uint32_t sink = 0;
+	size_t sentences, bytes, per_pass;
+	uint8_t stage;
+	double start, ns;
+
+	// Target of one sentence is still a full pass over the text
+	per_pass = run_stage(STAGE_TOKENIZE, text, len, 1, &sink);
+
+	if (per_pass == 0) {
+		printf("%s: no sentences\n", name);
+		return;
+	}
+
+	printf("%s: %u valid sentences, %.1f bytes/sentence\n", name,
+			(unsigned)per_pass, (double)len / per_pass);
+
+	for (stage = 0; stage < STAGE_COUNT; stage++) {
+		// Warm up the caches and the branch predictor
+		run_stage(stage, text, len, per_pass, &sink);
+
+		start = now_ns();
+		sentences = run_stage(stage, text, len, target, &sink);
+		ns = now_ns() - start;
+
+		bytes = (sentences + per_pass - 1) / per_pass * len;
+
+		printf("  %-8s %9u sentences %8.1f ns/sentence %7.1f MB/s\n",
+				stage_names[stage], (unsigned)sentences, ns / sentences,
+				bytes / ns * 1e3);
+	}
+
+	if (sink == 0x5A5A5A5A)
+		printf("\n");
+}
+
+static char *read_file(const char *path, size_t *len) {
+	FILE *f = fopen(path, "rb");
+	char *text;
+	long size;
+
+	if (f == NULL)
+		return NULL;
+
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	text = malloc(size > 0 ? size : 1);
+
+	if (text != NULL)
+		*len = fread(text, 1, size, f);
+
+	fclose(f);
+
+	return text;
+}
+
+int main(int argc, char **argv) {
+	size_t target = DEFAULT_SENTENCES, len;
+	char *text;
+	int i = 1;
+
+	if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+		target = strtoul(argv[2], NULL, 10);
+		i = 3;
+	}
+
+	if (i < argc) {
+		for (; i < argc; i++) {
+			if ((text = read_file(argv[i], &len)) == NULL) {
+				fprintf(stderr, "cannot read %s\n", argv[i]);
+				return 1;
+			}
+
+			bench(argv[i], text, len, target);
+			free(text);
+		}
+
+	} else {
+		track_t t;
+		FILE *out;
+
+		track_init(&t);
+		text = NULL;
+		len = 0;
+
+		if ((out = open_memstream(&text, &len)) == NULL)
+			return 1;
+
+		t.nmea_out = out;
+		track_synthetic(&t, 1);
+		fclose(out);
+
+		bench("synthetic", text, len, target);
+		bench("captured", captured, sizeof(captured) - 1, target);
+
+		free(text);
+		track_free(&t);
+	}
+
+	return 0;
+}
@@ -0,0 +1,19 @@
+/*
+ * check.h
+ *
+ *  Created on: 16.10.2026
+ *
+ * Check macro of the host tests. A failed check is printed and counted,
+ * the test goes on and main() reports failures at the end.
+ */
+
+#ifndef CHECK_H_
+#define CHECK_H_
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(C) do { if (!(C)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #C); failures++; } } while (0)
+
+#endif /* CHECK_H_ */
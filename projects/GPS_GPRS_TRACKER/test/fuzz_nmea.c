@@ -0,0 +1,463 @@
+/*
+ * fuzz_nmea.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Fuzz target for everything that touches gps_data: the NMEA tokenizer,
+ * field index and parsers, and the SiRF binary framer. Buffers are
+ * allocated with their exact size so the sanitizers catch any write or
+ * read past them.
+ *
+ * fuzz_nmea_one() has the libFuzzer signature, build with
+ * -DFUZZ_LIBFUZZER -fsanitize=fuzzer to drive it from libFuzzer. The
+ * standalone build mutates a corpus of valid sentences itself:
+ *   fuzz_nmea [-n iterations] [-s seed]   - random run
+ *   fuzz_nmea crash-file ...              - replay inputs
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nmea.h"
+#include "sirf.h"
+#include "track.h"
+
+// Receive buffer of the firmware, see GPS_CMD_BUF in gps.c
+#define NMEA_BUF_SIZE		256
+// Small enough to overflow on every real sentence
+#define NMEA_SMALL_BUF_SIZE	16
+
+#define DEFAULT_ITERATIONS	200000
+#define MAX_INPUT			4096
+
+static void fail(const char *what) {
+	fprintf(stderr, "fuzz_nmea: %s\n", what);
+	abort();
+}
+
+#define ASSERT(C) do { if (!(C)) fail(#C); } while (0)
+
+/*
+ * Every accessor on every field, including the ones past the end.
+ */
+static void check_fields(const nmea_sentence_t *s, size_t len) {
+	uint8_t n, degrees, a, b, c;
+	uint32_t minutes;
+	volatile uint32_t sink = 0;
+
+	ASSERT(s->field_count >= 1 && s->field_count <= NMEA_MAX_FIELDS);
+
+	for (n = 0; n < s->field_count; n++)
+		ASSERT((size_t)s->fields[n].offset + s->fields[n].len <= len);
+
+	for (n = 0; n <= s->field_count; n++) {
+		sink += nmea_field_empty(s, n);
+		sink += nmea_field_char(s, n);
+		sink += nmea_field_uint(s, n);
+		sink += nmea_field_fixed(s, n, 0);
+		sink += nmea_field_fixed(s, n, 4);
+		sink += nmea_field_sfixed(s, n, 1);
+
+		if (nmea_field_coord(s, n, &degrees, &minutes) == NMEA_SENTENCE)
+			sink += degrees + minutes;
+
+		if (nmea_field_time(s, n, &a, &b, &c) == NMEA_SENTENCE)
+			sink += a + b + c;
+
+		if (nmea_field_date(s, n, &a, &b, &c) == NMEA_SENTENCE)
+			sink += a + b + c;
+	}
+}
+
+static void check_frame(const uint8_t *body, size_t len) {
+	uint8_t frame[NMEA_BUF_SIZE + NMEA_FRAME_OVERHEAD], buf[NMEA_BUF_SIZE];
+	nmea_parser_t p;
+	size_t i, frame_len = nmea_frame(body, len, frame);
+	uint8_t res = NMEA_PENDING;
+
+	ASSERT(frame_len == len + NMEA_FRAME_OVERHEAD);
+
+	nmea_init(&p, buf, sizeof(buf));
+
+	for (i = 0; i < frame_len && res == NMEA_PENDING; i++)
+		res = nmea_put(&p, frame[i]);
+
+	ASSERT(res == NMEA_SENTENCE);
+	ASSERT(p.len == len && memcmp(buf, body, len) == 0);
+}
+
+static void check_sentence(const uint8_t *buf, size_t len, size_t size) {
+	static gps_fix_t fix;
+	nmea_sentence_t s;
+	uint8_t type, forced;
+	size_t i;
+
+	ASSERT(len < size);
+	ASSERT(buf[len] == '\0');
+
+	for (i = 0; i < len; i++)
+		ASSERT(buf[i] != '$' && buf[i] != '*' && buf[i] != '\r' && buf[i] != '\n');
+
+	if (nmea_index(&s, buf, len) == NMEA_SENTENCE)
+		check_fields(&s, len);
+
+	type = nmea_message_type(&s);
+	nmea_sentence_epoch(&s, type);
+	nmea_parse(&s, type, &fix);
+
+	// Whatever was accepted goes through again after nmea_frame()
+	check_frame(buf, len);
+
+	// Parsers must cope with any body, not only with the matching talker
+	for (forced = GPS_MESSAGE_GPGGA; forced <= GPS_MESSAGE_GPZDA; forced++) {
+		nmea_sentence_epoch(&s, forced);
+		nmea_parse(&s, forced, &fix);
+	}
+}
+
+static void feed_nmea(const uint8_t *data, size_t size, size_t buf_size) {
+	uint8_t *buf = malloc(buf_size);
+	nmea_parser_t p;
+	uint8_t res, chksum;
+	size_t i, j;
+
+	nmea_init(&p, buf, buf_size);
+
+	for (i = 0; i < size; i++) {
+		res = nmea_put(&p, data[i]);
+
+		ASSERT(p.len < buf_size);
+
+		switch (res) {
+		case NMEA_SENTENCE:
+			// Accepted only with the checksum of what was collected
+			for (chksum = 0, j = 0; j < p.len; j++)
+				chksum ^= buf[j];
+			ASSERT(chksum == p.rx_chksum);
+
+			check_sentence(buf, p.len, buf_size);
+			break;
+		case NMEA_PENDING:
+		case NMEA_ERR_CHKSUM:
+		case NMEA_ERR_OVERFLOW:
+		case NMEA_ERR_FORMAT:
+			break;
+		default:
+			fail("unknown nmea_put() result");
+		}
+	}
+
+	free(buf);
+}
+
+static void feed_sirf(const uint8_t *data, size_t size, size_t buf_size) {
+	uint8_t *buf = malloc(buf_size);
+	sirf_parser_t p;
+	gps_fix_t fix;
+	size_t i;
+
+	sirf_init(&p, buf, buf_size);
+
+	for (i = 0; i < size; i++) {
+		if (sirf_put(&p, data[i]) != SIRF_FRAME)
+			continue;
+
+		ASSERT(p.len == p.payload_len && p.len <= buf_size);
+		sirf_parse_geodetic(buf, p.len, &fix);
+	}
+
+	free(buf);
+}
+
+int fuzz_nmea_one(const uint8_t *data, size_t size) {
+	feed_nmea(data, size, NMEA_BUF_SIZE);
+	feed_nmea(data, size, NMEA_SMALL_BUF_SIZE);
+	feed_sirf(data, size, NMEA_BUF_SIZE);
+
+	return 0;
+}
+
+#if defined(FUZZ_LIBFUZZER)
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+	return fuzz_nmea_one(data, size);
+}
+
+#else
+
+static unsigned long rng_state;
+
+static unsigned rng(void) {
+	rng_state = rng_state * 6364136223846793005ULL + 1442695040888963407ULL;
+
+	return (unsigned)(rng_state >> 33);
+}
+
+// Bytes the tokenizer and the field parsers make decisions on
+static const uint8_t interesting[] = {
+	'$', '*', ',', '.', '-', '\r', '\n', '0', '9', 'A', 'F', 'f', 'N', 'S', 'E', 'W',
+	0x00, 0x7F, 0x80, 0xFF, SIRF_START_1, SIRF_START_2, SIRF_END_1, SIRF_END_2
+};
+
+/*
+ * Truncates, corrupts, splices and grows the input in place.
+ * Returns the new length.
+ */
+static size_t mutate(uint8_t *data, size_t len, const uint8_t *other, size_t other_len) {
+	unsigned count = 1 + rng() % 8, k;
+	size_t pos, n;
+
+	for (k = 0; k < count; k++) {
+		pos = len ? rng() % len : 0;
+
+		switch (rng() % 9) {
+		case 0:
+			// Truncate
+			len = pos;
+			break;
+		case 1:
+			// Bit flip
+			if (len)
+				data[pos] ^= 1 << (rng() % 8);
+			break;
+		case 2:
+			// Interesting byte
+			if (len)
+				data[pos] = interesting[rng() % sizeof(interesting)];
+			break;
+		case 3:
+			// Random byte
+			if (len)
+				data[pos] = rng();
+			break;
+		case 4:
+			// Insert an interesting byte
+			if (len < MAX_INPUT) {
+				memmove(data + pos + 1, data + pos, len - pos);
+				data[pos] = interesting[rng() % sizeof(interesting)];
+				len++;
+			}
+			break;
+		case 5:
+			// Delete a run
+			n = rng() % 16;
+			if (pos + n > len)
+				n = len - pos;
+			memmove(data + pos, data + pos + n, len - pos - n);
+			len -= n;
+			break;
+		case 6:
+			// Duplicate a run, makes oversized sentences and fields
+			n = 1 + rng() % 300;
+			if (pos + n > len)
+				n = len - pos;
+			if (len + n <= MAX_INPUT) {
+				memmove(data + pos + n, data + pos, len - pos);
+				len += n;
+			}
+			break;
+		case 7:
+			// Splice another input
+			n = other_len - (other_len ? rng() % other_len : 0);
+			if (pos + n > MAX_INPUT)
+				n = MAX_INPUT - pos;
+			memcpy(data + pos, other + other_len - n, n);
+			if (pos + n > len)
+				len = pos + n;
+			break;
+		case 8:
+			// Long run of digits, overflows the numeric fields
+			n = rng() % 64;
+			if (pos + n > MAX_INPUT)
+				n = MAX_INPUT - pos;
+			memset(data + pos, '9', n);
+			if (pos + n > len)
+				len = pos + n;
+			break;
+		}
+	}
+
+	return len;
+}
+
+/*
+ * Rewrites the checksum of every $...*XX in the input, so the mutated
+ * bodies get past the tokenizer and reach the field parsers.
+ */
+static void fix_checksums(uint8_t *data, size_t len) {
+	static const char hex[] = "0123456789ABCDEF";
+	uint8_t chksum = 0, in_body = 0;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if (data[i] == '$') {
+			in_body = 1;
+			chksum = 0;
+		} else if (in_body && data[i] == '*') {
+			in_body = 0;
+
+			if (i + 2 < len) {
+				data[i + 1] = hex[chksum >> 4];
+				data[i + 2] = hex[chksum & 0x0F];
+			}
+		} else if (in_body) {
+			chksum ^= data[i];
+		}
+	}
+}
+
+/*
+ * Corpus of single sentences split from the synthetic track and from
+ * receiver captures, plus a SiRF geodetic frame.
+ */
+typedef struct corpus {
+	uint8_t *inputs[64];
+	size_t lens[64];
+	size_t count;
+} corpus_t;
+
+static void corpus_add(corpus_t *c, const uint8_t *data, size_t len) {
+	if (c->count == sizeof(c->inputs) / sizeof(c->inputs[0]) || len == 0)
+		return;
+
+	c->inputs[c->count] = malloc(len);
+	memcpy(c->inputs[c->count], data, len);
+	c->lens[c->count++] = len;
+}
+
+static void corpus_add_lines(corpus_t *c, const char *text, size_t len, size_t max) {
+	size_t start = 0, i, added = 0;
+
+	for (i = 0; i < len && added < max; i++) {
+		if (text[i] != '\n')
+			continue;
+
+		corpus_add(c, (const uint8_t *)text + start, i + 1 - start);
+		start = i + 1;
+		added++;
+	}
+}
+
+static void corpus_build(corpus_t *c) {
+	static const char captured[] =
+			"$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n"
+			"$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0A\r\n"
+			"$GPGSV,3,1,11,10,63,137,17,07,61,098,15,05,59,290,20,08,54,157,30*70\r\n"
+			"$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*43\r\n"
+			"$GPVTG,31.66,T,,M,0.02,N,0.04,K,A*09\r\n"
+			"$GPGLL,5321.6802,N,00630.3372,W,092750.000,A,A*4B\r\n"
+			"$GPZDA,092750.000,28,05,2011,,*52\r\n"
+			"$GPRMC,,V,,,,,,,,,,N*53\r\n"
+			"$GPGGA,,,,,,0,00,99.99,,,,,,*48\r\n"
+			"$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,-214748364.8,M,55.2,M,,*6E\r\n";
+	uint8_t payload[91], frame[sizeof(payload) + SIRF_FRAME_OVERHEAD];
+	track_t t;
+	FILE *out;
+	char *text = NULL;
+	size_t len = 0;
+
+	memset(c, 0, sizeof(*c));
+
+	corpus_add_lines(c, captured, sizeof(captured) - 1, ~(size_t)0);
+
+	track_init(&t);
+	if ((out = open_memstream(&text, &len)) != NULL) {
+		t.nmea_out = out;
+		track_synthetic(&t, 7);
+		fclose(out);
+
+		corpus_add_lines(c, text, len, 16);
+		free(text);
+	}
+	track_free(&t);
+
+	memset(payload, 0, sizeof(payload));
+	payload[0] = SIRF_MID_GEODETIC_NAV;
+	payload[4] = 4;
+	corpus_add(c, frame, sirf_frame(payload, sizeof(payload), frame));
+}
+
+static int replay_file(const char *path) {
+	static uint8_t data[1 << 20];
+	FILE *f = fopen(path, "rb");
+	size_t len;
+
+	if (f == NULL) {
+		fprintf(stderr, "cannot read %s\n", path);
+		return 1;
+	}
+
+	len = fread(data, 1, sizeof(data), f);
+	fclose(f);
+
+	fuzz_nmea_one(data, len);
+	printf("%s: ok\n", path);
+
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	static uint8_t input[MAX_INPUT];
+	unsigned long iterations = DEFAULT_ITERATIONS, i, bytes = 0;
+	corpus_t c;
+	size_t len, k, seed_index;
+	int arg;
+
+	rng_state = 1;
+
+	for (arg = 1; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+		if (strcmp(argv[arg], "-n") == 0)
+			iterations = strtoul(argv[arg + 1], NULL, 10);
+		else if (strcmp(argv[arg], "-s") == 0)
+			rng_state = strtoul(argv[arg + 1], NULL, 10);
+	}
+
+	if (arg < argc) {
+		for (; arg < argc; arg++)
+			if (replay_file(argv[arg]))
+				return 1;
+
+		return 0;
+	}
+
+	corpus_build(&c);
+
+	// The whole corpus back to back once, as the receiver would send it
+	for (k = 0, len = 0; k < c.count; k++) {
+		memcpy(input + len, c.inputs[k], c.lens[k]);
+		len += c.lens[k];
+	}
+	fuzz_nmea_one(input, len);
+
+	for (i = 0; i < iterations; i++) {
+		seed_index = rng() % c.count;
+		len = c.lens[seed_index];
+		memcpy(input, c.inputs[seed_index], len);
+
+		// Several sentences in a row keep the tokenizer state between them
+		while (rng() % 4 == 0 && len + c.lens[k = rng() % c.count] <= MAX_INPUT) {
+			memcpy(input + len, c.inputs[k], c.lens[k]);
+			len += c.lens[k];
+		}
+
+		k = rng() % c.count;
+		len = mutate(input, len, c.inputs[k], c.lens[k]);
+
+		if (rng() % 4 != 0)
+			fix_checksums(input, len);
+
+		fuzz_nmea_one(input, len);
+		bytes += len;
+	}
+
+	printf("fuzz_nmea: %lu inputs, %lu bytes, %u seeds, no failures\n",
+			iterations, bytes, (unsigned)c.count);
+
+	for (k = 0; k < c.count; k++)
+		free(c.inputs[k]);
+
+	return 0;
+}
+
+#endif
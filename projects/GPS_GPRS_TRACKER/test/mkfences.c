@@ -0,0 +1,132 @@
+/*
+ * mkfences.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Builds the geofence image the tracker reads from flash out of a text
+ * list of fences, one per line, coordinates in degrees:
+ *   <id> circle <latitude> <longitude> <radius m>
+ *   <id> polygon <latitude> <longitude> <latitude> <longitude> ...
+ * Blank lines and lines starting with # are skipped. The image goes to
+ * the flash region with "make program-fences" or to the simulator as its
+ * argument.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "geofence.h"
+
+#define MAX_FENCES			1000
+#define MAX_VERTICES		16000
+
+// Flash region of the image, see GPS_GPRS_TRACKER.ld
+#define IMAGE_SIZE			(16 * 1024)
+
+static geofence_def_t defs[MAX_FENCES];
+static geo_point_t vertices[MAX_VERTICES];
+static uint32_t image[IMAGE_SIZE / sizeof(uint32_t)];
+
+static int parse_point(char **save, geo_point_t *p) {
+	char *lat = strtok_r(NULL, " \t\r\n", save);
+	char *lon = strtok_r(NULL, " \t\r\n", save);
+
+	if (lat == NULL || lon == NULL)
+		return -1;
+
+	p->latitude = (int32_t)lround(atof(lat) * 1e6);
+	p->longitude = (int32_t)lround(atof(lon) * 1e6);
+
+	return 0;
+}
+
+static int parse_line(char *line, uint16_t *count, size_t *vertex_count) {
+	geofence_def_t *def = &defs[*count];
+	char *save, *id, *type, *radius;
+
+	if ((id = strtok_r(line, " \t\r\n", &save)) == NULL || id[0] == '#')
+		return 0;
+
+	if (*count >= MAX_FENCES || (type = strtok_r(NULL, " \t\r\n", &save)) == NULL)
+		return -1;
+
+	memset(def, 0, sizeof(*def));
+	def->id = (uint16_t)atoi(id);
+
+	if (strcmp(type, "circle") == 0) {
+		def->type = GEOFENCE_CIRCLE;
+
+		if (parse_point(&save, &def->center) != 0 || (radius = strtok_r(NULL, " \t\r\n", &save)) == NULL)
+			return -1;
+
+		def->radius_m = (uint32_t)atol(radius);
+	} else if (strcmp(type, "polygon") == 0) {
+		def->type = GEOFENCE_POLYGON;
+		def->vertices = vertices + *vertex_count;
+
+		while (*vertex_count < MAX_VERTICES && parse_point(&save, &vertices[*vertex_count]) == 0) {
+			(*vertex_count)++;
+			def->vertex_count++;
+		}
+
+		if (def->vertex_count < 3)
+			return -1;
+	} else {
+		return -1;
+	}
+
+	(*count)++;
+
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	char line[4096];
+	uint16_t count = 0;
+	size_t vertex_count = 0, size;
+	int line_no = 0;
+	FILE *in, *out;
+
+	if (argc != 3) {
+		fprintf(stderr, "usage: mkfences <fences.txt> <fences.bin>\n");
+		return 2;
+	}
+
+	if ((in = fopen(argv[1], "r")) == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	while (fgets(line, sizeof(line), in) != NULL) {
+		line_no++;
+
+		if (parse_line(line, &count, &vertex_count) != 0) {
+			fprintf(stderr, "%s:%d: bad fence\n", argv[1], line_no);
+			fclose(in);
+			return 1;
+		}
+	}
+
+	fclose(in);
+
+	if ((size = geofence_build(defs, count, (uint8_t *)image, sizeof(image))) == 0) {
+		fprintf(stderr, "%s: no fences or they do not fit %u bytes\n", argv[1], IMAGE_SIZE);
+		return 1;
+	}
+
+	if ((out = fopen(argv[2], "wb")) == NULL) {
+		perror(argv[2]);
+		return 1;
+	}
+
+	if (fwrite(image, 1, size, out) != size || fclose(out) != 0) {
+		perror(argv[2]);
+		return 1;
+	}
+
+	printf("%u fences, %zu bytes\n", count, size);
+
+	return 0;
+}
@@ -0,0 +1,175 @@
+/*
+ * test_atparse.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Line assembly, final result code and URC detection of the AT engine, fed
+ * with scripted modem transcripts.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "atparse.h"
+#include "check.h"
+
+/*
+ * Feeds the transcript the way at_cmd_response() does and returns the final
+ * result code, the first line starting with prefix is copied into resp.
+ * *consumed is the number of bytes read up to the final result code.
+ */
+static uint8_t run_script(const char *script, const char *prefix, char *resp, size_t size, size_t *consumed) {
+	at_line_t line;
+	uint8_t result;
+	size_t i;
+
+	at_line_init(&line);
+	resp[0] = '\0';
+
+	for (i = 0; script[i] != '\0'; i++) {
+		if (at_line_put(&line, (uint8_t)script[i]) != AT_LINE_COMPLETE)
+			continue;
+
+		result = at_result_code(&line);
+
+		if (result != AT_NOT_FINAL) {
+			*consumed = i + 1;
+			return result;
+		}
+
+		if (prefix != NULL && resp[0] == '\0' && at_line_starts_with(&line, prefix)) {
+			strncpy(resp, line.buf, size - 1);
+			resp[size - 1] = '\0';
+		}
+	}
+
+	*consumed = i;
+
+	return AT_TIMEOUT;
+}
+
+static void test_result_codes(void) {
+	char resp[32];
+	size_t used;
+
+	CHECK(run_script("\r\nOK\r\n", NULL, resp, sizeof(resp), &used) == AT_OK);
+	CHECK(run_script("\r\nERROR\r\n", NULL, resp, sizeof(resp), &used) == AT_ERROR);
+	CHECK(run_script("\r\n+CME ERROR: 3\r\n", NULL, resp, sizeof(resp), &used) == AT_CME_ERROR);
+	CHECK(run_script("\r\n+CMS ERROR: 500\r\n", NULL, resp, sizeof(resp), &used) == AT_CMS_ERROR);
+	CHECK(run_script("\r\nCONNECT\r\n", NULL, resp, sizeof(resp), &used) == AT_CONNECT);
+	CHECK(run_script("\r\nCONNECT 9600\r\n", NULL, resp, sizeof(resp), &used) == AT_CONNECT);
+	CHECK(run_script("\r\nNO CARRIER\r\n", NULL, resp, sizeof(resp), &used) == AT_NO_CARRIER);
+
+	// Lines that only look like result codes
+	CHECK(run_script("\r\nOKAY\r\n", NULL, resp, sizeof(resp), &used) == AT_TIMEOUT);
+	CHECK(run_script("\r\n+WIPREADY: 2,1\r\n", NULL, resp, sizeof(resp), &used) == AT_TIMEOUT);
+
+	// No answer at all
+	CHECK(run_script("", NULL, resp, sizeof(resp), &used) == AT_TIMEOUT);
+}
+
+static void test_responses(void) {
+	const char *csq = "\r\n+CSQ: 17,99\r\n\r\nOK\r\n";
+	char resp[32];
+	size_t used;
+
+	CHECK(run_script(csq, "+CSQ:", resp, sizeof(resp), &used) == AT_OK);
+	CHECK(strcmp(resp, "+CSQ: 17,99") == 0);
+	// The line is complete on CR, the trailing LF is skipped later as an empty line
+	CHECK(used == strlen(csq) - 1);
+
+	// Echo still on and an indication in between
+	CHECK(run_script("AT+CREG?\r\r\n+WIND: 4\r\n\r\n+CREG: 0,5\r\n\r\nOK\r\n", "+CREG:", resp, sizeof(resp), &used) == AT_OK);
+	CHECK(strcmp(resp, "+CREG: 0,5") == 0);
+
+	// Completes on the final code, the following indication stays unread
+	CHECK(run_script("\r\nOK\r\n\r\n+WIPREADY: 2,1\r\n", NULL, resp, sizeof(resp), &used) == AT_OK);
+	CHECK(used == strlen("\r\nOK\r"));
+
+	// Bare LF line endings
+	CHECK(run_script("+CSQ: 5,0\nOK\n", "+CSQ:", resp, sizeof(resp), &used) == AT_OK);
+	CHECK(strcmp(resp, "+CSQ: 5,0") == 0);
+}
+
+static void test_long_line(void) {
+	char script[AT_LINE_BUF * 2 + 16];
+	at_line_t line;
+	size_t i;
+
+	memset(script, 'A', AT_LINE_BUF * 2);
+	strcpy(script + AT_LINE_BUF * 2, "\r\nOK\r\n");
+
+	at_line_init(&line);
+
+	for (i = 0; i < AT_LINE_BUF * 2; i++)
+		CHECK(at_line_put(&line, (uint8_t)script[i]) == AT_LINE_PENDING);
+
+	CHECK(at_line_put(&line, '\r') == AT_LINE_COMPLETE);
+	CHECK(line.len == AT_LINE_BUF - 1);
+	CHECK(line.buf[line.len] == '\0');
+
+	// The next line starts clean
+	CHECK(at_line_put(&line, '\n') == AT_LINE_PENDING);
+	CHECK(at_line_put(&line, 'O') == AT_LINE_PENDING);
+	CHECK(at_line_put(&line, 'K') == AT_LINE_PENDING);
+	CHECK(at_line_put(&line, '\r') == AT_LINE_COMPLETE);
+	CHECK(at_result_code(&line) == AT_OK);
+}
+
+static void put_line(at_line_t *line, const char *text) {
+	at_line_init(line);
+
+	while (*text != '\0')
+		at_line_put(line, (uint8_t)*text++);
+
+	at_line_put(line, '\r');
+}
+
+static void test_urc(void) {
+	at_line_t line;
+
+	put_line(&line, "+WIPREADY: 2,1");
+	CHECK(at_urc_type(&line) == AT_URC_WIPREADY);
+	CHECK(at_line_param(&line, 0) == 2);
+	CHECK(at_line_param(&line, 1) == 1);
+	CHECK(at_line_param(&line, 2) == -1);
+
+	put_line(&line, "+WIPPEERCLOSE: 2,1");
+	CHECK(at_urc_type(&line) == AT_URC_WIPPEERCLOSE);
+
+	put_line(&line, "+CREG: 5,\"0A1B\",\"0C2D\"");
+	CHECK(at_urc_type(&line) == AT_URC_CREG);
+	CHECK(at_line_param(&line, 0) == 5);
+	CHECK(at_line_param(&line, 1) == -1);
+
+	put_line(&line, "+CGREG: 0");
+	CHECK(at_urc_type(&line) == AT_URC_CGREG);
+	CHECK(at_line_param(&line, 0) == 0);
+
+	put_line(&line, "RING");
+	CHECK(at_urc_type(&line) == AT_URC_RING);
+	CHECK(at_line_param(&line, 0) == -1);
+
+	put_line(&line, "+CSQ: 17,99");
+	CHECK(at_urc_type(&line) == AT_URC_NONE);
+	CHECK(at_result_code(&line) == AT_NOT_FINAL);
+
+	put_line(&line, "OK");
+	CHECK(at_urc_type(&line) == AT_URC_NONE);
+}
+
+int main(void) {
+	test_result_codes();
+	test_responses();
+	test_long_line();
+	test_urc();
+
+	if (failures) {
+		printf("%d failures\n", failures);
+		return 1;
+	}
+
+	printf("OK\n");
+
+	return 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * test_fixcodec.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Round trip and compression ratio of the uplink fix encoding.
+ * Usage: test_fixcodec [track.nmea ...], without arguments a synthetic
+ * track is used.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "fixcodec.h"
+#include "track.h"
+#include "check.h"
+
+// Packed size of the plain record: time, latitude, longitude, speed, course, flags
+#define RAW_RECORD_SIZE		17
+
+static int same_record(const fix_record_t *a, const fix_record_t *b) {
+	return a->time == b->time && a->latitude == b->latitude &&
+			a->longitude == b->longitude && a->speed == b->speed &&
+			a->course == b->course && a->invalid == b->invalid;
+}
+
+static void test_timestamp(void) {
+	gps_rmc_state_t nav;
+
+	memset(&nav, 0, sizeof(nav));
+
+	nav.day = 1; nav.month = 1; nav.year = 0;
+	CHECK(fix_codec_timestamp(&nav) == 0);
+
+	// 2012-03-01 00:00:00 UTC is 1330560000 unix, 946684800 is 2000-01-01
+	nav.day = 1; nav.month = 3; nav.year = 12;
+	CHECK(fix_codec_timestamp(&nav) == 1330560000u - 946684800u);
+
+	// 2026-10-16 12:34:56 UTC
+	nav.day = 16; nav.month = 10; nav.year = 26;
+	nav.hour = 12; nav.minute = 34; nav.second = 56;
+	CHECK(fix_codec_timestamp(&nav) == 1792154096u - 946684800u);
+}
+
+static void test_edge_cases(void) {
+	fix_codec_t enc, dec;
+	fix_record_t a = {1000, -3000000, -107999999, 0, 35990, 0}, b, out;
+	uint8_t buf[4 * FIX_CODEC_MAX_RECORD];
+	size_t n1, n2, n3, used;
+
+	fix_codec_init(&enc);
+	fix_codec_init(&dec);
+
+	n1 = fix_codec_encode(&enc, &a, buf);
+	CHECK(buf[0] & FIX_REC_KEY);
+
+	// Course wraps through north, one degree change
+	b = a;
+	b.time += 1;
+	b.course = 90;
+	n2 = fix_codec_encode(&enc, &b, buf + n1);
+	CHECK(!(buf[n1] & FIX_REC_KEY));
+	CHECK(n2 <= 3);
+
+	// Long gap forces a new key record
+	b.time += FIX_CODEC_MAX_STEP + 1;
+	b.invalid = 1;
+	n3 = fix_codec_encode(&enc, &b, buf + n1 + n2);
+	CHECK(buf[n1 + n2] & FIX_REC_KEY);
+
+	CHECK(fix_codec_decode(&dec, buf, n1 + n2 + n3, &out, &used) == FIX_CODEC_OK);
+	CHECK(used == n1 && same_record(&out, &a));
+
+	CHECK(fix_codec_decode(&dec, buf + n1, n2 + n3, &out, &used) == FIX_CODEC_OK);
+	CHECK(used == n2 && out.course == 90);
+
+	CHECK(fix_codec_decode(&dec, buf + n1 + n2, n3, &out, &used) == FIX_CODEC_OK);
+	CHECK(used == n3 && same_record(&out, &b));
+
+	// Truncated key record and delta record without a key
+	fix_codec_init(&dec);
+	CHECK(fix_codec_decode(&dec, buf, n1 - 1, &out, &used) == FIX_CODEC_ERR_SHORT);
+	CHECK(fix_codec_decode(&dec, buf + n1, n2, &out, &used) == FIX_CODEC_ERR_NO_KEY);
+}
+
+static void report_track(const char *name, const track_t *t) {
+	static uint8_t buf[FIX_CODEC_MAX_RECORD];
+	fix_codec_t enc, dec;
+	fix_record_t rec, out;
+	size_t i, n, used, encoded = 0, text = 0, max_record = 0;
+	char line[64];
+
+	fix_codec_init(&enc);
+	fix_codec_init(&dec);
+
+	for (i = 0; i < t->count; i++) {
+		fix_record_from_fix(&t->fixes[i], &rec);
+
+		n = fix_codec_encode(&enc, &rec, buf);
+		encoded += n;
+
+		if (n > max_record)
+			max_record = n;
+
+		CHECK(fix_codec_decode(&dec, buf, n, &out, &used) == FIX_CODEC_OK);
+		CHECK(used == n);
+		CHECK(same_record(&rec, &out));
+
+		// What the same report costs as a text line
+		text += snprintf(line, sizeof(line), "%u,%d,%d,%u,%u\n",
+				(unsigned)rec.time, (int)rec.latitude, (int)rec.longitude, rec.speed, rec.course);
+	}
+
+	if (t->count == 0) {
+		printf("%s: no fixes\n", name);
+		return;
+	}
+
+	printf("%s: %u fixes\n", name, (unsigned)t->count);
+	printf("  NMEA text     %8u bytes\n", (unsigned)t->nmea_bytes);
+	printf("  CSV report    %8u bytes  %6.2f B/fix\n", (unsigned)text, (double)text / t->count);
+	printf("  raw record    %8u bytes  %6.2f B/fix\n", (unsigned)(t->count * RAW_RECORD_SIZE), (double)RAW_RECORD_SIZE);
+	printf("  delta varint  %8u bytes  %6.2f B/fix, max %u\n", (unsigned)encoded, (double)encoded / t->count, (unsigned)max_record);
+	printf("  ratio vs CSV %.1f:1, vs raw %.1f:1, vs NMEA %.1f:1\n",
+			(double)text / encoded, (double)(t->count * RAW_RECORD_SIZE) / encoded,
+			(double)t->nmea_bytes / encoded);
+}
+
+int main(int argc, char **argv) {
+	track_t t;
+	int i;
+
+	test_timestamp();
+	test_edge_cases();
+
+	if (argc < 2) {
+		track_init(&t);
+		track_synthetic(&t, 1);
+		report_track("synthetic", &t);
+		track_free(&t);
+	}
+
+	for (i = 1; i < argc; i++) {
+		track_init(&t);
+
+		if (track_load_nmea(&t, argv[i]) != 0) {
+			printf("FAIL cannot read %s\n", argv[i]);
+			failures++;
+			continue;
+		}
+
+		report_track(argv[i], &t);
+		track_free(&t);
+	}
+
+	if (failures) {
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+
+	printf("OK\n");
+
+	return 0;
+}
@@ -0,0 +1,361 @@
+/*
+ * test_fixlog.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * EEPROM fix log on a RAM model of a 32 KB part: records come back as
+ * written, the head is found with a binary search from every position of
+ * the ring, torn pages lose only themselves, a failed write keeps its page
+ * and all pages wear evenly.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fixlog.h"
+#include "check.h"
+
+#define DEVICE_SIZE			32768
+#define DEVICE_PAGES		(DEVICE_SIZE / FIXLOG_PAGE_SIZE)
+
+static uint8_t mem[DEVICE_SIZE];
+static uint32_t writes[DEVICE_PAGES];
+static uint32_t reads;
+
+// Bytes of the next page write that reach the part, the rest is lost
+static int torn_at = -1;
+
+// Page writes that fail without reaching the part, as on an I2C NACK
+static int failing_writes = 0;
+
+static uint8_t dev_read(uint32_t address, uint8_t *buf, size_t len) {
+	if (address + len > DEVICE_SIZE)
+		return 1;
+
+	memcpy(buf, mem + address, len);
+	reads++;
+
+	return 0;
+}
+
+static uint8_t dev_write_page(uint32_t address, const uint8_t *buf) {
+	if (address % FIXLOG_PAGE_SIZE != 0 || address + FIXLOG_PAGE_SIZE > DEVICE_SIZE)
+		return 1;
+
+	if (failing_writes > 0) {
+		failing_writes--;
+		return 1;
+	}
+
+	writes[address / FIXLOG_PAGE_SIZE]++;
+
+	if (torn_at >= 0) {
+		memcpy(mem + address, buf, torn_at);
+		memset(mem + address + torn_at, 0x5A, FIXLOG_PAGE_SIZE - torn_at);
+		torn_at = -1;
+		return 1;
+	}
+
+	memcpy(mem + address, buf, FIXLOG_PAGE_SIZE);
+
+	return 0;
+}
+
+static const fixlog_device_t device = {
+	dev_read,
+	dev_write_page,
+	DEVICE_SIZE
+};
+
+static void device_erase(void) {
+	memset(mem, 0xFF, sizeof(mem));
+	memset(writes, 0, sizeof(writes));
+}
+
+// Fix n of a vehicle driving north-east at about 15 m/s
+static void make_record(uint32_t n, fix_record_t *rec) {
+	memset(rec, 0, sizeof(*rec));
+	rec->time = 832000000 + n;
+	rec->latitude = 33450000 + n * 5 + (n % 7);
+	rec->longitude = 22572000 + n * 8 - (n % 5);
+	rec->speed = 2900 + n % 40;
+	rec->course = 4500 + n % 100;
+}
+
+static uint8_t same_record(const fix_record_t *a, const fix_record_t *b) {
+	return a->time == b->time && a->latitude == b->latitude && a->longitude == b->longitude &&
+			a->speed == b->speed && a->course == b->course && a->invalid == b->invalid;
+}
+
+static unsigned log2_ceil(unsigned n) {
+	unsigned bits = 0;
+
+	while ((1u << bits) < n)
+		bits++;
+
+	return bits;
+}
+
+/*
+ * Reads the pages from the tail to the head and checks they hold the
+ * records first, first + 1, ... Returns the record count.
+ */
+static uint32_t check_records(fixlog_t *log, uint32_t first) {
+	fix_record_t recs[FIXLOG_PAGE_RECORDS], expected;
+	uint32_t seq, count = 0;
+	uint8_t n, i;
+
+	for (seq = log->tail; seq != log->seq; seq++) {
+		CHECK(fixlog_read(log, seq, recs, &n) == FIXLOG_OK);
+
+		for (i = 0; i < n; i++, count++) {
+			make_record(first + count, &expected);
+			CHECK(same_record(&recs[i], &expected));
+		}
+	}
+
+	CHECK(fixlog_read(log, log->seq, recs, &n) == FIXLOG_EMPTY);
+
+	return count;
+}
+
+static void test_round_trip(void) {
+	fixlog_t log, reopened;
+	fix_record_t rec;
+	uint32_t i, count;
+
+	device_erase();
+	CHECK(fixlog_open(&log, &device) == FIXLOG_OK);
+	CHECK(log.seq == 0 && log.tail == 0 && fixlog_pending(&log) == 0);
+	CHECK(log.stats.open_reads == 2);
+
+	for (i = 0; i < 1000; i++) {
+		make_record(i, &rec);
+		CHECK(fixlog_append(&log, &rec) == FIXLOG_OK);
+	}
+
+	CHECK(fixlog_sync(&log) == FIXLOG_OK);
+	CHECK(fixlog_sync(&log) == FIXLOG_OK);
+
+	printf("1000 records in %lu pages, %.1f per page\n", (unsigned long)log.seq, 1000.0 / log.seq);
+
+	CHECK(fixlog_open(&reopened, &device) == FIXLOG_OK);
+	CHECK(reopened.seq == log.seq && reopened.tail == 0);
+
+	count = check_records(&reopened, 0);
+	CHECK(count == 1000);
+
+	// Acknowledged pages stay sent once the next page is written
+	fixlog_ack(&reopened, reopened.seq - 2);
+	make_record(count, &rec);
+	fixlog_append(&reopened, &rec);
+	CHECK(fixlog_sync(&reopened) == FIXLOG_OK);
+
+	CHECK(fixlog_open(&log, &device) == FIXLOG_OK);
+	CHECK(log.tail == reopened.seq - 3 && fixlog_pending(&log) == 3);
+
+	// Acknowledging beyond the head is ignored
+	fixlog_ack(&log, log.seq + 5);
+	CHECK(log.tail == reopened.seq - 3);
+}
+
+/*
+ * Four laps of the ring one page at a time, reopened after each page:
+ * the head must be found in log2(pages) reads plus the first page.
+ */
+static void test_recovery(void) {
+	fixlog_t log, reopened;
+	fix_record_t rec;
+	uint32_t n = 0, page, max_reads = 0, min_writes = 0xFFFFFFFF, max_writes = 0;
+
+	device_erase();
+	fixlog_open(&log, &device);
+
+	for (page = 0; page < 4 * DEVICE_PAGES + 17; page++) {
+		make_record(n++, &rec);
+		fixlog_append(&log, &rec);
+		make_record(n++, &rec);
+		fixlog_append(&log, &rec);
+
+		CHECK(fixlog_sync(&log) == FIXLOG_OK);
+
+		reads = 0;
+		CHECK(fixlog_open(&reopened, &device) == FIXLOG_OK);
+		CHECK(reopened.seq == log.seq && reopened.head == log.head);
+
+		if (reads > max_reads)
+			max_reads = reads;
+
+		fixlog_ack(&log, log.seq);
+	}
+
+	CHECK(max_reads <= 1 + log2_ceil(DEVICE_PAGES));
+
+	// Nothing acknowledged on the device but the pages before the last one
+	CHECK(fixlog_pending(&reopened) == 1);
+
+	for (page = 0; page < DEVICE_PAGES; page++) {
+		if (writes[page] < min_writes)
+			min_writes = writes[page];
+		if (writes[page] > max_writes)
+			max_writes = writes[page];
+	}
+
+	CHECK(max_writes - min_writes <= 1);
+
+	printf("%u pages: head found in %lu reads at most, page writes %lu to %lu\n", DEVICE_PAGES,
+			(unsigned long)max_reads, (unsigned long)min_writes, (unsigned long)max_writes);
+}
+
+static void test_torn_pages(void) {
+	fixlog_t log, reopened;
+	fix_record_t rec, recs[FIXLOG_PAGE_RECORDS];
+	uint32_t i, seq;
+	uint8_t n;
+
+	device_erase();
+	fixlog_open(&log, &device);
+
+	for (i = 0; i < 40; i++) {
+		make_record(i, &rec);
+		fixlog_append(&log, &rec);
+	}
+
+	fixlog_sync(&log);
+	seq = log.seq;
+
+	// Power lost during a write: the page being written is gone, only that one
+	make_record(i++, &rec);
+	fixlog_append(&log, &rec);
+	torn_at = 7;
+	CHECK(fixlog_sync(&log) == FIXLOG_ERR_IO);
+	CHECK(log.stats.io_errors == 1);
+
+	CHECK(fixlog_open(&reopened, &device) == FIXLOG_OK);
+	CHECK(reopened.seq == seq);
+	CHECK(check_records(&reopened, 0) == 40);
+
+	// The page is kept and goes out with the next write
+	CHECK(fixlog_sync(&log) == FIXLOG_OK && log.seq == seq + 1);
+
+	// Torn page 0 at the start of a lap: the previous lap ends at the last page
+	device_erase();
+	fixlog_open(&log, &device);
+
+	for (i = 0; log.seq < DEVICE_PAGES; i++) {
+		make_record(i, &rec);
+		fixlog_append(&log, &rec);
+	}
+
+	make_record(i, &rec);
+	fixlog_append(&log, &rec);
+	fixlog_ack(&log, log.seq);
+	torn_at = FIXLOG_HEADER_SIZE - 1;
+	CHECK(fixlog_sync(&log) == FIXLOG_ERR_IO);
+
+	CHECK(fixlog_open(&reopened, &device) == FIXLOG_OK);
+	CHECK(reopened.seq == DEVICE_PAGES && reopened.head == 0);
+
+	// A damaged record keeps the ones before it
+	mem[(DEVICE_PAGES - 1) * FIXLOG_PAGE_SIZE + FIXLOG_HEADER_SIZE + 20] ^= 0x10;
+	reopened.tail = DEVICE_PAGES - 1;
+	CHECK(fixlog_read(&reopened, DEVICE_PAGES - 1, recs, &n) == FIXLOG_ERR_CRC);
+	CHECK(n > 0 && n < 5 && reopened.stats.crc_errors == 1);
+}
+
+static void test_write_failure(void) {
+	fixlog_t log;
+	fix_record_t rec, recs[FIXLOG_PAGE_RECORDS], expected;
+	uint32_t i;
+	uint8_t n, j, page_count;
+
+	device_erase();
+	fixlog_open(&log, &device);
+
+	// Fill the first page, the record after it needs a write
+	for (i = 0; log.seq == 0; i++) {
+		make_record(i, &rec);
+
+		if (log.page_len + FIXLOG_RECORD_OVERHEAD + FIX_CODEC_MAX_RECORD > FIXLOG_PAGE_SIZE)
+			failing_writes = 2;
+
+		if (fixlog_append(&log, &rec) != FIXLOG_OK)
+			break;
+	}
+
+	// Nothing written, the page is kept whole and the record not logged
+	CHECK(log.seq == 0 && log.stats.io_errors == 1);
+	page_count = log.page_count;
+	CHECK(page_count == i);
+
+	CHECK(fixlog_read_page(&log, recs, &n) == FIXLOG_OK);
+	CHECK(n == page_count);
+
+	for (j = 0; j < n; j++) {
+		make_record(j, &expected);
+		CHECK(same_record(&recs[j], &expected));
+	}
+
+	// Still failing on the next try, then the part answers again
+	CHECK(fixlog_append(&log, &rec) == FIXLOG_ERR_IO);
+	CHECK(fixlog_append(&log, &rec) == FIXLOG_OK);
+	CHECK(log.seq == 1 && log.page_count == 1);
+
+	CHECK(fixlog_sync(&log) == FIXLOG_OK);
+	CHECK(check_records(&log, 0) == (uint32_t)page_count + 1);
+
+	// Page sent another way is dropped, the log goes on with a key record
+	make_record(++i, &rec);
+	fixlog_append(&log, &rec);
+	CHECK(fixlog_read_page(&log, recs, &n) == FIXLOG_OK && n == 1);
+
+	fixlog_drop_page(&log);
+	CHECK(fixlog_read_page(&log, recs, &n) == FIXLOG_EMPTY && n == 0);
+	CHECK(fixlog_sync(&log) == FIXLOG_OK && log.seq == 2);
+
+	make_record(++i, &rec);
+	CHECK(fixlog_append(&log, &rec) == FIXLOG_OK);
+	CHECK(fixlog_sync(&log) == FIXLOG_OK);
+	CHECK(fixlog_read(&log, 2, recs, &n) == FIXLOG_OK && n == 1 && same_record(&recs[0], &rec));
+}
+
+static void test_overflow(void) {
+	fixlog_t log;
+	fix_record_t rec;
+	uint32_t i;
+
+	device_erase();
+	fixlog_open(&log, &device);
+
+	// Nothing sent for more than a lap: the oldest pages go
+	for (i = 0; log.seq < DEVICE_PAGES + 10; i++) {
+		make_record(i, &rec);
+		fixlog_append(&log, &rec);
+	}
+
+	CHECK(log.stats.pages_lost == 10);
+	CHECK(fixlog_pending(&log) == DEVICE_PAGES);
+	CHECK(log.tail == 10);
+
+	// Pages sent before they were overwritten are acknowledged too late
+	fixlog_ack(&log, 4);
+	CHECK(log.tail == 10);
+}
+
+int main(void) {
+	test_round_trip();
+	test_recovery();
+	test_torn_pages();
+	test_write_failure();
+	test_overflow();
+
+	if (failures) {
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+
+	printf("OK\n");
+
+	return 0;
+}
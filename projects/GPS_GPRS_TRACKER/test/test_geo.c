@@ -0,0 +1,274 @@
+/*
+ * test_geo.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Accuracy of the integer geodesy against a double precision reference on
+ * the same sphere, and the cost per call. Distances are checked from 1 m to
+ * 20000 km at latitudes up to 85 degrees, plus the antimeridian and poles.
+ * Cycle counts are of the host TSC, on the target use the DWT counter.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "geo.h"
+#include "check.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC
+#endif
+
+#define EARTH_RADIUS_M		6371008.8
+#define PAIRS				200000
+#define BENCH_CALLS			2000000
+
+typedef uint32_t (*distance_fn_t)(const geo_point_t *a, const geo_point_t *b);
+
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t rng(void) {
+	rng_state = rng_state * 1664525 + 1013904223;
+
+	return rng_state;
+}
+
+// Uniform in [-range, range]
+static int32_t rng_range(int32_t range) {
+	return (int32_t)(((uint64_t)rng() * (2 * (uint64_t)range + 1)) >> 32) - range;
+}
+
+static double rad(int32_t udeg) {
+	return udeg / 1e6 * M_PI / 180.0;
+}
+
+static double ref_distance_cm(const geo_point_t *a, const geo_point_t *b) {
+	double s1 = sin((rad(b->latitude) - rad(a->latitude)) / 2);
+	double s2 = sin((rad(b->longitude) - rad(a->longitude)) / 2);
+	double h = s1 * s1 + cos(rad(a->latitude)) * cos(rad(b->latitude)) * s2 * s2;
+
+	return 2 * atan2(sqrt(h), sqrt(1 - h)) * EARTH_RADIUS_M * 100;
+}
+
+static double ref_bearing_cdeg(const geo_point_t *a, const geo_point_t *b) {
+	double dl = rad(b->longitude) - rad(a->longitude);
+	double y = sin(dl) * cos(rad(b->latitude));
+	double x = cos(rad(a->latitude)) * sin(rad(b->latitude)) - sin(rad(a->latitude)) * cos(rad(b->latitude)) * cos(dl);
+	double c = atan2(y, x) * 18000 / M_PI;
+
+	return c < 0 ? c + 36000 : c;
+}
+
+// Random second point about dist_m away in a random direction
+static void random_pair(geo_point_t *a, geo_point_t *b, double dist_m) {
+	double span = dist_m / (EARTH_RADIUS_M * M_PI / 180.0) * 1e6, heading = rng() / 4294967296.0 * 2 * M_PI;
+
+	a->latitude = rng_range(85 * GEO_UDEG_PER_DEGREE);
+	a->longitude = rng_range(GEO_LONGITUDE_MAX - 1);
+
+	b->latitude = a->latitude + (int32_t)(span * cos(heading));
+	b->longitude = a->longitude + (int32_t)(span * sin(heading) / cos(rad(a->latitude)));
+
+	geo_normalize(b);
+}
+
+typedef struct error_stats {
+	double max_rel;
+	double max_abs_cm;
+	double max_bearing_cdeg;
+} error_stats_t;
+
+static void measure(distance_fn_t fn, double dist_m, uint8_t bearing, error_stats_t *e) {
+	geo_point_t a, b;
+	double ref, err, diff;
+	int i;
+
+	memset(e, 0, sizeof(*e));
+
+	for (i = 0; i < PAIRS / 10; i++) {
+		random_pair(&a, &b, dist_m);
+		ref = ref_distance_cm(&a, &b);
+		err = fabs(fn(&a, &b) - ref);
+
+		if (err > e->max_abs_cm)
+			e->max_abs_cm = err;
+
+		if (ref > 0 && err / ref > e->max_rel)
+			e->max_rel = err / ref;
+
+		if (!bearing || ref < 1000)
+			continue;
+
+		diff = fabs(geo_bearing(&a, &b) - ref_bearing_cdeg(&a, &b));
+
+		if (diff > 18000)
+			diff = 36000 - diff;
+
+		if (diff > e->max_bearing_cdeg)
+			e->max_bearing_cdeg = diff;
+	}
+}
+
+static void test_accuracy(void) {
+	static const double scales_m[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 20000000};
+	error_stats_t fast, hav, mixed;
+	unsigned i;
+
+	printf("distance m   haversine: max err       fast: max err        geo_distance: max err, bearing\n");
+
+	for (i = 0; i < sizeof(scales_m) / sizeof(scales_m[0]); i++) {
+		measure(geo_distance_haversine, scales_m[i], 0, &hav);
+		measure(geo_distance_fast, scales_m[i], 0, &fast);
+		measure(geo_distance, scales_m[i], 1, &mixed);
+
+		printf("%10.0f   %8.0f cm %8.4f%%   %8.0f cm %8.4f%%   %8.0f cm %8.4f%% %6.2f deg\n", scales_m[i],
+				hav.max_abs_cm, hav.max_rel * 100, fast.max_abs_cm, fast.max_rel * 100,
+				mixed.max_abs_cm, mixed.max_rel * 100, mixed.max_bearing_cdeg / 100);
+
+		/*
+		 * Resolution of a microdegree is 11 cm, plus 0.01% of the distance.
+		 * Close to the antipode the haversine turns ill conditioned and the
+		 * 5e-6 error of the sine table grows to a few km.
+		 */
+		if (scales_m[i] < 20000000) {
+			CHECK(hav.max_abs_cm <= 30 + scales_m[i] * 100 * 1e-4);
+			CHECK(mixed.max_abs_cm <= 30 + scales_m[i] * 100 * 1e-3);
+		} else {
+			CHECK(hav.max_rel < 5e-3 && mixed.max_rel < 5e-3);
+		}
+
+		/*
+		 * Short spans get the planar bearing, at 85 degrees of latitude it
+		 * is off the initial great circle course by up to 0.15 degrees.
+		 */
+		if (scales_m[i] >= 10)
+			CHECK(mixed.max_bearing_cdeg <= (scales_m[i] >= 100 ? 20 : 100));
+	}
+}
+
+static void test_special(void) {
+	geo_point_t a, b;
+	double ref;
+
+	// Antimeridian, 0.2 degrees across at the equator is 22.2 km
+	a.latitude = 0; a.longitude = GEO_LONGITUDE_MAX - 100000;
+	b.latitude = 0; b.longitude = -GEO_LONGITUDE_MAX + 100000;
+	ref = ref_distance_cm(&a, &b);
+	CHECK(fabs(geo_distance(&a, &b) - ref) < 100);
+	CHECK(fabs(geo_distance_fast(&a, &b) - ref) < 100);
+	CHECK(geo_bearing(&a, &b) == 9000);
+	CHECK(geo_bearing(&b, &a) == 27000);
+
+	// Pole to pole and a quarter of the meridian
+	a.latitude = GEO_LATITUDE_MAX; a.longitude = 0;
+	b.latitude = -GEO_LATITUDE_MAX; b.longitude = 0;
+	CHECK(fabs(geo_distance(&a, &b) - EARTH_RADIUS_M * M_PI * 100) < 100);
+
+	a.latitude = 0;
+	CHECK(geo_bearing(&a, &b) == 18000);
+	CHECK(geo_bearing(&b, &a) == 0);
+	a.latitude = GEO_LATITUDE_MAX;
+
+	b.latitude = 0; b.longitude = 12345678;
+	CHECK(fabs(geo_distance(&a, &b) - EARTH_RADIUS_M * M_PI / 2 * 100) < 100);
+
+	// Antipodes on the equator
+	a.latitude = 0; a.longitude = 0;
+	b.latitude = 0; b.longitude = -GEO_LONGITUDE_MAX;
+	CHECK(fabs(geo_distance(&a, &b) - EARTH_RADIUS_M * M_PI * 100) < 100);
+
+	// Coincident points
+	b = a;
+	CHECK(geo_distance(&a, &b) == 0);
+	CHECK(geo_bearing(&a, &b) == 0);
+
+	// Normalization
+	a.latitude = GEO_LATITUDE_MAX + 5; a.longitude = GEO_LONGITUDE_MAX + 10;
+	geo_normalize(&a);
+	CHECK(a.latitude == GEO_LATITUDE_MAX && a.longitude == -GEO_LONGITUDE_MAX + 10);
+
+	// 53 deg 21.6802 min N, 6 deg 30.3372 min W
+	geo_from_minutes(53 * 600000 + 216802, -(6 * 600000 + 303372), &a);
+	CHECK(a.latitude == 53361337 && a.longitude == -6505620);
+
+	CHECK(geo_course_diff(35900, 100) == 200);
+	CHECK(geo_course_diff(100, 35900) == -200);
+	CHECK(geo_course_diff(0, 18000) == -18000);
+	CHECK(geo_course_diff(9000, 9000) == 0);
+
+	// 100 m in 10 s is 19.44 knots
+	CHECK(geo_speed(10000, 10000) == 1944);
+	CHECK(geo_speed(10000, 0) == 0);
+	CHECK(geo_speed(0xFFFFFFFF, 1) == 0xFFFF);
+
+	CHECK(geo_sin(0) == 0);
+	CHECK(geo_sin(0x40000000) == 1 << 30);
+	CHECK(geo_cos(0x80000000) == -(1 << 30));
+	CHECK(geo_atan2(1, 1) == 0x20000000);
+	CHECK(geo_atan2(-1, 0) == 0xC0000000);
+	CHECK(geo_atan2(0, -1) == 0x80000000);
+}
+
+static double now_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench(const char *name, distance_fn_t fn, double dist_m) {
+	static geo_point_t points[1024][2];
+	volatile uint32_t sink = 0;
+	double start, ns;
+	uint64_t cycles = 0;
+	int i;
+
+	for (i = 0; i < 1024; i++)
+		random_pair(&points[i][0], &points[i][1], dist_m);
+
+	start = now_ns();
+#if defined(HAVE_TSC)
+	cycles = __rdtsc();
+#endif
+
+	for (i = 0; i < BENCH_CALLS; i++)
+		sink += fn(&points[i & 1023][0], &points[i & 1023][1]);
+
+#if defined(HAVE_TSC)
+	cycles = __rdtsc() - cycles;
+#endif
+	ns = now_ns() - start;
+
+	printf("  %-20s %8.0f m %7.1f ns/call %7.1f TSC cycles/call\n", name, dist_m,
+			ns / BENCH_CALLS, (double)cycles / BENCH_CALLS);
+}
+
+static uint32_t bearing_as_distance(const geo_point_t *a, const geo_point_t *b) {
+	return geo_bearing(a, b);
+}
+
+int main(void) {
+	test_special();
+	test_accuracy();
+
+	printf("cost per call\n");
+	bench("geo_distance_fast", geo_distance_fast, 1000);
+	bench("geo_distance_haversine", geo_distance_haversine, 1000);
+	bench("geo_distance", geo_distance, 1000);
+	bench("geo_distance", geo_distance, 1000000);
+	bench("geo_bearing", bearing_as_distance, 1000);
+	bench("geo_bearing", bearing_as_distance, 1000000);
+
+	if (failures) {
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+
+	printf("OK\n");
+
+	return 0;
+}
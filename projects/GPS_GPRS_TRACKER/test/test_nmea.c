@@ -0,0 +1,219 @@
+/*
+ * test_nmea.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Epoch merging of nmea_merge() as gps_process_msg() runs it: sentences of
+ * one second go into one fix, late sentences without a time never open a
+ * fix of their own and nothing of one second leaks into the next.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "nmea.h"
+#include "check.h"
+
+#define EPOCH_MASK		(GPS_FIX_SENTENCE(GPS_MESSAGE_GPRMC) | GPS_FIX_SENTENCE(GPS_MESSAGE_GPGGA))
+
+// 12:00:00 UTC
+#define TOD				43200
+
+static uint8_t nmea_buf[256];
+static nmea_parser_t parser;
+static nmea_sentence_t sentence;
+static nmea_merge_t merge;
+
+static gps_fix_t fixes[8];
+static int fix_count;
+
+static void start(void) {
+	nmea_init(&parser, nmea_buf, sizeof(nmea_buf));
+	nmea_merge_init(&merge, EPOCH_MASK);
+	memset(fixes, 0, sizeof(fixes));
+	fix_count = 0;
+}
+
+/*
+ * Sends the sentence body through the tokenizer and the merge, returns
+ * the merge flags. Complete fixes are collected in fixes[].
+ */
+static uint8_t feed(const char *body, uint64_t timestamp_us) {
+	char line[128];
+	uint8_t chksum = 0, res = 0xFF;
+	gps_fix_t fix;
+	const char *p;
+	int i, len;
+
+	for (p = body; *p; p++)
+		chksum ^= (uint8_t)*p;
+
+	len = snprintf(line, sizeof(line), "$%s*%02X\r\n", body, chksum);
+
+	for (i = 0; i < len; i++) {
+		if (nmea_put(&parser, (uint8_t)line[i]) != NMEA_SENTENCE)
+			continue;
+
+		CHECK(nmea_index(&sentence, nmea_buf, parser.len) == NMEA_SENTENCE);
+
+		res = nmea_merge(&merge, &sentence, nmea_message_type(&sentence), timestamp_us, &fix);
+
+		if ((res & NMEA_MERGE_FIX) && fix_count < (int)(sizeof(fixes) / sizeof(fixes[0])))
+			fixes[fix_count++] = fix;
+	}
+
+	CHECK(res != 0xFF);
+
+	return res;
+}
+
+static uint8_t feed_gga(unsigned tod, uint64_t timestamp_us) {
+	char body[128];
+
+	snprintf(body, sizeof(body), "GPGGA,%02u%02u%02u.000,5545.3480,N,03737.0380,E,1,08,1.1,156.0,M,14.4,M,,0000",
+			tod / 3600, (tod / 60) % 60, tod % 60);
+
+	return feed(body, timestamp_us);
+}
+
+static uint8_t feed_rmc(unsigned tod, uint64_t timestamp_us) {
+	char body[128];
+
+	snprintf(body, sizeof(body), "GPRMC,%02u%02u%02u.000,A,5545.3480,N,03737.0380,E,12.50,45.00,161026,,,A",
+			tod / 3600, (tod / 60) % 60, tod % 60);
+
+	return feed(body, timestamp_us);
+}
+
+static uint8_t feed_gll(unsigned tod, uint64_t timestamp_us) {
+	char body[128];
+
+	snprintf(body, sizeof(body), "GPGLL,5545.3480,N,03737.0380,E,%02u%02u%02u.000,A,A",
+			tod / 3600, (tod / 60) % 60, tod % 60);
+
+	return feed(body, timestamp_us);
+}
+
+static uint8_t feed_gsa(void) {
+	return feed("GPGSA,A,3,01,02,03,04,05,,,,,,,,2.00,1.10,1.70", 0);
+}
+
+static uint8_t feed_gsv(void) {
+	return feed("GPGSV,3,1,10,01,40,083,46", 0);
+}
+
+static uint8_t feed_vtg(void) {
+	return feed("GPVTG,45.00,T,,M,12.50,N,23.15,K,A", 0);
+}
+
+static void test_epoch(void) {
+	start();
+
+	CHECK(feed_gga(TOD, 1000) == 0);
+	CHECK(feed_rmc(TOD, 2000) == NMEA_MERGE_FIX);
+
+	CHECK(fix_count == 1);
+	CHECK(fixes[0].epoch == TOD);
+	CHECK(fixes[0].sentences == EPOCH_MASK);
+	CHECK(fixes[0].timestamp_us == 1000);
+	CHECK(fixes[0].nav.speed == 1250);
+	CHECK(fixes[0].nav.course == 4500);
+	CHECK(fixes[0].nav.day == 16 && fixes[0].nav.month == 10 && fixes[0].nav.year == 26);
+	CHECK(!(fixes[0].nav.flags & GPS_DATA_INVALID));
+	CHECK(fixes[0].quality == 1 && fixes[0].satellites_used == 8 && fixes[0].hdop == 110);
+}
+
+static void test_timeless_attach(void) {
+	start();
+
+	// Order of the SiRF default output: GGA, GSA, GSV, RMC
+	CHECK(feed_gga(TOD, 1000) == 0);
+	CHECK(feed_gsa() == 0);
+	CHECK(feed_gsv() == 0);
+	CHECK(feed_rmc(TOD, 0) == NMEA_MERGE_FIX);
+
+	CHECK(fix_count == 1);
+	CHECK(fixes[0].pdop == 200 && fixes[0].vdop == 170);
+	CHECK(fixes[0].satellites_in_view == 10);
+	CHECK(fixes[0].sentences == (EPOCH_MASK | GPS_FIX_SENTENCE(GPS_MESSAGE_GPGSA) | GPS_FIX_SENTENCE(GPS_MESSAGE_GPGSV)));
+}
+
+static void test_trailing_dropped(void) {
+	start();
+
+	// Nothing to attach to before the first sentence with a time
+	CHECK(feed_gsa() == NMEA_MERGE_DROPPED);
+	CHECK(feed_vtg() == NMEA_MERGE_DROPPED);
+
+	CHECK(feed_rmc(TOD, 1000) == 0);
+	CHECK(feed_gga(TOD, 0) == NMEA_MERGE_FIX);
+
+	// Late sentences of the published epoch, with and without a time
+	CHECK(feed_vtg() == NMEA_MERGE_DROPPED);
+	CHECK(feed_gsa() == NMEA_MERGE_DROPPED);
+	CHECK(feed_gsv() == NMEA_MERGE_DROPPED);
+	CHECK(feed_gll(TOD, 0) == NMEA_MERGE_DROPPED);
+
+	CHECK(feed_gga(TOD + 1, 2000) == 0);
+	CHECK(feed_rmc(TOD + 1, 0) == NMEA_MERGE_FIX);
+
+	CHECK(fix_count == 2);
+	CHECK(fixes[1].epoch == TOD + 1);
+	CHECK(fixes[1].timestamp_us == 2000);
+	CHECK(fixes[1].sentences == EPOCH_MASK);
+	CHECK(fixes[1].pdop == 0 && fixes[1].satellites_in_view == 0);
+}
+
+static void test_no_leak(void) {
+	start();
+
+	CHECK(feed_gga(TOD, 1000) == 0);
+	CHECK(feed_rmc(TOD, 0) == NMEA_MERGE_FIX);
+
+	// RMC of this second lost to a checksum error
+	CHECK(feed_gga(TOD + 1, 2000) == 0);
+	CHECK(feed_gga(TOD + 2, 3000) == NMEA_MERGE_FIX);
+
+	CHECK(fix_count == 2);
+	CHECK(fixes[1].epoch == TOD + 1);
+	CHECK(fixes[1].sentences == GPS_FIX_SENTENCE(GPS_MESSAGE_GPGGA));
+	CHECK(fixes[1].timestamp_us == 2000);
+	CHECK(fixes[1].nav.speed == 0 && fixes[1].nav.course == 0);
+	CHECK(fixes[1].nav.day == 0 && fixes[1].nav.month == 0 && fixes[1].nav.year == 0);
+	CHECK(!(fixes[1].nav.flags & GPS_DATA_INVALID));
+	CHECK(fixes[1].nav.flags & LATITUDE_N);
+}
+
+static void test_parse_error(void) {
+	start();
+
+	CHECK(feed_gga(TOD, 1000) == 0);
+
+	// Next second starts with a broken RMC, the previous epoch still goes out
+	CHECK(feed("GPRMC,120001.000,A", 2000) == (NMEA_MERGE_FIX | NMEA_MERGE_ERR_PARSE));
+	CHECK(fix_count == 1);
+	CHECK(fixes[0].epoch == TOD);
+
+	CHECK(feed_gga(TOD + 1, 2000) == 0);
+	CHECK(feed_rmc(TOD + 1, 0) == NMEA_MERGE_FIX);
+	CHECK(fix_count == 2);
+	CHECK(fixes[1].epoch == TOD + 1);
+	CHECK(fixes[1].sentences == EPOCH_MASK);
+}
+
+int main(void) {
+	test_epoch();
+	test_timeless_attach();
+	test_trailing_dropped();
+	test_no_leak();
+	test_parse_error();
+
+	if (failures) {
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+
+	printf("OK\n");
+
+	return 0;
+}
@@ -0,0 +1,105 @@
+/*
+ * test_powermon.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Supply filter: block medians drop spikes, the IIR settles on steps and
+ * the thresholds switch once with hysteresis.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "powermon.h"
+#include "check.h"
+
+static uint16_t ext_raw(uint32_t mv) {
+	return mv * POWERMON_ADC_MAX / ((uint32_t)POWERMON_VDDA_MV * POWERMON_EXT_DIVIDER);
+}
+
+static uint16_t bat_raw(uint32_t mv) {
+	return mv * POWERMON_ADC_MAX / ((uint32_t)POWERMON_VDDA_MV * POWERMON_BAT_DIVIDER);
+}
+
+static void test_median(void) {
+	// Two channels interleaved the way the DMA writes them
+	const uint16_t samples[] = { 100, 7, 4000, 9, 102, 8, 101, 4095, 99, 6 };
+
+	CHECK(powermon_median(samples, 2, 5) == 101);
+	CHECK(powermon_median(samples + 1, 2, 5) == 8);
+	CHECK(powermon_median(samples, 2, 4) == 101);
+	CHECK(powermon_median(samples, 1, 1) == 100);
+	CHECK(powermon_median(samples, 1, 0) == 0);
+}
+
+static void test_settle(void) {
+	powermon_t pm;
+	uint8_t changed;
+	int i;
+
+	powermon_init(&pm);
+
+	changed = powermon_update(&pm, ext_raw(12000), bat_raw(4100), 1);
+	CHECK(changed == (POWERMON_EXT | POWERMON_CHARGING));
+	CHECK(abs(pm.ext_mv - 12000) < 15 && abs(pm.bat_mv - 4100) < 5);
+
+	// Supply cut: lost after a few blocks, reported once
+	for (i = 0, changed = 0; i < 20 && !(changed & POWERMON_EXT); i++)
+		changed = powermon_update(&pm, 0, bat_raw(4100), 0);
+
+	CHECK(!(pm.flags & POWERMON_EXT));
+	CHECK(i > 1 && i <= 6);
+	printf("external supply loss seen after %d blocks\n", i);
+
+	for (i = 0; i < 20; i++)
+		CHECK(powermon_update(&pm, 0, bat_raw(4100), 0) == 0);
+
+	CHECK(pm.ext_mv < 100);
+}
+
+static void test_hysteresis(void) {
+	powermon_t pm;
+	uint8_t changed;
+	int i, toggles = 0;
+
+	powermon_init(&pm);
+	powermon_update(&pm, ext_raw(12000), bat_raw(3600), 0);
+	CHECK(!(pm.flags & POWERMON_BAT_LOW));
+
+	// Battery sagging with noise around the low threshold: one switch only
+	for (i = 0; i < 200; i++) {
+		uint32_t mv = 3600 - i / 2 + (i & 1 ? 40 : -40);
+
+		changed = powermon_update(&pm, ext_raw(12000), bat_raw(mv), 0);
+		if (changed & POWERMON_BAT_LOW)
+			toggles++;
+	}
+
+	CHECK(toggles == 1 && (pm.flags & POWERMON_BAT_LOW));
+
+	// Back above the low threshold but below the good one: still low
+	for (i = 0; i < 20; i++)
+		powermon_update(&pm, ext_raw(12000), bat_raw((POWERMON_BAT_LOW_MV + POWERMON_BAT_OK_MV) / 2), 0);
+
+	CHECK(pm.flags & POWERMON_BAT_LOW);
+
+	for (i = 0; i < 20; i++)
+		powermon_update(&pm, ext_raw(12000), bat_raw(4000), 0);
+
+	CHECK(!(pm.flags & POWERMON_BAT_LOW));
+}
+
+int main(void) {
+	test_median();
+	test_settle();
+	test_hysteresis();
+
+	if (failures) {
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+
+	printf("OK\n");
+
+	return 0;
+}
@@ -0,0 +1,208 @@
+/*
+ * test_report.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Rules of the adaptive reporting policy, and what it does to a track:
+ * how many fixes are left and how far the dropped ones are from the line
+ * through the reported ones.
+ * Usage: test_report [track.nmea ...], without arguments a synthetic
+ * track is used.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "report.h"
+#include "track.h"
+#include "check.h"
+
+static const char *reason_names[REPORT_REASON_COUNT] = {
+	"skip", "first", "distance", "heading", "interval", "time jump"
+};
+
+// Fix at 2026-10-16 12:00:00 + t seconds, latitude 55 deg + north_e4min
+static void make_fix(gps_fix_t *fix, uint32_t t, uint32_t north_e4min, uint16_t speed, uint16_t course) {
+	memset(fix, 0, sizeof(*fix));
+
+	fix->nav.latitude_degrees = 55;
+	fix->nav.latitude_seconds = north_e4min;
+	fix->nav.longitude_degrees = 37;
+	fix->nav.flags = LATITUDE_N | LONGITUDE_E;
+	fix->nav.speed = speed;
+	fix->nav.course = course;
+	fix->nav.day = 16;
+	fix->nav.month = 10;
+	fix->nav.year = 26;
+	fix->nav.hour = 12 + t / 3600;
+	fix->nav.minute = t / 60 % 60;
+	fix->nav.second = t % 60;
+}
+
+static void test_rules(void) {
+	report_t r;
+	gps_fix_t fix;
+	const report_band_t *city;
+
+	report_init(&r, NULL);
+	city = report_band(&r, 1000);
+
+	CHECK(report_band(&r, 0) == &report_default_bands[0]);
+	CHECK(report_band(&r, 0xFFFF)->speed_max == 0xFFFF);
+
+	make_fix(&fix, 0, 0, 1000, 0);
+	CHECK(report_select(&r, &fix) == REPORT_FIRST);
+
+	// 1/10000 minute of latitude is 18.5 cm, 50 m north in 3 s
+	make_fix(&fix, 3, 270, 1000, 0);
+	CHECK(report_select(&r, &fix) == REPORT_SKIP);
+
+	// Distance is counted from the last reported fix, not the previous one
+	make_fix(&fix, 6, 600, 1000, 0);
+	CHECK(report_select(&r, &fix) == REPORT_DISTANCE);
+
+	// A turn just past the threshold, through north
+	make_fix(&fix, 9, 610, 1000, 36000 - city->heading_cdeg);
+	CHECK(report_select(&r, &fix) == REPORT_HEADING);
+
+	// Turns sooner than the minimum interval wait
+	make_fix(&fix, 9 + city->min_interval_s - 1, 620, 1000, 9000);
+	CHECK(report_select(&r, &fix) == REPORT_SKIP);
+
+	// Course of a slow fix is noise
+	make_fix(&fix, 20, 620, REPORT_HEADING_MIN_SPEED - 1, 18000);
+	CHECK(report_select(&r, &fix) == REPORT_SKIP);
+
+	make_fix(&fix, 9 + city->max_interval_s, 620, 1000, 36000 - city->heading_cdeg);
+	CHECK(report_select(&r, &fix) == REPORT_INTERVAL);
+
+	// Parked: position noise and course are ignored until the heartbeat
+	make_fix(&fix, 200, 900, 0, 9000);
+	CHECK(report_select(&r, &fix) == REPORT_SKIP);
+
+	make_fix(&fix, 9 + city->max_interval_s + report_default_bands[0].max_interval_s, 620, 0, 0);
+	CHECK(report_select(&r, &fix) == REPORT_INTERVAL);
+
+	make_fix(&fix, 10, 620, 0, 0);
+	CHECK(report_select(&r, &fix) == REPORT_TIME_JUMP);
+
+	CHECK(r.stats.fixes == 10);
+	CHECK(r.stats.reported == 6);
+	CHECK(r.stats.reasons[REPORT_SKIP] == 4);
+}
+
+static void to_xy(const gps_fix_t *fix, double lat0, double *x, double *y) {
+	geo_point_t p;
+
+	geo_from_nav(&fix->nav, &p);
+
+	*x = p.longitude / 1e6 * 111194.9 * cos(lat0 * M_PI / 180.0);
+	*y = p.latitude / 1e6 * 111194.9;
+}
+
+// Distance of p from the segment a-b, m
+static double segment_distance(double px, double py, double ax, double ay, double bx, double by) {
+	double dx = bx - ax, dy = by - ay, len2 = dx * dx + dy * dy, t = 0;
+
+	if (len2 > 0)
+		t = fmax(0, fmin(1, ((px - ax) * dx + (py - ay) * dy) / len2));
+
+	return hypot(px - ax - t * dx, py - ay - t * dy);
+}
+
+static void report_track(const char *name, const track_t *t, uint8_t synthetic) {
+	report_t r;
+	size_t i, j, last = 0, reported_parked = 0, usable = 0;
+	double lat0, ax, ay, bx, by, px, py, dev, max_dev = 0, sum_dev = 0;
+	uint8_t reason, k;
+
+	if (t->count == 0) {
+		printf("%s: no fixes\n", name);
+		return;
+	}
+
+	report_init(&r, NULL);
+	lat0 = t->fixes[0].nav.latitude_degrees;
+
+	for (i = 0; i < t->count; i++) {
+		if (t->fixes[i].nav.flags & GPS_DATA_INVALID)
+			continue;
+
+		usable++;
+
+		if ((reason = report_select(&r, &t->fixes[i])) == REPORT_SKIP)
+			continue;
+
+		// First 300 s of the synthetic track are parked
+		if (i < 300)
+			reported_parked++;
+
+		// Deviation of the skipped fixes from the line between the reported ones
+		to_xy(&t->fixes[last], lat0, &ax, &ay);
+		to_xy(&t->fixes[i], lat0, &bx, &by);
+
+		for (j = last + 1; j < i; j++) {
+			to_xy(&t->fixes[j], lat0, &px, &py);
+			dev = segment_distance(px, py, ax, ay, bx, by);
+			sum_dev += dev;
+
+			if (dev > max_dev)
+				max_dev = dev;
+		}
+
+		last = i;
+	}
+
+	printf("%s: %u usable fixes, %u reported (%.1f%%, %.1f:1)\n", name, (unsigned)usable,
+			(unsigned)r.stats.reported, 100.0 * r.stats.reported / usable,
+			(double)usable / r.stats.reported);
+
+	for (k = REPORT_FIRST; k < REPORT_REASON_COUNT; k++)
+		printf("  %-10s %6u\n", reason_names[k], (unsigned)r.stats.reasons[k]);
+
+	printf("  dropped fixes off the reported line: max %.1f m, mean %.1f m\n", max_dev,
+			usable > r.stats.reported ? sum_dev / (usable - r.stats.reported) : 0.0);
+
+	if (synthetic) {
+		CHECK(reported_parked <= 2);
+		CHECK(r.stats.reported * 5 < usable);
+		CHECK(max_dev < 50);
+	}
+}
+
+int main(int argc, char **argv) {
+	track_t t;
+	int i;
+
+	test_rules();
+
+	if (argc < 2) {
+		track_init(&t);
+		track_synthetic(&t, 1);
+		report_track("synthetic", &t, 1);
+		track_free(&t);
+	}
+
+	for (i = 1; i < argc; i++) {
+		track_init(&t);
+
+		if (track_load_nmea(&t, argv[i]) != 0) {
+			printf("FAIL cannot read %s\n", argv[i]);
+			failures++;
+			continue;
+		}
+
+		report_track(argv[i], &t, 0);
+		track_free(&t);
+	}
+
+	if (failures) {
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+
+	printf("OK\n");
+
+	return 0;
+}
@@ -0,0 +1,251 @@
+/*
+ * test_simplify.c
+ *
+ *  Created on: 16.10.2026
+ *
+ * Streaming track simplification on replayed tracks: point reduction,
+ * the largest distance of a dropped fix from the simplified track and
+ * the cost per fix. Runs the simplifier alone on every fix and behind
+ * the reporting policy as the uplink does.
+ * Usage: test_simplify [-t tolerance_m] [track.nmea ...], without files
+ * a synthetic track is used.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "simplify.h"
+#include "report.h"
+#include "track.h"
+#include "check.h"
+
+// Passes over the track for the timing
+#define BENCH_PASSES		200
+
+static double now_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void to_xy(const gps_fix_t *fix, double lat0, double *x, double *y) {
+	geo_point_t p;
+
+	geo_from_nav(&fix->nav, &p);
+
+	*x = p.longitude / 1e6 * 111194.9 * cos(lat0 * M_PI / 180.0);
+	*y = p.latitude / 1e6 * 111194.9;
+}
+
+// Distance of p from the segment a-b, m
+static double segment_distance(double px, double py, double ax, double ay, double bx, double by) {
+	double dx = bx - ax, dy = by - ay, len2 = dx * dx + dy * dy, t = 0;
+
+	if (len2 > 0)
+		t = fmax(0, fmin(1, ((px - ax) * dx + (py - ay) * dy) / len2));
+
+	return hypot(px - ax - t * dx, py - ay - t * dy);
+}
+
+/*
+ * Runs the usable fixes of the track through the simplifier, behind the
+ * reporting policy when with_report is set. Fills emitted[] with the
+ * indices of the fixes sent and returns their count.
+ */
+static size_t run(const track_t *t, uint16_t tolerance_m, uint8_t with_report, size_t *emitted, size_t *input) {
+	static simplify_t s;
+	report_t r;
+	gps_fix_t out[2];
+	size_t i, held = 0, count = 0;
+	uint32_t window_full;
+	uint8_t n, k, reason, force, current;
+
+	simplify_init(&s, tolerance_m);
+	report_init(&r, NULL);
+	*input = 0;
+
+	for (i = 0; i < t->count; i++) {
+		if (t->fixes[i].nav.flags & GPS_DATA_INVALID)
+			continue;
+
+		reason = REPORT_DISTANCE;
+
+		if (with_report && (reason = report_select(&r, &t->fixes[i])) == REPORT_SKIP)
+			continue;
+
+		(*input)++;
+
+		force = *input == 1 || (reason != REPORT_DISTANCE && reason != REPORT_HEADING);
+		window_full = s.stats.window_full;
+
+		n = simplify_push(&s, &t->fixes[i], force, out);
+
+		// The new fix comes out last and only when forced or the window filled up
+		current = force || s.stats.window_full != window_full;
+
+		for (k = 0; k < n; k++)
+			emitted[count++] = k == n - 1 && current ? i : held;
+
+		held = i;
+	}
+
+	if (simplify_flush(&s, out))
+		emitted[count++] = held;
+
+	return count;
+}
+
+// Largest distance of a usable fix from the polyline through the emitted ones, m
+static double max_deviation(const track_t *t, const size_t *emitted, size_t count) {
+	double lat0 = t->fixes[0].nav.latitude_degrees, ax, ay, bx, by, px, py, dev, max_dev = 0;
+	size_t k, j;
+
+	for (k = 1; k < count; k++) {
+		to_xy(&t->fixes[emitted[k - 1]], lat0, &ax, &ay);
+		to_xy(&t->fixes[emitted[k]], lat0, &bx, &by);
+
+		for (j = emitted[k - 1] + 1; j < emitted[k]; j++) {
+			if (t->fixes[j].nav.flags & GPS_DATA_INVALID)
+				continue;
+
+			to_xy(&t->fixes[j], lat0, &px, &py);
+			dev = segment_distance(px, py, ax, ay, bx, by);
+
+			if (dev > max_dev)
+				max_dev = dev;
+		}
+	}
+
+	return max_dev;
+}
+
+static void report_track(const char *name, const track_t *t, uint16_t tolerance_m, uint8_t synthetic) {
+	size_t *emitted, count, input, usable, pass;
+	double dev, start, ns;
+	uint8_t with_report;
+
+	if (t->count == 0) {
+		printf("%s: no fixes\n", name);
+		return;
+	}
+
+	if ((emitted = malloc(t->count * sizeof(*emitted))) == NULL)
+		return;
+
+	printf("%s: tolerance %u m\n", name, tolerance_m);
+
+	// Cost is per usable fix out of the ring, the reporting policy included
+	run(t, tolerance_m, 0, emitted, &usable);
+
+	for (with_report = 0; with_report < 2; with_report++) {
+		count = run(t, tolerance_m, with_report, emitted, &input);
+		dev = max_deviation(t, emitted, count);
+
+		start = now_ns();
+
+		for (pass = 0; pass < BENCH_PASSES; pass++)
+			run(t, tolerance_m, with_report, emitted, &input);
+
+		ns = (now_ns() - start) / BENCH_PASSES;
+
+		printf("  %-20s %6u in %6u out  %5.1f:1  max off track %5.1f m  %6.0f ns/fix\n",
+				with_report ? "report + simplify" : "simplify", (unsigned)input, (unsigned)count,
+				(double)input / count, dev, ns / usable);
+
+		// A little slack for the microdegree rounding
+		if (!with_report)
+			CHECK(dev <= tolerance_m + 0.5);
+
+		if (synthetic)
+			CHECK(count * 5 < input || with_report);
+	}
+
+	free(emitted);
+}
+
+static void test_straight(void) {
+	simplify_t s;
+	gps_fix_t fix, out[2];
+	uint32_t i, sent = 0;
+
+	memset(&fix, 0, sizeof(fix));
+	fix.nav.latitude_degrees = 55;
+	fix.nav.longitude_degrees = 37;
+	fix.nav.flags = LATITUDE_N | LONGITUDE_E;
+
+	simplify_init(&s, 10);
+
+	// 1000 fixes 18.5 m apart due north, only the window limits the run
+	for (i = 0; i < 1000; i++) {
+		fix.nav.latitude_seconds = i * 100;
+		sent += simplify_push(&s, &fix, i == 0, out);
+	}
+
+	CHECK(sent == 1 + 999 / SIMPLIFY_WINDOW);
+	CHECK(s.stats.window_full == 999 / SIMPLIFY_WINDOW);
+
+	// Held back fix comes out on flush and only once
+	CHECK(simplify_flush(&s, out) == 1 && out[0].nav.latitude_seconds == 99900);
+	CHECK(simplify_flush(&s, out) == 0);
+
+	// Sharp turn east: the corner is emitted before the new fix is held
+	fix.nav.longitude_seconds = 10000;
+	CHECK(simplify_push(&s, &fix, 0, out) == 0);
+	fix.nav.longitude_seconds = 20000;
+	CHECK(simplify_push(&s, &fix, 0, out) == 0);
+	fix.nav.latitude_seconds = 90000;
+	CHECK(simplify_push(&s, &fix, 0, out) == 1 && out[0].nav.longitude_seconds == 20000);
+
+	// Forced fix together with the held back one
+	fix.nav.longitude_seconds = 0;
+	CHECK(simplify_push(&s, &fix, 1, out) == 2 && out[0].nav.latitude_seconds == 90000 &&
+			out[1].nav.longitude_seconds == 0);
+}
+
+int main(int argc, char **argv) {
+	uint16_t tolerance_m = SIMPLIFY_TOLERANCE_M;
+	track_t t;
+	int i = 1;
+
+	if (argc > 2 && strcmp(argv[1], "-t") == 0) {
+		tolerance_m = atoi(argv[2]);
+		i = 3;
+	}
+
+	test_straight();
+
+	if (i >= argc) {
+		track_init(&t);
+		track_synthetic(&t, 1);
+		report_track("synthetic", &t, tolerance_m, 1);
+		report_track("synthetic", &t, tolerance_m * 3, 1);
+		track_free(&t);
+	}
+
+	for (; i < argc; i++) {
+		track_init(&t);
+
+		if (track_load_nmea(&t, argv[i]) != 0) {
+			printf("FAIL cannot read %s\n", argv[i]);
+			failures++;
+			continue;
+		}
+
+		report_track(argv[i], &t, tolerance_m, 0);
+		track_free(&t);
+	}
+
+	if (failures) {
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+
+	printf("OK\n");
+
+	return 0;
+}
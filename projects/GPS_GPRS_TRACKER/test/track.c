@@ -0,0 +1,207 @@
+/*
+ * track.c
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "track.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "nmea.h"
+
+#define EARTH_RADIUS_M		6371008.8
+#define MS_TO_KNOTS			1.943844
+
+static uint8_t nmea_buf[256];
+static nmea_parser_t parser;
+static nmea_sentence_t sentence;
+static nmea_merge_t merge;
+static gps_fix_t fix;
+
+void track_init(track_t *t) {
+	memset(t, 0, sizeof(*t));
+	nmea_merge_init(&merge, GPS_FIX_SENTENCE(GPS_MESSAGE_GPRMC) | GPS_FIX_SENTENCE(GPS_MESSAGE_GPGGA));
+	nmea_init(&parser, nmea_buf, sizeof(nmea_buf));
+}
+
+void track_free(track_t *t) {
+	free(t->fixes);
+	memset(t, 0, sizeof(*t));
+}
+
+static void track_push(track_t *t, const gps_fix_t *fix) {
+	if (t->count == t->capacity) {
+		t->capacity = t->capacity ? t->capacity * 2 : 1024;
+		t->fixes = realloc(t->fixes, t->capacity * sizeof(gps_fix_t));
+
+		if (t->fixes == NULL) {
+			fprintf(stderr, "track: out of memory\n");
+			exit(1);
+		}
+	}
+
+	t->fixes[t->count++] = *fix;
+}
+
+/*
+ * Epochs are merged by nmea_merge() as in gps_process_msg(). Only fixes
+ * with the RMC date are kept, the tests work on their timestamps.
+ */
+static void track_sentence(track_t *t) {
+	uint8_t type;
+
+	nmea_index(&sentence, nmea_buf, parser.len);
+	type = nmea_message_type(&sentence);
+
+	if (type == GPS_MESSAGE_UNKNOWN)
+		return;
+
+	if ((nmea_merge(&merge, &sentence, type, 0, &fix) & NMEA_MERGE_FIX) &&
+			(fix.sentences & GPS_FIX_SENTENCE(GPS_MESSAGE_GPRMC)))
+		track_push(t, &fix);
+}
+
+void track_feed(track_t *t, const char *text, size_t len) {
+	size_t i;
+
+	t->nmea_bytes += len;
+
+	for (i = 0; i < len; i++) {
+		if (nmea_put(&parser, (uint8_t)text[i]) == NMEA_SENTENCE) {
+			t->nmea_sentences++;
+			track_sentence(t);
+		}
+	}
+}
+
+int track_load_nmea(track_t *t, const char *path) {
+	char line[512];
+	FILE *f = fopen(path, "r");
+
+	if (f == NULL)
+		return -1;
+
+	while (fgets(line, sizeof(line), f) != NULL)
+		track_feed(t, line, strlen(line));
+
+	fclose(f);
+
+	return 0;
+}
+
+static void emit_sentence(track_t *t, const char *body) {
+	char line[192];
+	uint8_t chksum = 0;
+	const char *p;
+	int len;
+
+	for (p = body; *p; p++)
+		chksum ^= (uint8_t)*p;
+
+	len = snprintf(line, sizeof(line), "$%s*%02X\r\n", body, chksum);
+	track_feed(t, line, len);
+
+	if (t->nmea_out != NULL)
+		fwrite(line, 1, len, t->nmea_out);
+}
+
+static void format_coord(char *buf, size_t size, double value, int deg_digits) {
+	double abs_value = fabs(value);
+	int degrees = (int)abs_value;
+	double minutes = (abs_value - degrees) * 60.0;
+
+	// Avoid "60.0000" after rounding
+	if (minutes >= 59.99995) {
+		degrees++;
+		minutes = 0.0;
+	}
+
+	snprintf(buf, size, "%0*d%07.4f", deg_digits, degrees, minutes);
+}
+
+static double noise(unsigned *state) {
+	*state = *state * 1103515245u + 12345u;
+	return ((double)((*state >> 8) & 0xFFFF) / 65535.0) - 0.5;
+}
+
+/*
+ * About 40 minutes of driving at 1 Hz: parked, city blocks with right
+ * angle turns, a highway stretch with gentle curves and parked again.
+ * Receiver noise is added to speed and heading while moving.
+ */
+void track_synthetic(track_t *t, unsigned seed) {
+	static const struct {
+		unsigned duration;
+		double speed;
+		double turn_period;
+		double turn_rate;
+	} segments[] = {
+		{300, 0.0, 0, 0},
+		{600, 13.0, 45, 90.0 / 6},
+		{900, 30.0, 120, 0.4},
+		{300, 11.0, 30, 90.0 / 5},
+		{300, 0.0, 0, 0}
+	};
+
+	double lat = 55.7558, lon = 37.6173, heading = 45.0, speed = 0.0;
+	unsigned s, i, elapsed = 0, state = seed;
+	char body[160], lat_buf[32], lon_buf[32];
+
+	for (s = 0; s < sizeof(segments) / sizeof(segments[0]); s++) {
+		for (i = 0; i < segments[s].duration; i++, elapsed++) {
+			unsigned tod = 12 * 3600 + elapsed;
+			double target = segments[s].speed;
+			double course, knots;
+
+			// Smooth acceleration
+			if (speed < target)
+				speed = fmin(target, speed + 2.0);
+			else if (speed > target)
+				speed = fmax(target, speed - 3.0);
+
+			if (segments[s].turn_period > 0) {
+				unsigned phase = i % (unsigned)segments[s].turn_period;
+
+				if (segments[s].turn_rate > 5.0) {
+					if (phase < 6)
+						heading += segments[s].turn_rate * ((i / (unsigned)segments[s].turn_period) % 3 == 2 ? -1 : 1);
+				} else {
+					heading += segments[s].turn_rate * sin(elapsed / 60.0);
+				}
+			}
+
+			heading = fmod(heading + 360.0, 360.0);
+
+			if (speed > 0.0) {
+				double v = speed + noise(&state) * 0.6;
+				double h = heading + noise(&state) * 2.0;
+
+				lat += v * cos(h * M_PI / 180.0) / EARTH_RADIUS_M * 180.0 / M_PI;
+				lon += v * sin(h * M_PI / 180.0) / (EARTH_RADIUS_M * cos(lat * M_PI / 180.0)) * 180.0 / M_PI;
+
+				knots = v * MS_TO_KNOTS;
+				course = fmod(h + 360.0, 360.0);
+			} else {
+				knots = 0.0;
+				course = heading;
+			}
+
+			format_coord(lat_buf, sizeof(lat_buf), lat, 2);
+			format_coord(lon_buf, sizeof(lon_buf), lon, 3);
+
+			snprintf(body, sizeof(body), "GPGGA,%02u%02u%02u.000,%s,%c,%s,%c,1,08,1.1,156.%u,M,14.4,M,,0000",
+					tod / 3600, (tod / 60) % 60, tod % 60,
+					lat_buf, lat >= 0 ? 'N' : 'S', lon_buf, lon >= 0 ? 'E' : 'W', elapsed % 10);
+			emit_sentence(t, body);
+
+			snprintf(body, sizeof(body), "GPRMC,%02u%02u%02u.000,A,%s,%c,%s,%c,%.2f,%.2f,161026,,,A",
+					tod / 3600, (tod / 60) % 60, tod % 60,
+					lat_buf, lat >= 0 ? 'N' : 'S', lon_buf, lon >= 0 ? 'E' : 'W', knots, course);
+			emit_sentence(t, body);
+		}
+	}
+}
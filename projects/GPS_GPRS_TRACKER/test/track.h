@@ -0,0 +1,41 @@
+/*
+ * track.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef TRACK_H_
+#define TRACK_H_
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "gps_fix.h"
+
+/*
+ * Sequence of fixes for the host tests, either replayed from an NMEA log
+ * or generated. Both go through the same tokenizer and parsers as the
+ * firmware, nmea_bytes counts the NMEA text that produced the fixes.
+ */
+typedef struct track {
+	gps_fix_t *fixes;
+	size_t count;
+	size_t capacity;
+	size_t nmea_bytes;
+	size_t nmea_sentences;
+
+	// Generated NMEA text is also written here when set
+	FILE *nmea_out;
+} track_t;
+
+extern void track_init(track_t *t);
+
+extern void track_free(track_t *t);
+
+extern void track_feed(track_t *t, const char *text, size_t len);
+
+extern int track_load_nmea(track_t *t, const char *path);
+
+extern void track_synthetic(track_t *t, unsigned seed);
+
+#endif /* TRACK_H_ */
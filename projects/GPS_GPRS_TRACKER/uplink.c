@@ -0,0 +1,415 @@
+/*
+ * uplink.c
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "uplink.h"
+
+#include "gprs.h"
+#include "fixcodec.h"
+#include "report.h"
+#include "simplify.h"
+#include "geofence.h"
+#include "fixlog.h"
+#include "eeprom.h"
+
+#if EEPROM_PAGE_SIZE % FIXLOG_PAGE_SIZE != 0
+#error "FIXLOG_PAGE_SIZE must divide EEPROM_PAGE_SIZE"
+#endif
+
+static uint8_t batch[UPLINK_BATCH_BUF];
+static size_t batch_len;
+static uint8_t batch_fixes;
+static systime_t batch_started;
+
+static fix_codec_t batch_codec;
+
+// Batch waits for a working connection, no new fixes are taken meanwhile
+static uint8_t batch_sealed;
+
+static volatile uint8_t flush_requested;
+
+static fix_ring_reader_t fix_reader;
+
+static report_t fix_report;
+
+static simplify_t fix_simplify;
+
+static geofence_t fences;
+
+#if !defined(SIMULATOR)
+// Fence image region at the end of flash, see GPS_GPRS_TRACKER.ld
+extern const uint8_t __geofence_start__[];
+extern const uint8_t __geofence_end__[];
+#endif
+
+static uint8_t events[UPLINK_EVENT_BUF];
+static size_t events_len;
+static uint8_t event_count;
+static uint32_t events_dropped;
+
+static systime_t session_last_used;
+
+static const fixlog_device_t log_device = {
+	eeprom_read,
+	eeprom_write_page,
+	EEPROM_SIZE
+};
+
+// Fixes go through the log unless the EEPROM is missing
+static fixlog_t fix_log;
+static uint8_t log_ok;
+
+// Last page write failed, fixes go to the batch until one succeeds
+static uint8_t log_failing;
+
+// Fixes logged since the last batch was filled and when the first came
+static uint16_t log_fixes;
+static systime_t log_started;
+
+// Log pages up to here are in the batch
+static uint32_t batch_log_end;
+
+static fix_record_t log_records[FIXLOG_PAGE_RECORDS];
+
+static void batch_reset() {
+	batch_len = UPLINK_BATCH_HEADER;
+	batch_fixes = 0;
+	batch_sealed = FALSE;
+
+	fix_codec_init(&batch_codec);
+}
+
+static void events_reset() {
+	events_len = UPLINK_BATCH_HEADER;
+	event_count = 0;
+}
+
+void uplink_init() {
+	batch_reset();
+	events_reset();
+
+	flush_requested = FALSE;
+
+	// Fixes left unsent before a reset go out first
+	log_ok = eeprom_init() == EEPROM_OK && fixlog_open(&fix_log, &log_device) == FIXLOG_OK;
+	log_failing = FALSE;
+	log_fixes = 0;
+
+	if (fixlog_pending(&fix_log) > 0)
+		flush_requested = TRUE;
+
+	gps_fix_reader_init(&fix_reader);
+	report_init(&fix_report, NULL);
+	simplify_init(&fix_simplify, SIMPLIFY_TOLERANCE_M);
+
+#if !defined(SIMULATOR)
+	// An erased region or an image of another version leaves no fences
+	uplink_set_geofences(__geofence_start__, __geofence_end__ - __geofence_start__);
+#endif
+}
+
+static uint8_t batch_add_record(const fix_record_t *rec) {
+	// A sealed batch still has room for the second fix of a simplifier step
+	if (batch_len + FIX_CODEC_MAX_RECORD > sizeof(batch) || batch_fixes == 0xFF)
+		return FALSE;
+
+	if (batch_fixes == 0 && log_fixes == 0)
+		batch_started = chTimeNow();
+
+	batch_len += fix_codec_encode(&batch_codec, rec, batch + batch_len);
+	batch_fixes++;
+
+	// No room for two more worst case records
+	if (batch_len + 2 * FIX_CODEC_MAX_RECORD > sizeof(batch) || batch_fixes >= 0xFE)
+		batch_sealed = TRUE;
+
+	return TRUE;
+}
+
+/*
+ * Adds the records to the batch if they all fit, else leaves it as it was.
+ */
+static uint8_t batch_add_page(const fix_record_t *recs, uint8_t n) {
+	fix_codec_t codec = batch_codec;
+	size_t len = batch_len;
+	uint8_t fixes = batch_fixes, i;
+
+	for (i = 0; i < n && batch_add_record(&recs[i]); i++)
+		;
+
+	if (i < n) {
+		batch_codec = codec;
+		batch_len = len;
+		batch_fixes = fixes;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/*
+ * Fix to send, into the EEPROM log or straight into the batch without
+ * one or while a page write fails. Logged fixes reach the batch when it
+ * is filled before a flush.
+ */
+static void log_fix(const gps_fix_t *fix) {
+	fix_record_t rec;
+
+	fix_record_from_fix(fix, &rec);
+
+	if (log_ok) {
+		if (fixlog_append(&fix_log, &rec) == FIXLOG_OK) {
+			if (batch_fixes == 0 && log_fixes == 0)
+				batch_started = chTimeNow();
+
+			if (log_fixes == 0)
+				log_started = chTimeNow();
+
+			log_failing = FALSE;
+			log_fixes++;
+			return;
+		}
+
+		// The full page stays in the log and is written again with the next fix
+		log_failing = TRUE;
+	}
+
+	batch_add_record(&rec);
+}
+
+/*
+ * Moves the unsent log pages, oldest first, into the batch as long as
+ * they fit whole. The page being filled is written first so everything
+ * comes from the device and the fixes are acknowledged by page. When the
+ * device does not take it, its records follow the pages from RAM.
+ */
+static void batch_fill() {
+	uint8_t n, res;
+
+	if (log_ok)
+		log_failing = fixlog_sync(&fix_log) != FIXLOG_OK;
+
+	for (batch_log_end = fix_log.tail; ; batch_log_end++) {
+		res = fixlog_read(&fix_log, batch_log_end, log_records, &n);
+
+		// A broken page is skipped with the records before the damage
+		if (res == FIXLOG_EMPTY || res == FIXLOG_ERR_IO)
+			break;
+
+		// Page did not fit, it goes with the next batch
+		if (!batch_add_page(log_records, n))
+			break;
+	}
+
+	// Page the device did not take follows the written ones from RAM rather than wait for it
+	if (log_failing && res == FIXLOG_EMPTY && fixlog_read_page(&fix_log, log_records, &n) == FIXLOG_OK &&
+			batch_add_page(log_records, n))
+		fixlog_drop_page(&fix_log);
+
+	log_fixes = fix_log.page_count;
+}
+
+static void put_be(uint8_t *p, uint32_t value, uint8_t len) {
+	while (len-- > 0) {
+		p[len] = value & 0xFF;
+		value >>= 8;
+	}
+}
+
+/*
+ * Queues the enter and exit events of the fix for the next poll and gets
+ * the batch sent with them. Events are dropped while the frame is full
+ * and counted in the geofence stats.
+ */
+static uint8_t events_take(const gps_fix_t *fix) {
+	geofence_event_t found[GEOFENCE_MAX_INSIDE];
+	fix_record_t rec;
+	geo_point_t point;
+	uint8_t n, i;
+
+	geo_from_nav(&fix->nav, &point);
+
+	if ((n = geofence_check(&fences, &point, found, GEOFENCE_MAX_INSIDE)) == 0)
+		return 0;
+
+	fix_record_from_fix(fix, &rec);
+
+	for (i = 0; i < n && events_len + UPLINK_EVENT_SIZE <= sizeof(events); i++) {
+		put_be(events + events_len, found[i].id, 2);
+		events[events_len + 2] = found[i].type;
+		put_be(events + events_len + 3, rec.time, 4);
+		put_be(events + events_len + 7, (uint32_t)rec.latitude, 4);
+		put_be(events + events_len + 11, (uint32_t)rec.longitude, 4);
+
+		events_len += UPLINK_EVENT_SIZE;
+		event_count++;
+	}
+
+	events_dropped += n - i;
+
+	flush_requested = TRUE;
+
+	return n;
+}
+
+/*
+ * Usable fix through the geofences, the reporting policy and the track
+ * simplifier. Fixes the policy has to send (first one, heartbeat) and
+ * fixes with a fence event pass the simplifier as vertices.
+ */
+static void batch_take(const gps_fix_t *fix) {
+	gps_fix_t out[2];
+	uint8_t reason, force, n, i;
+
+	if (!gps_fix_is_usable(fix))
+		return;
+
+	force = events_take(fix) > 0;
+
+	if ((reason = report_select(&fix_report, fix)) == REPORT_SKIP && !force)
+		return;
+
+	if (reason != REPORT_SKIP && reason != REPORT_DISTANCE && reason != REPORT_HEADING)
+		force = TRUE;
+
+	n = simplify_push(&fix_simplify, fix, force, out);
+
+	for (i = 0; i < n; i++)
+		log_fix(&out[i]);
+}
+
+/*
+ * Sends whatever is queued on the next uplink_poll(), e.g. on ignition off.
+ */
+void uplink_request_flush() {
+	flush_requested = TRUE;
+}
+
+static uint8_t batch_should_flush() {
+	uint16_t queued = batch_fixes + log_fixes;
+
+	if (queued == 0 && fixlog_pending(&fix_log) == 0)
+		return FALSE;
+
+	if (batch_sealed || flush_requested || queued >= UPLINK_BATCH_FIXES)
+		return TRUE;
+
+	return queued > 0 && chTimeNow() - batch_started >= S2ST(UPLINK_MAX_AGE_S);
+}
+
+static uint8_t frame_send(uint8_t *frame, size_t len, uint8_t type, uint8_t count) {
+	uint16_t payload_len = len - UPLINK_BATCH_HEADER;
+
+	// No-op while the socket is open, backs off after failures
+	if (gprs_session_open() != E_OK)
+		return E_GPRS_CONNECT_ERROR;
+
+	frame[0] = UPLINK_BATCH_MAGIC_1;
+	frame[1] = type;
+	frame[2] = count;
+	frame[3] = payload_len >> 8;
+	frame[4] = payload_len & 0xFF;
+
+	// Socket is gone on failure, reconnect on the next attempt
+	if (gprs_session_send(frame, len) != E_OK)
+		return E_GPRS_CONNECT_ERROR;
+
+	session_last_used = chTimeNow();
+
+	return E_OK;
+}
+
+static uint8_t batch_send() {
+	return frame_send(batch, batch_len, UPLINK_BATCH_MAGIC_2, batch_fixes);
+}
+
+/*
+ * Replaces the fences with the image (see geofence.h), kept in place so
+ * it can live in flash. Call from the GPRS thread or before it starts.
+ */
+uint8_t uplink_set_geofences(const uint8_t *image, size_t len) {
+	return geofence_open(&fences, image, len);
+}
+
+void uplink_get_geofence_stats(geofence_stats_t *stats) {
+	chSysLock();
+	*stats = fences.stats;
+	stats->dropped = events_dropped;
+	chSysUnlock();
+}
+
+void uplink_get_fixlog_stats(fixlog_stats_t *stats) {
+	chSysLock();
+	*stats = fix_log.stats;
+	chSysUnlock();
+}
+
+void uplink_get_report_stats(report_stats_t *stats) {
+	chSysLock();
+	*stats = fix_report.stats;
+	chSysUnlock();
+}
+
+void uplink_get_simplify_stats(simplify_stats_t *stats) {
+	chSysLock();
+	*stats = fix_simplify.stats;
+	chSysUnlock();
+}
+
+/*
+ * Called periodically from the GPRS thread: moves new usable fixes the
+ * reporting policy and the simplifier select into the EEPROM log and
+ * sends them in a batch once enough are queued, the oldest is old enough
+ * or a flush was requested. A batch that could not be sent is kept and
+ * retried, the log takes the newer fixes meanwhile and drops its oldest
+ * pages only once full. Without the log, or while it fails to write,
+ * the fix ring buffers them.
+ */
+void uplink_poll() {
+	gps_fix_t fix;
+
+	// A page the device failed to take is tried again on every poll
+	if (log_ok && log_failing)
+		log_failing = fixlog_sync(&fix_log) != FIXLOG_OK;
+
+	// With the log fixes keep coming while a batch waits for the link
+	while (((log_ok && !log_failing) || !batch_sealed) && gps_fix_read(&fix_reader, &fix) == FIX_RING_OK)
+		batch_take(&fix);
+
+	// Events first, they are kept and retried the same way as a batch
+	if (event_count > 0 && frame_send(events, events_len, UPLINK_EVENT_MAGIC_2, event_count) == E_OK)
+		events_reset();
+
+	if (batch_should_flush()) {
+		// End the batch at the current position, not at the last vertex
+		if (!batch_sealed) {
+			if (simplify_flush(&fix_simplify, &fix))
+				log_fix(&fix);
+
+			batch_fill();
+			batch_sealed = TRUE;
+		}
+
+		// Only broken log pages were pending
+		if (batch_fixes == 0) {
+			fixlog_ack(&fix_log, batch_log_end);
+			batch_reset();
+		} else if (batch_send() == E_OK) {
+			fixlog_ack(&fix_log, batch_log_end);
+			batch_reset();
+
+			// Fixes logged while the batch waited start the age of the next one
+			batch_started = log_started;
+
+			// Backlog of a long outage goes out batch after batch
+			flush_requested = fixlog_pending(&fix_log) > 0;
+		} else {
+			batch_sealed = TRUE;
+		}
+	} else if (gprs_get_state() == GPRS_STATE_STREAMING &&
+			chTimeNow() - session_last_used >= S2ST(UPLINK_SESSION_IDLE_S)) {
+		gprs_session_close();
+	}
+}
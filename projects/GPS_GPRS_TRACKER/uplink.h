@@ -0,0 +1,79 @@
+/*
+ * uplink.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef UPLINK_H_
+#define UPLINK_H_
+
+#include "ch.h"
+#include "hal.h"
+
+#include "gps.h"
+#include "report.h"
+#include "simplify.h"
+#include "geofence.h"
+#include "fixlog.h"
+
+/*
+ * Batch layout on the wire:
+ *   'G' 'T' <fix count> <payload length, 2 bytes big endian> <payload>
+ * The payload is a fixcodec stream that starts with a key record, so every
+ * batch can be decoded on its own.
+ */
+#define UPLINK_BATCH_MAGIC_1	'G'
+#define UPLINK_BATCH_MAGIC_2	'T'
+#define UPLINK_BATCH_HEADER		5
+
+/*
+ * Geofence events go out before any batch in a frame of the same layout:
+ *   'G' 'E' <event count> <payload length> <events>
+ * Event: fence id (2 bytes), GEOFENCE_EVENT (1), then time (4), latitude
+ * (4) and longitude (4) of the fix in fix_record_t units, big endian.
+ */
+#define UPLINK_EVENT_MAGIC_2	'E'
+#define UPLINK_EVENT_SIZE		15
+
+// Event frame buffer size, header included
+#if !defined(UPLINK_EVENT_BUF)
+#define UPLINK_EVENT_BUF		(UPLINK_BATCH_HEADER + 8 * UPLINK_EVENT_SIZE)
+#endif
+
+// Batch buffer size, header included
+#if !defined(UPLINK_BATCH_BUF)
+#define UPLINK_BATCH_BUF		512
+#endif
+
+// Flush once this many fixes are queued
+#if !defined(UPLINK_BATCH_FIXES)
+#define UPLINK_BATCH_FIXES		60
+#endif
+
+// Flush when the oldest queued fix is this old, seconds
+#if !defined(UPLINK_MAX_AGE_S)
+#define UPLINK_MAX_AGE_S		300
+#endif
+
+// Idle session is closed after this long without a flush, seconds
+#if !defined(UPLINK_SESSION_IDLE_S)
+#define UPLINK_SESSION_IDLE_S	900
+#endif
+
+extern void uplink_init();
+
+extern void uplink_request_flush();
+
+extern void uplink_poll();
+
+extern void uplink_get_report_stats(report_stats_t *stats);
+
+extern void uplink_get_simplify_stats(simplify_stats_t *stats);
+
+extern uint8_t uplink_set_geofences(const uint8_t *image, size_t len);
+
+extern void uplink_get_geofence_stats(geofence_stats_t *stats);
+
+extern void uplink_get_fixlog_stats(fixlog_stats_t *stats);
+
+#endif /* UPLINK_H_ */